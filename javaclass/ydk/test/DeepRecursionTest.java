@@ -0,0 +1,13 @@
+package ydk.test;
+
+import ydk.lang.IO;
+
+public class DeepRecursionTest {
+    private static int depth(int n) {
+        return n == 0 ? 0 : depth(n - 1) + 1;
+    }
+
+    public static void main(String[] args) {
+        IO.print(depth(50000));
+    }
+}
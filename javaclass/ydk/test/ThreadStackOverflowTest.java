@@ -0,0 +1,21 @@
+package ydk.test;
+
+import ydk.lang.IO;
+import java.lang.Runnable;
+import java.lang.Thread;
+
+public class ThreadStackOverflowTest implements Runnable {
+    private static int depth(int n) {
+        return n == 0 ? 0 : depth(n - 1) + 1;
+    }
+
+    @Override
+    public void run() {
+        IO.print(depth(1000000));
+    }
+
+    public static void main(String[] args) {
+        new Thread(new ThreadStackOverflowTest()).start();
+        IO.print("main finished\n");
+    }
+}
@@ -595,12 +595,16 @@ struct FieldInfo {
 //--------------------------------------------------------------------------------
 // method info definition
 //--------------------------------------------------------------------------------
+class MethodData;
+
 struct MethodInfo {
     u2 accessFlags;
     u2 nameIndex;
     u2 descriptorIndex;
     u2 attributeCount;
     AttributeInfo** attributes;
+    // Runtime data of method, it's owned by JavaClass
+    MethodData* data = nullptr;
 
     ~MethodInfo() {
         FOR_EACH(i, attributeCount) { delete attributes[i]; }
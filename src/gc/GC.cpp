@@ -26,6 +26,7 @@
 #include <atomic>
 
 #include "../runtime/ClassSpace.h"
+#include "../runtime/ConstPoolCache.h"
 #include "../runtime/JavaClass.h"
 #include "../runtime/JavaHeap.hpp"
 #include "../runtime/JavaType.h"
@@ -75,6 +76,10 @@ void ConcurrentGC::gc(JavaFrame* frames, GCPolicy policy) {
         return;
     }
 
+    // The world is stopped, no object or array could be placed until sweeping
+    // finished
+    objectBitmap.assign(runtime.heap->objectContainer.capacity(), false);
+    arrayBitmap.assign(runtime.heap->arrayContainer.capacity(), false);
     switch (policy) {
         case GCPolicy::GC_MARK_AND_SWEEP:
             gcThreadPool.signalWork();
@@ -86,7 +91,9 @@ void ConcurrentGC::gc(JavaFrame* frames, GCPolicy policy) {
             break;
     }
     objectBitmap.clear();
+    objectBitmap.shrink_to_fit();
     arrayBitmap.clear();
+    arrayBitmap.shrink_to_fit();
     overMemoryThreshold = false;
     gcThreadPool.signalWait();
 }
@@ -98,25 +105,34 @@ void ConcurrentGC::mark(JType* ref) {
         return;
     }
     if (typeid(*ref) == typeid(JObject)) {
+        auto* object = static_cast<JObject*>(ref);
         {
             // Mark() is very quickly and busy, so we use lightweight spin lock
             // instead of stl mutex
             lock_guard<SpinLock> lock(objSpin);
-            objectBitmap.insert(dynamic_cast<JObject*>(ref)->offset);
+            if (!markBitmap(objectBitmap, object->offset)) {
+                return;
+            }
         }
-        auto fields = runtime.heap->getFields(dynamic_cast<JObject*>(ref));
-        for (size_t i = 0; i < fields.size(); i++) {
-            mark(fields[i]);
+        // Only reference fields are visited, their offsets are given by the
+        // reference map of object's class
+        for (uint32_t offset : object->jc->getReferenceMap()) {
+            mark(*reinterpret_cast<JType**>(object->fields() + offset));
         }
     } else if (typeid(*ref) == typeid(JArray)) {
         {
             lock_guard<SpinLock> lock(arrSpin);
-            arrayBitmap.insert(dynamic_cast<JArray*>(ref)->offset);
+            if (!markBitmap(arrayBitmap, dynamic_cast<JArray*>(ref)->offset)) {
+                return;
+            }
         }
-        auto items = runtime.heap->getElements(dynamic_cast<JArray*>(ref));
-
-        for (size_t i = 0; i < items.first; i++) {
-            mark(items.second[i]);
+        // Elements of primitive arrays are plain values and never visited
+        auto* array = static_cast<JArray*>(ref);
+        if (array->type == 'L') {
+            auto* items = array->elements<JType*>();
+            for (int i = 0; i < array->length; i++) {
+                mark(items[i]);
+            }
         }
     } else {
         SHOULD_NOT_REACH_HERE
@@ -124,47 +140,36 @@ void ConcurrentGC::mark(JType* ref) {
 }
 
 void ConcurrentGC::sweep() {
-    future<void> objectFuture = gcThreadPool.submit([this]() -> void {
-        for (auto pos = runtime.heap->objectContainer.data.begin();
-             pos != runtime.heap->objectContainer.data.end();) {
-            // If we can not find active object in object bitmap then clear it
-            // Notice that here we don't need to lock objectBitmap since it must
-            // be marked before sweeping
-            if (objectBitmap.find(pos->first) == objectBitmap.cend()) {
-                runtime.heap->objectContainer.data.erase(pos++);
-            } else {
-                ++pos;
-            }
-        }
-    });
-
+    // If we can not find active object in object bitmap then clear it. Notice
+    // that here we don't need to lock bitmaps since they must be marked before
+    // sweeping
     future<void> arrayFuture = gcThreadPool.submit([this]() -> void {
-        for (auto pos = runtime.heap->arrayContainer.data.begin();
-             pos != runtime.heap->arrayContainer.data.end();) {
-            // DITTO
-            if (arrayBitmap.find(pos->first) == arrayBitmap.cend()) {
-                for (size_t i = 0; i < pos->second.first; i++) {
-                    delete pos->second.second[i];
+        runtime.heap->arrayContainer.sweep(
+            [this](size_t offset, InternalArray& array) {
+                if (arrayBitmap[offset]) {
+                    return false;
                 }
-                delete[] pos->second.second;
-                runtime.heap->arrayContainer.data.erase(pos++);
-            } else {
-                ++pos;
-            }
-        }
+                ArrayContainer::destroy(array);
+                return true;
+            });
+    });
+    future<void> objectFuture = gcThreadPool.submit([this]() -> void {
+        runtime.heap->objectContainer.sweep(
+            [this](size_t offset, InternalObject& object) {
+                if (objectBitmap[offset]) {
+                    return false;
+                }
+                ObjectContainer::destroy(object);
+                return true;
+            });
     });
 
     future<void> monitorFuture = gcThreadPool.submit([this]() -> void {
-        // DITTO
-        for (auto pos = runtime.heap->monitorContainer.data.begin();
-             pos != runtime.heap->monitorContainer.data.end();) {
-            if (objectBitmap.find(pos->first) == objectBitmap.cend() ||
-                arrayBitmap.find(pos->first) == arrayBitmap.cend()) {
-                runtime.heap->monitorContainer.data.erase(pos++);
-            } else {
-                ++pos;
-            }
-        }
+        // Monitor of a swept object must go with it since the offset will be
+        // recycled by the next object
+        runtime.heap->monitorContainer.sweep([this](size_t offset) {
+            return offset >= objectBitmap.size() || !objectBitmap[offset];
+        });
     });
 
     objectFuture.get();
@@ -177,14 +182,18 @@ void ConcurrentGC::markAndSweep() {
     auto* temp = frames->top();
     while (temp != nullptr) {
         stackMarkFuture.push_back(gcThreadPool.submit([this, temp]() -> void {
-            for (int i = 0; i < temp->maxStack; i++) {
-                this->mark(temp->stackSlots[i]);
+            for (int i = 0; i < temp->stackTop; i++) {
+                if (temp->stackSlots[i].tag == ValueTag::Ref) {
+                    this->mark(temp->stackSlots[i].ref);
+                }
             }
         }));
 
         localMarkFuture.push_back(gcThreadPool.submit([this, temp]() -> void {
             for (int i = 0; i < temp->maxLocal; i++) {
-                this->mark(temp->localSlots[i]);
+                if (temp->localSlots[i].tag == ValueTag::Ref) {
+                    this->mark(temp->localSlots[i].ref);
+                }
             }
         }));
         temp = temp->next;
@@ -192,24 +201,28 @@ void ConcurrentGC::markAndSweep() {
 
     future<void> staticFieldsFuture = gcThreadPool.submit([this]() -> void {
         for (auto c : runtime.cs->classTable) {
-            for_each(c.second->staticVars.cbegin(), c.second->staticVars.cend(),
-                     [this](const pair<size_t, JType*>& offset) {
-                         if (typeid(*offset.second) == typeid(JObject)) {
-                             {
-                                 lock_guard<SpinLock> lock(objSpin);
-                                 objectBitmap.insert(offset.first);
-                             }
-                         } else if (typeid(*offset.second) == typeid(JArray)) {
-                             {
-                                 lock_guard<SpinLock> lock(arrSpin);
-                                 arrayBitmap.insert(offset.first);
-                             }
-                         }
-                     });
+            // Static fields are keyed by their slots, trace what they refer
+            for (const auto& staticVar : c.second->staticVars) {
+                this->mark(staticVar.second);
+            }
+        }
+    });
+
+    // String literals resolved by ldc are referred by constant pool caches
+    future<void> constantsFuture = gcThreadPool.submit([this]() -> void {
+        for (auto c : runtime.cs->classTable) {
+            const ConstPoolCache* cache = c.second->cpCache;
+            for (u2 i = 0; i < cache->constPoolCount; i++) {
+                const ResolvedEntry* entry = cache->lookup(i);
+                if (entry != nullptr && entry->value.tag == ValueTag::Ref) {
+                    this->mark(entry->value.ref);
+                }
+            }
         }
     });
 
     staticFieldsFuture.get();
+    constantsFuture.get();
 
     for (auto& sk : stackMarkFuture) {
         sk.get();
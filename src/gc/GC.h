@@ -25,7 +25,7 @@
 #define _YVM_GC_H
 
 #include <memory>
-#include <unordered_set>
+#include <vector>
 #include "Concurrent.hpp"
 #include "../misc/Option.h"
 #include "../runtime/RuntimeEnv.h"
@@ -52,15 +52,23 @@ public:
     void terminateGC() { gcThreadPool.finalize(); }
 
 private:
-    inline void pushObjectBitmap(size_t offset) { objectBitmap.insert(offset); }
+    // Heap offsets are dense slot indices, so mark bits are indexed by them
+    // directly. Return false if it has already been marked
+    static bool markBitmap(vector<bool>& bitmap, size_t offset) {
+        if (bitmap[offset]) {
+            return false;
+        }
+        bitmap[offset] = true;
+        return true;
+    }
 
     void markAndSweep();
     void mark(JType* ref);
     void sweep();
-    unordered_set<size_t> objectBitmap;
+    vector<bool> objectBitmap;
     SpinLock objSpin;
 
-    unordered_set<size_t> arrayBitmap;
+    vector<bool> arrayBitmap;
     SpinLock arrSpin;
     atomic_bool overMemoryThreshold;
     mutex overMemoryThresholdMtx;
@@ -90,40 +98,4 @@ private:
     GCThreadPool gcThreadPool;
 };
 
-class GC;
-template <class T>
-struct HeapAllocator {
-    typedef T value_type;
-    HeapAllocator() = default;
-    HeapAllocator(const HeapAllocator& rhs) {
-        this->thresholdVal = rhs.thresholdVal;
-    }
-    HeapAllocator& operator=(const HeapAllocator& rhs) {
-        this->thresholdVal = rhs.thresholdVal;
-        return *this;
-    }
-
-    template <class U>
-    constexpr HeapAllocator(const HeapAllocator<U>&) noexcept {}
-    T* allocate(size_t n) {
-        if (n > size_t(-1) / sizeof(T)) throw bad_alloc();
-        if (auto p = static_cast<T*>(malloc(n * sizeof(T)))) {
-            thresholdVal += n * sizeof(T);
-            if (thresholdVal >= YVM_GC_THRESHOLD_VALUE) {
-                runtime.gc->notifyGC();
-                thresholdVal = 0;
-            }
-            return p;
-        }
-        throw bad_alloc();
-    }
-    void deallocate(T* p, size_t val) noexcept {
-        free(p);
-        thresholdVal -= val;
-    }
-
-private:
-    size_t thresholdVal = 0;
-};
-
 #endif
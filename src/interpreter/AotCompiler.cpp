@@ -0,0 +1,251 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "AotCompiler.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/MethodData.h"
+#include "AotRuntime.h"
+#include "RegisterCode.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+// C++ string literal of a constant pool string. Everything but printable
+// ASCII is escaped, so is ? which may start a trigraph
+static std::string quoted(const std::string& str) {
+    std::ostringstream literal;
+    literal << '"';
+    for (unsigned char c : str) {
+        if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\' || c == '?') {
+            literal << '\\' << static_cast<char>('0' + ((c >> 6) & 7))
+                    << static_cast<char>('0' + ((c >> 3) & 7))
+                    << static_cast<char>('0' + (c & 7));
+        } else {
+            literal << c;
+        }
+    }
+    literal << '"';
+    return literal.str();
+}
+
+AotCompiler::AotCompiler(std::ostream& out) : out(out) {
+    out << "// Generated by yvmc, do not edit\n";
+    out << "#include \"interpreter/AotRuntime.h\"\n";
+}
+
+int AotCompiler::compileClassFile(const std::string& path) {
+    if (!std::ifstream(path, std::ios::binary).is_open()) {
+        return -1;
+    }
+    JavaClass jc(path);
+    jc.parseClassFile();
+    const std::string className = jc.getClassName();
+
+    int compiled = 0;
+    FOR_EACH(i, jc.raw.methodsCount) {
+        const MethodInfo& method = jc.raw.methods[i];
+        const MethodData* data = method.data;
+        if (data->getCode() == nullptr) {
+            continue;
+        }
+        std::unique_ptr<RegisterCode> registerCode(
+            RegisterCode::translate(&jc, data));
+        if (registerCode == nullptr) {
+            continue;
+        }
+        emitMethod(className, jc.getUtf8(method.nameIndex),
+                   jc.getUtf8(method.descriptorIndex), data, *registerCode);
+        compiled++;
+    }
+    return compiled;
+}
+
+void AotCompiler::emitMethod(const std::string& className, const char* name,
+                             const char* descriptor, const MethodData* data,
+                             const RegisterCode& registerCode) {
+    const int id = methodCount++;
+    const RegisterInstruction* instructions = registerCode.getInstructions();
+    out << "\n// " << quoted(className + "." + name + descriptor) << "\n";
+
+    out << "static const RegisterInstruction instructions" << id << "[] = {\n";
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        const RegisterInstruction& instruction = instructions[i];
+        out << "    {" << static_cast<int>(instruction.opcode) << ", "
+            << instruction.index << ", " << instruction.depth << ", "
+            << instruction.dst << ", " << instruction.a << ", "
+            << instruction.b << ", " << instruction.target << "},\n";
+    }
+    out << "};\n";
+
+    std::string constants = "nullptr";
+    if (registerCode.getConstantCount() != 0) {
+        constants = "constants" + std::to_string(id);
+        out << "static const AotConstant " << constants << "[] = {\n";
+        for (size_t i = 0; i < registerCode.getConstantCount(); i++) {
+            const JValue& constant = registerCode.getConstants()[i];
+            out << "    {"
+                << (constant.tag == ValueTag::Ref ? "ValueTag::Ref"
+                                                  : "ValueTag::Int")
+                << ", " << (constant.tag == ValueTag::Ref ? 0 : constant.i)
+                << "},\n";
+        }
+        out << "};\n";
+    }
+
+    std::string inlineCachePcs = "nullptr";
+    if (registerCode.getInlineCacheCount() != 0) {
+        inlineCachePcs = "inlineCachePcs" + std::to_string(id);
+        out << "static const u4 " << inlineCachePcs << "[] = {";
+        for (size_t i = 0; i < registerCode.getInlineCacheCount(); i++) {
+            out << (i == 0 ? "" : ", ")
+                << registerCode.getInlineCache(static_cast<int32_t>(i))->pc;
+        }
+        out << "};\n";
+    }
+
+    // Only branch targets and instructions after calls are labeled, the
+    // function is entered at the latter again once callee returned
+    std::vector<bool> labeled(registerCode.size(), false);
+    std::vector<size_t> reentries;
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        const u1 opcode = instructions[i].opcode;
+        if (opcode >= reg_ifeq && opcode <= reg_goto) {
+            labeled[instructions[i].target] = true;
+        } else if ((opcode >= reg_invokestatic &&
+                    opcode <= reg_invokevirtual) ||
+                   (opcode >= reg_resolve_invokestatic &&
+                    opcode <= reg_resolve_invokevirtual)) {
+            labeled[i + 1] = true;
+            reentries.push_back(i + 1);
+        }
+    }
+    out << "static int method" << id << "(JValue* r, JitContext* context) {\n";
+    if (!reentries.empty()) {
+        out << "    switch (context->entry) {\n";
+        for (size_t i : reentries) {
+            out << "        case " << i << ": goto L" << i << ";\n";
+        }
+        out << "    }\n";
+    }
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        if (labeled[i]) {
+            out << "L" << i << ":\n";
+        }
+        emitStatement(registerCode, i);
+    }
+    out << "}\n";
+
+    std::ostringstream entry;
+    entry << "    {" << quoted(className) << ", " << quoted(name) << ", "
+          << quoted(descriptor) << ", " << data->getCodeLength() << "u, "
+          << aotCodeHash(data->getOriginalCode(), data->getCodeLength())
+          << "u, method" << id << ", instructions" << id << ", "
+          << registerCode.size() << ", " << constants << ", "
+          << registerCode.getConstantCount() << ", " << inlineCachePcs << ", "
+          << registerCode.getInlineCacheCount() << "},\n";
+    table.push_back(entry.str());
+}
+
+std::string AotCompiler::valueOf(const RegisterCode& registerCode,
+                                 int16_t x) const {
+    if (x >= 0) {
+        return "r[" + std::to_string(x) + "]";
+    }
+    const JValue& constant = registerCode.getConstants()[-x - 1];
+    return constant.tag == ValueTag::Ref
+               ? "JValue::of<JRef>(nullptr)"
+               : "JValue::of<JInt>(" + std::to_string(constant.i) + ")";
+}
+
+std::string AotCompiler::intOf(const RegisterCode& registerCode,
+                               int16_t x) const {
+    return x >= 0 ? "r[" + std::to_string(x) + "].i"
+                  : std::to_string(registerCode.getConstants()[-x - 1].i);
+}
+
+std::string AotCompiler::refOf(const RegisterCode& registerCode,
+                               int16_t x) const {
+    return x >= 0 ? "r[" + std::to_string(x) + "].ref" : "nullptr";
+}
+
+void AotCompiler::emitStatement(const RegisterCode& registerCode, size_t i) {
+    static const char* const arithmetic[] = {"aotAdd", "aotSub", "aotMul"};
+    static const char* const operators[] = {"/", "%", "&", "|", "^"};
+    static const char* const compares[] = {"==", "!=", "<", ">=", ">", "<="};
+
+    const RegisterInstruction& instruction = registerCode.getInstructions()[i];
+    const u1 opcode = instruction.opcode;
+    const std::string dst = "r[" + std::to_string(instruction.dst) + "]";
+    const std::string jump = " goto L" + std::to_string(instruction.target);
+    out << "    ";
+    if (opcode == reg_move) {
+        out << dst << " = " << valueOf(registerCode, instruction.a) << ";\n";
+    } else if (opcode >= reg_iadd && opcode <= reg_imul) {
+        out << dst << " = JValue::of<JInt>(" << arithmetic[opcode - reg_iadd]
+            << "(" << intOf(registerCode, instruction.a) << ", "
+            << intOf(registerCode, instruction.b) << "));\n";
+    } else if (opcode >= reg_idiv && opcode <= reg_ixor) {
+        out << dst << " = JValue::of<JInt>("
+            << intOf(registerCode, instruction.a) << " "
+            << operators[opcode - reg_idiv] << " "
+            << intOf(registerCode, instruction.b) << ");\n";
+    } else if (opcode == reg_ineg) {
+        out << dst << " = JValue::of<JInt>(aotNeg("
+            << intOf(registerCode, instruction.a) << "));\n";
+    } else if (opcode >= reg_ifeq && opcode <= reg_ifle) {
+        out << "if (" << intOf(registerCode, instruction.a) << " "
+            << compares[opcode - reg_ifeq] << " 0)" << jump << ";\n";
+    } else if (opcode >= reg_if_icmpeq && opcode <= reg_if_icmple) {
+        out << "if (" << intOf(registerCode, instruction.a) << " "
+            << compares[opcode - reg_if_icmpeq] << " "
+            << intOf(registerCode, instruction.b) << ")" << jump << ";\n";
+    } else if (opcode == reg_if_acmpeq || opcode == reg_if_acmpne) {
+        out << "if (" << (opcode == reg_if_acmpne ? "!" : "")
+            << "isSameReference(" << refOf(registerCode, instruction.a) << ", "
+            << refOf(registerCode, instruction.b) << "))" << jump << ";\n";
+    } else if (opcode == reg_ifnull || opcode == reg_ifnonnull) {
+        out << "if (" << refOf(registerCode, instruction.a)
+            << (opcode == reg_ifnull ? " == " : " != ") << "nullptr)" << jump
+            << ";\n";
+    } else if (opcode == reg_goto) {
+        out << jump.substr(1) << ";\n";
+    } else if (opcode == reg_return) {
+        out << "context->result = " << valueOf(registerCode, instruction.a)
+            << ";\n    return JIT_OK;\n";
+    } else if (opcode == reg_return_void) {
+        out << "return JIT_OK;\n";
+    } else {
+        out << "if (int status = aotCall(context, " << i
+            << ")) return status;\n";
+    }
+}
+
+void AotCompiler::finish() {
+    out << "\nextern \"C\" const AotMethod " << YVM_AOT_METHODS << "[] = {\n";
+    for (const std::string& entry : table) {
+        out << entry;
+    }
+    out << "    {nullptr, nullptr, nullptr, 0, 0, nullptr, nullptr, 0, "
+           "nullptr, 0, nullptr, 0}};\n";
+}
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_AOTCOMPILER_H
+#define YVM_AOTCOMPILER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class JavaClass;
+class MethodData;
+class RegisterCode;
+
+//--------------------------------------------------------------------------------
+// AotCompiler emits C++ source for methods of class files ahead of time. A
+// method is translated into register code exactly as the interpreter would,
+// and every register instruction becomes a C++ statement: int arithmetic,
+// compares and branches are inlined, everything else calls the runtime like
+// JIT compiled code does. Methods that can not be translated are left out and
+// keep being interpreted. The generated source is built into a shared object
+// which yvm loads with --aot
+//--------------------------------------------------------------------------------
+class AotCompiler {
+public:
+    explicit AotCompiler(std::ostream& out);
+
+    // Compile methods of a class file, return how many of them are compiled
+    // or -1 if it can not be read
+    int compileClassFile(const std::string& path);
+    // Emit table of compiled methods, it must be called once at last
+    void finish();
+
+    int getMethodCount() const { return methodCount; }
+
+private:
+    void emitMethod(const std::string& className, const char* name,
+                    const char* descriptor, const MethodData* data,
+                    const RegisterCode& registerCode);
+    void emitStatement(const RegisterCode& registerCode, size_t i);
+
+    std::string valueOf(const RegisterCode& registerCode, int16_t x) const;
+    std::string intOf(const RegisterCode& registerCode, int16_t x) const;
+    std::string refOf(const RegisterCode& registerCode, int16_t x) const;
+
+private:
+    std::ostream& out;
+    // Initializers of AotMethod table
+    std::vector<std::string> table;
+    int methodCount = 0;
+};
+
+#endif  // YVM_AOTCOMPILER_H
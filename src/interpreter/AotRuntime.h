@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_AOTRUNTIME_H
+#define YVM_AOTRUNTIME_H
+
+#include <cstddef>
+#include <cstdint>
+#include "../misc/Utils.h"
+#include "../runtime/JavaType.h"
+#include "Interpreter.hpp"
+#include "JitCompiler.h"
+#include "RegisterCode.h"
+
+// Symbol of the AotMethod table exported by a library yvmc generated. The
+// table ends with an entry whose className is nullptr
+#define YVM_AOT_METHODS "yvmAotMethods"
+
+// Register code constant, only int and null constants are translated
+struct AotConstant {
+    ValueTag tag;
+    int32_t value;
+};
+
+//--------------------------------------------------------------------------------
+// AotMethod describes a method yvmc compiled into C++. It carries the register
+// code the function was generated from, runtime calls made by the function
+// still execute those register instructions. The hash of the bytecode
+// identifies the class file version it was compiled from
+//--------------------------------------------------------------------------------
+struct AotMethod {
+    const char* className;
+    const char* name;
+    const char* descriptor;
+    u4 codeLength;
+    u4 codeHash;
+    JitEntry entry;
+    const RegisterInstruction* instructions;
+    size_t instructionCount;
+    const AotConstant* constants;
+    size_t constantCount;
+    // pc of invokevirtual/invokeinterface that owns each inline cache
+    const u4* inlineCachePcs;
+    size_t inlineCacheCount;
+};
+
+// FNV-1a hash of bytecode
+inline u4 aotCodeHash(const u1* code, u4 codeLength) {
+    u4 hash = 2166136261u;
+    for (u4 i = 0; i < codeLength; i++) {
+        hash = (hash ^ code[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------------------------
+// Helpers called by generated code
+//--------------------------------------------------------------------------------
+// Execute register instruction i through the runtime, return a JitStatus
+inline int aotCall(JitContext* context, size_t i) {
+    return Interpreter::runtimeCallFromJit(
+        context, context->registerCode->getInstructions() + i);
+}
+
+// Java arithmetic wraps around on overflow
+inline int32_t aotAdd(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) +
+                                static_cast<uint32_t>(b));
+}
+
+inline int32_t aotSub(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) -
+                                static_cast<uint32_t>(b));
+}
+
+inline int32_t aotMul(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) *
+                                static_cast<uint32_t>(b));
+}
+
+inline int32_t aotNeg(int32_t a) {
+    return static_cast<int32_t>(0u - static_cast<uint32_t>(a));
+}
+
+#endif  // YVM_AOTRUNTIME_H
@@ -0,0 +1,515 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "BytecodeInliner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../classfile/AccessFlag.h"
+#include "../misc/Option.h"
+#include "../misc/Utils.h"
+#include "../runtime/ClassSpace.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/MethodData.h"
+#include "../runtime/RuntimeEnv.h"
+
+// Instructions that call, throw, synchronize, or jump in ways a body can
+// not be relocated with are never inlined
+static bool isInlinableOpcode(u1 opcode) {
+    switch (opcode) {
+        case op_jsr:
+        case op_ret:
+        case op_tableswitch:
+        case op_lookupswitch:
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+        case op_invokedynamic:
+        case op_athrow:
+        case op_monitorenter:
+        case op_monitorexit:
+        case op_wide:
+        case op_goto_w:
+        case op_jsr_w:
+            return false;
+        default:
+            return opcode < op_breakpoint;
+    }
+}
+
+static bool refersConstantPool(u1 opcode) {
+    switch (opcode) {
+        case op_ldc:
+        case op_ldc_w:
+        case op_ldc2_w:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_new:
+        case op_anewarray:
+        case op_checkcast:
+        case op_instanceof:
+        case op_multianewarray:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Branches with a 2 bytes offset
+static bool isBranch(u1 opcode) {
+    return (opcode >= op_ifeq && opcode <= op_jsr) || opcode == op_ifnull ||
+           opcode == op_ifnonnull;
+}
+
+// Kind of a load or store instruction, in the order of iload, lload, fload,
+// dload and aload
+static int localKindOf(int type) {
+    switch (type) {
+        case T_LONG:
+            return 1;
+        case T_FLOAT:
+            return 2;
+        case T_DOUBLE:
+            return 3;
+        case T_EXTRA_ARRAY:
+        case T_EXTRA_OBJECT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static int32_t readS4(const u1* code, u4 at) {
+    at--;
+    return static_cast<int32_t>(consumeU4(code, at));
+}
+
+// Whether className or one of its superclasses has a static initializer.
+// Classes that are not loaded yet are assumed to have one
+static bool hasClassInitializer(std::string className) {
+    while (!className.empty()) {
+        const JavaClass* jc = runtime.cs->findJavaClass(className);
+        if (jc == nullptr || jc->findMethod("<clinit>", "()V") != nullptr) {
+            return true;
+        }
+        className = jc->getSuperClassName();
+    }
+    return false;
+}
+
+static bool isSuperClassOf(const std::string& className, const JavaClass* jc) {
+    for (std::string name = jc->getSuperClassName(); !name.empty();) {
+        if (name == className) {
+            return true;
+        }
+        const JavaClass* superClass = runtime.cs->findJavaClass(name);
+        name = superClass != nullptr ? superClass->getSuperClassName() : "";
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------
+// Rewrite code of one caller. Instructions are copied into new code, and call
+// sites of inlinable callees are replaced with their bodies. Branch offsets
+// are patched once new pcs of their targets are known
+//--------------------------------------------------------------------------------
+class MethodInliner {
+public:
+    MethodInliner(const JavaClass* jc, const MethodInfo& method)
+        : jc(jc),
+          method(method),
+          data(method.data),
+          code(data->getOriginalCode()),
+          codeLength(data->getCodeLength()),
+          base(data->getMaxLocals()),
+          newPcs(data->getCodeLength() + 1) {}
+
+    void inlineCallees();
+
+private:
+    // Branch whose offset is patched when its target is known
+    struct Fixup {
+        size_t at;
+        u4 branchPc;
+        // pc of target in the code the branch was copied from
+        u4 target;
+        bool isWide;
+    };
+
+    const MethodInfo* findCallee(u4 pc, const JavaClass*& calleeClass) const;
+    bool canInline(const JavaClass* calleeClass, const MethodInfo* callee,
+                   bool sameClass) const;
+    bool inlineCallee(const MethodInfo* callee);
+    void copyInstruction(u4 pc);
+    void copyBranch(const u1* from, u4 pc, std::vector<Fixup>& fixups);
+    void copySwitch(u4 pc);
+    void emitLocal(bool isStore, int kind, int index);
+    void emitOffset(u4 branchPc, u4 target, bool isWide,
+                    std::vector<Fixup>& fixups);
+    bool patch(const std::vector<Fixup>& fixups,
+               const std::vector<u4>& targetPcs);
+
+private:
+    const JavaClass* jc;
+    const MethodInfo& method;
+    MethodData* data;
+    const u1* code;
+    const u4 codeLength;
+    // First local variable of inlined bodies
+    const int base;
+
+    std::vector<u1> out;
+    // New pc of each instruction of caller
+    std::vector<u4> newPcs;
+    std::vector<Fixup> fixups;
+    int maxLocals = 0;
+    int maxStack = 0;
+    std::vector<std::string> inlinedSites;
+};
+
+// Resolve the method a call site refers to if the call does not depend on
+// receiver class. Classes of callees are loaded but not linked
+const MethodInfo* MethodInliner::findCallee(
+    u4 pc, const JavaClass*& calleeClass) const {
+    const u1 opcode = code[pc];
+    if (opcode != op_invokestatic && opcode != op_invokespecial &&
+        opcode != op_invokevirtual) {
+        return nullptr;
+    }
+    const auto* mr = dynamic_cast<const CONSTANT_Methodref*>(
+        jc->getConstPoolItem((code[pc + 1] << 8) | code[pc + 2]));
+    if (mr == nullptr) {
+        return nullptr;
+    }
+    const auto* classItem = dynamic_cast<const CONSTANT_Class*>(
+        jc->getConstPoolItem(mr->classIndex));
+    const auto* nat = dynamic_cast<const CONSTANT_NameAndType*>(
+        jc->getConstPoolItem(mr->nameAndTypeIndex));
+    if (classItem == nullptr || nat == nullptr) {
+        return nullptr;
+    }
+    const std::string className = jc->getString(classItem->nameIndex);
+    const bool sameClass = className == jc->getClassName();
+    // Only static methods of other classes are inlined
+    if (!sameClass && (opcode != op_invokestatic || className[0] == '[')) {
+        return nullptr;
+    }
+    calleeClass = sameClass ? jc : runtime.cs->loadClassIfAbsent(className);
+    if (calleeClass == nullptr) {
+        return nullptr;
+    }
+    const MethodInfo* callee = calleeClass->findMethod(
+        jc->getString(nat->nameIndex), jc->getString(nat->descriptorIndex));
+    if (callee == nullptr ||
+        calleeClass->getUtf8(callee->nameIndex)[0] == '<') {
+        return nullptr;
+    }
+    const u2 flags = callee->accessFlags;
+    switch (opcode) {
+        case op_invokestatic:
+            if (!IS_METHOD_STATIC(flags)) {
+                return nullptr;
+            }
+            break;
+        case op_invokespecial:
+            if (IS_METHOD_STATIC(flags) || !IS_METHOD_PRIVATE(flags)) {
+                return nullptr;
+            }
+            break;
+        default:
+            if (IS_METHOD_STATIC(flags) ||
+                !(IS_METHOD_PRIVATE(flags) || IS_METHOD_FINAL(flags) ||
+                  IS_CLASS_FINAL(jc->getAccessFlag()))) {
+                return nullptr;
+            }
+    }
+    return canInline(calleeClass, callee, sameClass) ? callee : nullptr;
+}
+
+bool MethodInliner::canInline(const JavaClass* calleeClass,
+                              const MethodInfo* callee, bool sameClass) const {
+    const MethodData* calleeData = callee->data;
+    const u1* c = calleeData->getOriginalCode();
+    const u4 length = calleeData->getCodeLength();
+    if (IS_METHOD_NATIVE(callee->accessFlags) ||
+        IS_METHOD_SYNCHRONIZED(callee->accessFlags) || length == 0 ||
+        length > YVM_MAX_INLINE_SIZE ||
+        calleeData->getExceptionTableLength() != 0 ||
+        base + calleeData->getMaxLocals() > 256) {
+        return false;
+    }
+    // Invoking a static method of another class initializes it, which can
+    // only be skipped if that runs no code or has been done already
+    if (!sameClass && hasClassInitializer(calleeClass->getClassName()) &&
+        !isSuperClassOf(calleeClass->getClassName(), jc)) {
+        return false;
+    }
+    for (u4 pc = 0; pc < length; pc += instructionLength(c, pc)) {
+        if (!isInlinableOpcode(c[pc]) ||
+            (!sameClass && refersConstantPool(c[pc]))) {
+            return false;
+        }
+    }
+    if (IS_METHOD_STATIC(callee->accessFlags)) {
+        return true;
+    }
+    // Invocation checks receiver for null, so the body must dereference it
+    // before anything else happens: aload_0 followed by getfield, or by one
+    // pushed value and putfield
+    if (c[0] != op_aload_0 || length < 2) {
+        return false;
+    }
+    if (c[1] == op_getfield) {
+        return true;
+    }
+    const u4 next = 1 + instructionLength(c, 1);
+    return c[1] >= op_aconst_null && c[1] <= op_aload_3 && next < length &&
+           c[next] == op_putfield;
+}
+
+void MethodInliner::emitLocal(bool isStore, int kind, int index) {
+    if (index <= 3) {
+        const u1 shortForm = isStore ? op_istore_0 : op_iload_0;
+        out.push_back(static_cast<u1>(shortForm + kind * 4 + index));
+    } else {
+        out.push_back(static_cast<u1>((isStore ? op_istore : op_iload) + kind));
+        out.push_back(static_cast<u1>(index));
+    }
+}
+
+void MethodInliner::emitOffset(u4 branchPc, u4 target, bool isWide,
+                               std::vector<Fixup>& fixups) {
+    fixups.push_back(Fixup{out.size(), branchPc, target, isWide});
+    out.insert(out.end(), isWide ? 4 : 2, 0);
+}
+
+void MethodInliner::copyBranch(const u1* from, u4 pc,
+                               std::vector<Fixup>& fixups) {
+    const u4 branchPc = static_cast<u4>(out.size());
+    out.push_back(from[pc]);
+    const auto offset =
+        static_cast<int16_t>((from[pc + 1] << 8) | from[pc + 2]);
+    emitOffset(branchPc, pc + offset, false, fixups);
+}
+
+// Padding of a switch depends on its pc, so it's emitted again
+void MethodInliner::copySwitch(u4 pc) {
+    const u4 switchPc = static_cast<u4>(out.size());
+    out.push_back(code[pc]);
+    while (out.size() % 4 != 0) {
+        out.push_back(0);
+    }
+    u4 at = pc + (4 - pc % 4);
+    emitOffset(switchPc, pc + readS4(code, at), true, fixups);
+    at += 4;
+    int32_t count = 0;
+    int pairWidth = 0;
+    if (code[pc] == op_tableswitch) {
+        count = readS4(code, at + 4) - readS4(code, at) + 1;
+        out.insert(out.end(), code + at, code + at + 8);
+        at += 8;
+    } else {
+        count = readS4(code, at);
+        pairWidth = 4;
+        out.insert(out.end(), code + at, code + at + 4);
+        at += 4;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        // Match of lookupswitch pair
+        out.insert(out.end(), code + at, code + at + pairWidth);
+        at += pairWidth;
+        emitOffset(switchPc, pc + readS4(code, at), true, fixups);
+        at += 4;
+    }
+}
+
+void MethodInliner::copyInstruction(u4 pc) {
+    const u1 opcode = code[pc];
+    if (isBranch(opcode)) {
+        copyBranch(code, pc, fixups);
+    } else if (opcode == op_goto_w || opcode == op_jsr_w) {
+        const u4 branchPc = static_cast<u4>(out.size());
+        out.push_back(opcode);
+        emitOffset(branchPc, pc + readS4(code, pc + 1), true, fixups);
+    } else if (opcode == op_tableswitch || opcode == op_lookupswitch) {
+        copySwitch(pc);
+    } else {
+        out.insert(out.end(), code + pc,
+                   code + pc + instructionLength(code, pc));
+    }
+}
+
+// Emit body of callee in place of the call. Arguments are popped into local
+// variables from the last one, and local variable accesses of body are moved
+// up by base. Return false if a branch of body can not reach its target
+bool MethodInliner::inlineCallee(const MethodInfo* callee) {
+    const MethodData* calleeData = callee->data;
+    const u1* c = calleeData->getOriginalCode();
+    const u4 length = calleeData->getCodeLength();
+
+    const std::vector<int>& parameter = calleeData->getParameter();
+    int slot = calleeData->getArgumentSlots();
+    for (auto kind = parameter.rbegin(); kind != parameter.rend(); ++kind) {
+        slot -= (*kind == T_LONG || *kind == T_DOUBLE) ? 2 : 1;
+        emitLocal(true, localKindOf(*kind), base + slot);
+    }
+    if (!IS_METHOD_STATIC(callee->accessFlags)) {
+        emitLocal(true, localKindOf(T_EXTRA_OBJECT), base);
+    }
+
+    std::vector<u4> calleePcs(length + 1);
+    std::vector<Fixup> calleeFixups;
+    for (u4 pc = 0; pc < length; pc += instructionLength(c, pc)) {
+        calleePcs[pc] = static_cast<u4>(out.size());
+        const u1 opcode = c[pc];
+        if (opcode >= op_iload && opcode <= op_aload) {
+            emitLocal(false, opcode - op_iload, base + c[pc + 1]);
+        } else if (opcode >= op_iload_0 && opcode <= op_aload_3) {
+            emitLocal(false, (opcode - op_iload_0) / 4,
+                      base + (opcode - op_iload_0) % 4);
+        } else if (opcode >= op_istore && opcode <= op_astore) {
+            emitLocal(true, opcode - op_istore, base + c[pc + 1]);
+        } else if (opcode >= op_istore_0 && opcode <= op_astore_3) {
+            emitLocal(true, (opcode - op_istore_0) / 4,
+                      base + (opcode - op_istore_0) % 4);
+        } else if (opcode == op_iinc) {
+            out.push_back(op_iinc);
+            out.push_back(static_cast<u1>(base + c[pc + 1]));
+            out.push_back(c[pc + 2]);
+        } else if (opcode >= op_ireturn && opcode <= op_return) {
+            // Result is left on operand stack, the last return simply falls
+            // through to the instruction after the call
+            if (pc + 1 < length) {
+                const u4 branchPc = static_cast<u4>(out.size());
+                out.push_back(op_goto);
+                emitOffset(branchPc, length, false, calleeFixups);
+            }
+        } else if (isBranch(opcode)) {
+            copyBranch(c, pc, calleeFixups);
+        } else {
+            out.insert(out.end(), c + pc, c + pc + instructionLength(c, pc));
+        }
+    }
+    calleePcs[length] = static_cast<u4>(out.size());
+    return patch(calleeFixups, calleePcs);
+}
+
+bool MethodInliner::patch(const std::vector<Fixup>& fixups,
+                          const std::vector<u4>& targetPcs) {
+    for (const Fixup& fixup : fixups) {
+        const int64_t offset = static_cast<int64_t>(targetPcs[fixup.target]) -
+                               static_cast<int64_t>(fixup.branchPc);
+        if (fixup.isWide) {
+            const auto value = static_cast<u4>(offset);
+            for (int i = 0; i < 4; i++) {
+                out[fixup.at + i] = static_cast<u1>(value >> (24 - i * 8));
+            }
+        } else {
+            if (offset < INT16_MIN || offset > INT16_MAX) {
+                return false;
+            }
+            out[fixup.at] = static_cast<u1>(offset >> 8);
+            out[fixup.at + 1] = static_cast<u1>(offset);
+        }
+    }
+    return true;
+}
+
+void MethodInliner::inlineCallees() {
+    maxLocals = base;
+    maxStack = data->getMaxStack();
+    int growth = 0;
+    for (u4 pc = 0; pc < codeLength; pc += instructionLength(code, pc)) {
+        newPcs[pc] = static_cast<u4>(out.size());
+        const JavaClass* calleeClass = nullptr;
+        const MethodInfo* callee = findCallee(pc, calleeClass);
+        if (callee == nullptr) {
+            copyInstruction(pc);
+            continue;
+        }
+        const size_t start = out.size();
+        const int size = inlineCallee(callee)
+                             ? static_cast<int>(out.size() - start)
+                             : YVM_MAX_INLINE_GROWTH + 1;
+        if (growth + size - 3 > YVM_MAX_INLINE_GROWTH) {
+            out.resize(start);
+            copyInstruction(pc);
+            continue;
+        }
+        growth += size - 3;
+        // Values below the arguments stay on operand stack while the body runs
+        const MethodData* calleeData = callee->data;
+        maxLocals = std::max(maxLocals, base + calleeData->getMaxLocals());
+        maxStack = std::max(maxStack,
+                            data->getMaxStack() + calleeData->getMaxStack());
+        inlinedSites.push_back(std::to_string(pc) + " <- " +
+                               calleeClass->getClassName() + "." +
+                               calleeClass->getUtf8(callee->nameIndex) +
+                               calleeClass->getUtf8(callee->descriptorIndex) +
+                               " (" +
+                               std::to_string(calleeData->getCodeLength()) +
+                               " bytes)");
+    }
+    newPcs[codeLength] = static_cast<u4>(out.size());
+    // Exception tables hold pcs in u2
+    if (inlinedSites.empty() || out.size() > 0xffff || maxStack > 0xffff ||
+        !patch(fixups, newPcs)) {
+        return;
+    }
+
+    std::vector<ExceptionTable> exceptionTable;
+    FOR_EACH(i, data->getExceptionTableLength()) {
+        ExceptionTable e = data->getExceptionTable()[i];
+        e.startPC = static_cast<u2>(newPcs[e.startPC]);
+        e.endPC = static_cast<u2>(newPcs[e.endPC]);
+        e.handlerPC = static_cast<u2>(newPcs[e.handlerPC]);
+        exceptionTable.push_back(e);
+    }
+    data->installInlinedCode(std::move(out), static_cast<u2>(maxLocals),
+                             static_cast<u2>(maxStack),
+                             std::move(exceptionTable));
+
+    if (runtime.printInlining) {
+        for (const std::string& site : inlinedSites) {
+            std::cerr << "[inline] " << jc->getClassName() << "."
+                      << data->getName() << jc->getUtf8(method.descriptorIndex)
+                      << "@" << site << "\n";
+        }
+    }
+}
+
+void BytecodeInliner::inlineMethods(JavaClass* jc) {
+    FOR_EACH(i, jc->raw.methodsCount) {
+        const MethodInfo& method = jc->raw.methods[i];
+        // Methods bound to compiled code never run their bytecode
+        if (method.data->getCodeLength() != 0 &&
+            method.data->getRegisterCode() == nullptr) {
+            MethodInliner(jc, method).inlineCallees();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef YVM_BYTECODEINLINER_H
+#define YVM_BYTECODEINLINER_H
+
+class JavaClass;
+
+//--------------------------------------------------------------------------------
+// BytecodeInliner splices bodies of small callees into the private code of
+// their callers when a class is linked, so calling them pushes no frame.
+// Callees are static, private or final methods of the caller's class, and
+// static methods of other classes whose code does not refer to their
+// constant pool. Only leaf methods without exception handlers are inlined:
+// they neither call nor throw, so stack traces are not changed by inlining
+//
+// Arguments are stored into local variables above those of caller, which
+// are shared by all inlined bodies since they never nest, and returns jump
+// behind the body with the result left on operand stack. Branches and
+// exception ranges of caller are moved along with its instructions
+//--------------------------------------------------------------------------------
+class BytecodeInliner {
+public:
+    // Inline callees into methods of jc that still run as bytecode
+    static void inlineMethods(JavaClass* jc);
+};
+
+#endif  // YVM_BYTECODEINLINER_H
@@ -24,7 +24,9 @@
 #ifndef _CALLSITE_H
 #define _CALLSITE_H
 
-#include "../runtime/JavaClass.h"
+#include "../classfile/ClassFile.h"
+
+class JavaClass;
 
 struct CallSite {
     explicit CallSite();
@@ -34,7 +36,10 @@ struct CallSite {
     static CallSite makeCallSite(const JavaClass* jc, MethodInfo* m);
 
     const JavaClass* jc;
+    MethodInfo* method;
+    MethodData* data;
     u2 accessFlags;
+    // Private code copy of method, see MethodData
     u1* code;
     u4 codeLength;
     u2 maxStack;
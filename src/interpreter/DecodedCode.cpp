@@ -0,0 +1,168 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "DecodedCode.h"
+#include "../misc/Utils.h"
+
+SwitchTable::SwitchTable(u4 defaultTarget,
+                         std::vector<std::pair<int32_t, u4>> cases)
+    : defaultTarget(defaultTarget) {
+    std::sort(cases.begin(), cases.end());
+    if (cases.empty()) {
+        return;
+    }
+    low = cases.front().first;
+    const int64_t range = static_cast<int64_t>(cases.back().first) - low + 1;
+    // Gaps of a dense table jump to the default target, a table is dense as
+    // long as at most half of its entries are gaps
+    dense = range <= 2 * static_cast<int64_t>(cases.size());
+    if (dense) {
+        targets.assign(static_cast<size_t>(range), defaultTarget);
+        for (const auto& c : cases) {
+            targets[c.first - low] = c.second;
+        }
+        return;
+    }
+    for (const auto& c : cases) {
+        keys.push_back(c.first);
+        targets.push_back(c.second);
+    }
+}
+
+DecodedCode::DecodedCode(const u1* originalCode, const u1* code,
+                         u4 codeLength)
+    : indices(new u4[codeLength]()) {
+    for (u4 pc = 0; pc < codeLength;
+         pc += instructionLength(originalCode, pc)) {
+        indices[pc] = static_cast<u4>(instructions.size());
+        DecodedInstruction insn{};
+        insn.opcode = code[pc];
+        insn.originalOpcode = originalCode[pc];
+        insn.pc = pc;
+        instructions.push_back(insn);
+    }
+    // Branch targets are known once every instruction has its index
+    for (auto& insn : instructions) {
+        decodeOperands(originalCode, insn);
+    }
+}
+
+void DecodedCode::decodeOperands(const u1* code, DecodedInstruction& insn) {
+    const u4 pc = insn.pc;
+    const u1 opcode = code[pc];
+    u4 op = pc;
+    switch (opcode) {
+        case op_bipush:
+            insn.operand = static_cast<int8_t>(consumeU1(code, op));
+            break;
+        case op_sipush:
+            insn.operand = static_cast<int16_t>(consumeU2(code, op));
+            break;
+        case op_ldc:
+        case op_iload:
+        case op_lload:
+        case op_fload:
+        case op_dload:
+        case op_aload:
+        case op_istore:
+        case op_lstore:
+        case op_fstore:
+        case op_dstore:
+        case op_astore:
+        case op_ret:
+        case op_newarray:
+            insn.operand = consumeU1(code, op);
+            break;
+        case op_iinc:
+            insn.operand = consumeU1(code, op);
+            insn.operand2 = static_cast<int8_t>(consumeU1(code, op));
+            break;
+        case op_wide:
+            // The modified instruction takes a 2 bytes index, iinc takes a 2
+            // bytes increment as well
+            op++;
+            insn.operand = consumeU2(code, op);
+            if (code[pc + 1] == op_iinc) {
+                insn.operand2 = static_cast<int16_t>(consumeU2(code, op));
+            }
+            break;
+        case op_invokeinterface:
+        case op_invokedynamic:
+        case op_multianewarray:
+            insn.operand = consumeU2(code, op);
+            insn.operand2 = consumeU1(code, op);
+            break;
+        case op_goto_w:
+        case op_jsr_w:
+            insn.target =
+                indices[pc + static_cast<int32_t>(consumeU4(code, op))];
+            break;
+        case op_ifnull:
+        case op_ifnonnull:
+            insn.target =
+                indices[pc + static_cast<int16_t>(consumeU2(code, op))];
+            break;
+        case op_tableswitch:
+        case op_lookupswitch:
+            decodeSwitch(code, insn);
+            break;
+        default:
+            if (opcode >= op_iload_0 && opcode <= op_aload_3) {
+                insn.operand = (opcode - op_iload_0) % 4;
+            } else if (opcode >= op_istore_0 && opcode <= op_astore_3) {
+                insn.operand = (opcode - op_istore_0) % 4;
+            } else if (opcode >= op_ifeq && opcode <= op_jsr) {
+                insn.target =
+                    indices[pc + static_cast<int16_t>(consumeU2(code, op))];
+            } else if (instructionLength(code, pc) == 3) {
+                // Others with 2 bytes operand take a constant pool index
+                insn.operand = consumeU2(code, op);
+            }
+    }
+}
+
+void DecodedCode::decodeSwitch(const u1* code, DecodedInstruction& insn) {
+    const u4 pc = insn.pc;
+    // Operands are aligned to 4 bytes from the beginning of code
+    u4 op = pc + (4 - pc % 4) - 1;
+    auto targetOf = [&]() {
+        return indices[pc + static_cast<int32_t>(consumeU4(code, op))];
+    };
+    const u4 defaultTarget = targetOf();
+    std::vector<std::pair<int32_t, u4>> cases;
+    if (code[pc] == op_tableswitch) {
+        const auto low = static_cast<int32_t>(consumeU4(code, op));
+        const auto high = static_cast<int32_t>(consumeU4(code, op));
+        for (int64_t key = low; key <= high; key++) {
+            cases.emplace_back(static_cast<int32_t>(key), targetOf());
+        }
+    } else {
+        const auto npairs = static_cast<int32_t>(consumeU4(code, op));
+        for (int32_t i = 0; i < npairs; i++) {
+            const auto key = static_cast<int32_t>(consumeU4(code, op));
+            cases.emplace_back(key, targetOf());
+        }
+    }
+    insn.operand = static_cast<int32_t>(switchTables.size());
+    switchTables.emplace_back(defaultTarget, std::move(cases));
+}
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_DECODEDCODE_H
+#define YVM_DECODEDCODE_H
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Internal.h"
+
+//--------------------------------------------------------------------------------
+// One instruction of decoded code. Operands are read out of the bytecode once
+// into fixed width fields and branch offsets are turned into indices of their
+// target instructions, so that the interpreter never parses operand bytes
+//--------------------------------------------------------------------------------
+struct DecodedInstruction {
+    // Rewritten by quickening and superinstructions like the bytecode
+    u1 opcode;
+    // Opcode in original bytecode, the first instruction of a superinstruction
+    u1 originalOpcode;
+    // Local variable index(including that of the short forms like iload_1),
+    // constant pool index, constant of bipush and sipush, element type of
+    // newarray, or index of the switch table
+    int32_t operand;
+    // Increment of iinc, count of invokeinterface and dimensions of
+    // multianewarray
+    int32_t operand2;
+    // Index of branch target
+    u4 target;
+    // pc of the instruction in bytecode
+    u4 pc;
+};
+
+//--------------------------------------------------------------------------------
+// Indices of the instructions a tableswitch or lookupswitch jumps to. Keys
+// spread over a range not much larger than their count are looked up in a
+// dense jump table indexed by key - low, the others are binary searched
+//--------------------------------------------------------------------------------
+class SwitchTable {
+public:
+    SwitchTable(u4 defaultTarget, std::vector<std::pair<int32_t, u4>> cases);
+
+    u4 lookup(int32_t key) const {
+        if (dense) {
+            const uint32_t i =
+                static_cast<uint32_t>(key) - static_cast<uint32_t>(low);
+            return i < targets.size() ? targets[i] : defaultTarget;
+        }
+        auto iter = std::lower_bound(keys.begin(), keys.end(), key);
+        if (iter == keys.end() || *iter != key) {
+            return defaultTarget;
+        }
+        return targets[iter - keys.begin()];
+    }
+
+private:
+    u4 defaultTarget;
+    bool dense = false;
+    int32_t low = 0;
+    // Sorted keys of a sparse table, a dense table has none
+    std::vector<int32_t> keys;
+    std::vector<u4> targets;
+};
+
+//--------------------------------------------------------------------------------
+// DecodedCode is the bytecode of a method decoded into an array of fixed width
+// instructions when the code is set up, see MethodData::analyzeCode(). The
+// instruction after the one at index i is at i + 1. Bytecode pcs are still
+// what exception tables, profiles, inline caches and OSR entries refer to,
+// indexOf() maps them back into instruction indices
+//--------------------------------------------------------------------------------
+class DecodedCode {
+public:
+    // Operands are decoded from originalCode and opcodes are taken from code,
+    // which may have been rewritten into superinstructions
+    DecodedCode(const u1* originalCode, const u1* code, u4 codeLength);
+
+    const DecodedInstruction* getInstructions() const {
+        return instructions.data();
+    }
+    size_t size() const { return instructions.size(); }
+    // Index of the instruction at pc
+    u4 indexOf(u4 pc) const { return indices[pc]; }
+    const SwitchTable& getSwitchTable(int32_t i) const {
+        return switchTables[i];
+    }
+
+    // Rewrite the instruction at pc into quickOpcode, see MethodData::quicken()
+    void quicken(u4 pc, u1 quickOpcode) {
+        reinterpret_cast<volatile u1&>(instructions[indices[pc]].opcode) =
+            quickOpcode;
+    }
+
+private:
+    void decodeOperands(const u1* code, DecodedInstruction& insn);
+    void decodeSwitch(const u1* code, DecodedInstruction& insn);
+
+private:
+    std::vector<DecodedInstruction> instructions;
+    // Indexed by pc, entries in the middle of instructions are not used
+    std::unique_ptr<u4[]> indices;
+    std::vector<SwitchTable> switchTables;
+};
+
+#endif  // YVM_DECODEDCODE_H
@@ -248,6 +248,26 @@ typedef uint8_t u1;
 #define op_goto_w 200
 #define op_jsr_w 201
 #define op_breakpoint 202
+
+// Quick opcodes are private to yvm, they are rewritten from their original
+// opcodes once the symbolic reference was resolved. See MethodData
+#define op_getstatic_quick 203
+#define op_putstatic_quick 204
+#define op_getfield_quick 205
+#define op_putfield_quick 206
+#define op_invokevirtual_quick 207
+#define op_invokespecial_quick 208
+#define op_invokestatic_quick 209
+#define op_invokeinterface_quick 210
+
+// Superinstructions execute a frequent instruction sequence at once. Only the
+// first opcode of the sequence is rewritten, the following instructions are
+// kept untouched, so that code length, branch targets and exception table
+// ranges stay the same. See MethodData::fuseSuperinstructions()
+#define op_aload_0_getfield 211         // aload_0; getfield
+#define op_iload_iload_iadd_istore 212  // iload; iload; iadd; istore
+#define op_iload_bipush_if_icmpge 213   // iload; bipush; if_icmpge
+#define op_iinc_goto 214                // iinc; goto
 #define op_impdep1 254
 #define op_impdep2 255
 
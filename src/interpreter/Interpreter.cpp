@@ -25,42 +25,328 @@
 #include "../classfile/ClassFile.h"
 #include "../misc/Debug.h"
 #include "../misc/Option.h"
+#include "../misc/Utils.h"
+#include "../runtime/ConstPoolCache.h"
 #include "../runtime/JavaClass.h"
 #include "../runtime/JavaHeap.hpp"
+#include "../runtime/MethodData.h"
 #include "CallSite.h"
+#include "DecodedCode.h"
 #include "Interpreter.hpp"
+#include "JitCompiler.h"
 #include "MethodResolve.h"
-#include "SymbolicRef.h"
+#include "RegisterCode.h"
+#include "TierPolicy.h"
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <functional>
 #include <iostream>
 
 using namespace std;
 
-#define IS_COMPUTATIONAL_TYPE_1(value) \
-    (typeid(*value) != typeid(JDouble) && typeid(*value) != typeid(JLong))
-#define IS_COMPUTATIONAL_TYPE_2(value) \
-    (typeid(*value) == typeid(JDouble) || typeid(*value) == typeid(JLong))
+#define IS_COMPUTATIONAL_TYPE_1(value) (!(value).isWide())
+#define IS_COMPUTATIONAL_TYPE_2(value) ((value).isWide())
 
 #pragma warning(disable : 4715)
 #pragma warning(disable : 4244)
 
+//--------------------------------------------------------------------------------
+// Bytecode dispatching. When labels-as-values is available(GCC and Clang),
+// every handler jumps to the next handler through a 256-entry table directly,
+// otherwise we fall back to the portable switch inside a loop
+//--------------------------------------------------------------------------------
+#if defined(__GNUC__) && !defined(YVM_SWITCH_DISPATCH) && \
+    !defined(YVM_DEBUG_SHOW_BYTECODE)
+#define YVM_THREADED_DISPATCH
+#endif
+
+#ifdef YVM_DISPATCH_STATS
+#define COUNT_DISPATCH dispatched++;
+#else
+#define COUNT_DISPATCH
+#endif
+
+#ifdef YVM_THREADED_DISPATCH
+#define OPCODE(opcode) LABEL_##opcode:
+#define DEFAULT_OPCODE LABEL_default:
+#define DISPATCH()                               \
+    {                                            \
+        COUNT_DISPATCH                           \
+        goto *dispatchTable[decoded[op].opcode]; \
+    }
+#define CONTINUE_AT(index) \
+    {                      \
+        op = (index);      \
+        DISPATCH();        \
+    }
+#else
+#define OPCODE(opcode) case opcode:
+#define DEFAULT_OPCODE default:
+#define CONTINUE_AT(index) \
+    {                      \
+        op = (index);      \
+        continue;          \
+    }
+#endif
+
+// op is the index of current instruction in decoded code, the instruction
+// after it is always at op + 1
+#define NEXT_OPCODE() CONTINUE_AT(op + 1)
+
+//--------------------------------------------------------------------------------
+// Java methods call each other within one execByteCode() activation. Invoking
+// a method pushes its frame and continues the dispatch loop at its first
+// instruction, returning pops the frame and resumes caller at the pc saved in
+// caller's frame. Only the method that the activation was entered with
+// returns to C++ code. Frames running as register code or machine code take
+// part in the same loop, see execRegisterFrame(). Native methods and those
+// run with stack caching are still called through invokeCallSite()
+//--------------------------------------------------------------------------------
+#define LOAD_METHOD_CONTEXT()                              \
+    {                                                      \
+        jc = frames->top()->jc;                            \
+        methodData = frames->top()->method;                \
+        cpCache = jc->getConstPoolCache();                 \
+        decodedCode = methodData->getDecodedCode();        \
+        decoded = decodedCode->getInstructions();          \
+        exceptLen = methodData->getExceptionTableLength(); \
+        exceptTab = methodData->getExceptionTable();       \
+    }
+
+// Continue at target of the branch instruction at index. Backward jumps are
+// counted as loop iterations, and once the loop is hot current activation
+// continues at the target in a faster tier
+#define JUMP(index, target)                                             \
+    {                                                                   \
+        const u4 jumpTarget = (target);                                 \
+        if (jumpTarget <= (index)) {                                    \
+            methodData->countBackedge();                                \
+            if (const RegisterCode *osrCode =                           \
+                    runtime.tierPolicy->osrCodeOf(jc, methodData)) {    \
+                ON_STACK_REPLACE(*osrCode, decoded[jumpTarget].pc)      \
+            }                                                           \
+        }                                                               \
+        CONTINUE_AT(jumpTarget)                                         \
+    }
+
+// Conditional branch instruction at index, whether it jumps is profiled
+#define BRANCH_IF(condition, index, target)                    \
+    {                                                          \
+        const bool taken = (condition);                        \
+        methodData->profileBranch(decoded[(index)].pc, taken); \
+        if (taken) {                                           \
+            JUMP((index), (target))                            \
+        }                                                      \
+    }
+
+// Continue at the first instruction of callee if it runs in this activation
+#define INVOKE_CALLSITE(csite)                                          \
+    {                                                                   \
+        const CallSite &callee = (csite);                               \
+        if (callee.data->getTrivialKind() != TrivialKind::None &&       \
+            invokeTrivialMethod(callee)) {                              \
+            /* Ran in current frame */                                  \
+        } else {                                                        \
+            const bool isNative = IS_METHOD_NATIVE(callee.accessFlags); \
+            const RegisterCode *calleeCode =                            \
+                isNative ? nullptr                                      \
+                         : runtime.tierPolicy->registerCodeOf(callee);  \
+            if (isNative ||                                             \
+                (calleeCode == nullptr && isStackCached(callee))) {     \
+                invokeCallSite(callee);                                 \
+                CATCH_PROPAGATED_EXCEPTION                              \
+            } else {                                                    \
+                frames->top()->pc = decoded[op].pc;                     \
+                enterMethod(callee);                                    \
+                if (calleeCode != nullptr) {                            \
+                    frames->top()->registerCode = calleeCode;           \
+                    goto runRegisterFrame;                              \
+                }                                                       \
+                LOAD_METHOD_CONTEXT();                                  \
+                CONTINUE_AT(0)                                          \
+            }                                                           \
+        }                                                               \
+    }
+
+// Caller continues at the instruction after its invocation once
+// NEXT_OPCODE() is reached
+#define RETURN_TO_CALLER(returnValue, hasValue)                   \
+    {                                                             \
+        const JValue value = (returnValue);                       \
+        if (frames->depth() == entryDepth) {                      \
+            return value;                                         \
+        }                                                         \
+        frames->popFrame();                                       \
+        if (hasValue) {                                           \
+            frames->top()->push(value);                           \
+        }                                                         \
+        GC_SAFE_POINT                                             \
+        if (runtime.gc->shallGC()) {                              \
+            runtime.gc->stopTheWorld();                           \
+            runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);  \
+        }                                                         \
+        if (frames->top()->registerCode != nullptr) {             \
+            goto runRegisterFrame;                                \
+        }                                                         \
+        LOAD_METHOD_CONTEXT();                                    \
+        op = decodedCode->indexOf(frames->top()->pc);             \
+    }
+
+// Current method can not handle throwobj, unwind frames of callers in this
+// activation until one of them handles it and continue at its handler, or
+// leave it to C++ caller
+#define PROPAGATE_EXCEPTION(throwobj)                              \
+    {                                                              \
+        u4 handlerPc;                                              \
+        if (!unwindException((throwobj), entryDepth, handlerPc)) { \
+            return JValue::of<JObject>(throwobj);                  \
+        }                                                          \
+        LOAD_METHOD_CONTEXT();                                     \
+        CONTINUE_AT(decodedCode->indexOf(handlerPc))               \
+    }
+
+// Run the rest of current method from loop header osrPc with osrCode in its
+// frame. A bytecode frame has the layout of a register file, so the local
+// variables and operand stack are taken over in place. Nothing happens if
+// osrPc is not an OSR entry
+#define ON_STACK_REPLACE(osrCode, osrPc)                       \
+    {                                                          \
+        const int32_t osrEntry = (osrCode).getOsrEntry(osrPc); \
+        if (osrEntry >= 0) {                                   \
+            frames->top()->registerCode = &(osrCode);          \
+            frames->top()->pc = static_cast<u4>(osrEntry);     \
+            goto runRegisterFrame;                             \
+        }                                                      \
+    }
+
+// Only invocations of native methods can observe an exception propagated by
+// callee, find a handler in current method and continue there or keep
+// propagating it to caller
+#define CATCH_PROPAGATED_EXCEPTION                                         \
+    if (exception.hasUnhandledException()) {                               \
+        u4 pc = decoded[op].pc;                                            \
+        if (JObject *uncaught =                                            \
+                catchPropagatedException(jc, exceptLen, exceptTab, pc)) {  \
+            PROPAGATE_EXCEPTION(uncaught)                                  \
+        }                                                                  \
+        CONTINUE_AT(decodedCode->indexOf(pc))                              \
+    }
+
+#ifdef YVM_DISPATCH_STATS
+std::atomic<uint64_t> Interpreter::totalDispatched{0};
+
+// Accumulate bytecodes dispatched by one execByteCode() activation, no matter
+// how it returns
+struct DispatchCounter {
+    ~DispatchCounter() { Interpreter::totalDispatched += count; }
+    void operator++(int) { count++; }
+    uint64_t count = 0;
+};
+#endif
+
+// Shift instructions, both interpreters compute them in the same way
+static int32_t intShiftLeft(int32_t a, int32_t b) {
+    return a * pow(2, b & 0x1f);
+}
+
+static int64_t longShiftLeft(int64_t a, int64_t b) {
+    return a * pow(2, b & 0x3f);
+}
+
+static int32_t intShiftRight(int32_t a, int32_t b) {
+    return floor(a / pow(2, b & 0x1f));
+}
+
+static int64_t longShiftRight(int64_t a, int64_t b) {
+    return floor(a / pow(2, b & 0x3f));
+}
+
+static int32_t intUnsignedShiftRight(int32_t a, int32_t b) {
+    if (a > 0) {
+        return a >> (b & 0x1f);
+    } else if (a < 0) {
+        return (a >> (b & 0x1f)) + (2 << ~(b & 0x1f));
+    } else {
+        throw runtime_error("0 is not handled");
+    }
+}
+
+static int64_t longUnsignedShiftRight(int64_t a, int64_t b) {
+    if (a > 0) {
+        return a >> (b & 0x3f);
+    } else if (a < 0) {
+        return (a >> (b & 0x1f)) + (2L << ~(b & 0x3f));
+    } else {
+        throw runtime_error("0 is not handled");
+    }
+}
+
+// Results of lcmp, fcmp<op> and dcmp<op>
+static int32_t compareLong(int64_t value1, int64_t value2) {
+    if (value1 > value2) {
+        return 1;
+    } else if (value1 == value2) {
+        return 0;
+    }
+    return -1;
+}
+
+static int32_t compareFloat(float value1, float value2) {
+    if (value1 > value2) {
+        return 1;
+    } else if (abs(value1 - value2) < 0.000001) {
+        return 0;
+    }
+    return -1;
+}
+
+static int32_t compareDouble(double value1, double value2) {
+    if (value1 > value2) {
+        return 1;
+    } else if (abs(value1 - value2) < 0.000000000001) {
+        return 0;
+    }
+    return -1;
+}
+
+// Array elements are stored in place with their own width, see JArray. Caller
+// knows the element type from the opcode
+template <typename Element>
+static forceinline Element &arrayElement(const JArray *arrayref,
+                                         int32_t index) {
+    if (arrayref == nullptr) {
+        throw runtime_error("null pointer");
+    }
+    if (index >= arrayref->length || index < 0) {
+        throw runtime_error("array index out of bounds");
+    }
+    return arrayref->elements<Element>()[index];
+}
+
+// Whether a method is interpreted by execStackCachedCode() instead of
+// execByteCode()
+static bool isStackCached(const CallSite &csite) {
+    return runtime.stackCaching && csite.data->isStackCacheable();
+}
+
 Interpreter::~Interpreter() { delete frames; }
 
-JType *Interpreter::execNativeMethod(const string &className,
-                                     const string &methodName,
-                                     const string &methodDescriptor) {
-    string nativeMethod(className);
-    nativeMethod.append(".");
-    nativeMethod.append(methodName);
-    nativeMethod.append(".");
-    nativeMethod.append(methodDescriptor);
-    if (runtime.nativeMethods.find(nativeMethod) !=
-        runtime.nativeMethods.end()) {
-        return ((*runtime.nativeMethods.find(nativeMethod)).second)(
-            &runtime, frames->top()->localSlots, frames->top()->maxLocal);
+const char *Interpreter::dispatchMode() {
+#ifdef YVM_THREADED_DISPATCH
+    return "threaded";
+#else
+    return "switch";
+#endif
+}
+
+JValue Interpreter::execNativeMethod(const CallSite &csite) {
+    NativeFunction nativeFunction = csite.data->getNativeFunction();
+    if (nativeFunction != nullptr) {
+        return nativeFunction(&runtime, frames->top()->localSlots,
+                              frames->top()->maxLocal);
     }
 
     GC_SAFE_POINT
@@ -68,477 +354,464 @@ JType *Interpreter::execNativeMethod(const string &className,
         runtime.gc->stopTheWorld();
         runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
     }
-    return nullptr;
+    return JValue{};
 }
 
-JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
-                                 u2 exceptLen, ExceptionTable *exceptTab) {
-    for (decltype(codeLength) op = 0; op < codeLength; op++) {
-        // If callee propagates a unhandled exception, try to handle  it. When
-        // we can not handle it, propagates it to upper and returns
-        if (exception.hasUnhandledException()) {
-            op--;
-            auto *throwobj = frames->top()->pop<JObject>();
-            if (throwobj == nullptr) {
-                throw runtime_error("null pointer");
-            }
-            if (!hasInheritanceRelationship(
-                    throwobj->jc,
-                    runtime.cs->loadClassIfAbsent("java/lang/Throwable"))) {
-                throw runtime_error("it's not a throwable object");
-            }
-
-            if (handleException(jc, exceptLen, exceptTab, throwobj, op)) {
-                while (!frames->top()->emptyStack()) {
-                    frames->top()->pop<JType>();
-                }
-                frames->top()->push(throwobj);
-                exception.sweepException();
-            } else {
-                return throwobj;
-            }
-        }
+JValue Interpreter::execByteCode(const CallSite &csite) {
+    // Frame of csite has been pushed by caller
+    frames->top()->jc = csite.jc;
+    frames->top()->method = csite.data;
+    const size_t entryDepth = frames->depth();
+
+    const JavaClass *jc = csite.jc;
+    ConstPoolCache *cpCache = jc->getConstPoolCache();
+    MethodData *methodData = csite.data;
+    const DecodedCode *decodedCode = methodData->getDecodedCode();
+    const DecodedInstruction *decoded = decodedCode->getInstructions();
+    u2 exceptLen = csite.exceptionLen;
+    ExceptionTable *exceptTab = csite.exception;
+#ifdef YVM_DISPATCH_STATS
+    DispatchCounter dispatched;
+#endif
+    u4 op = 0;
+    // Frame of csite has register code, see invokeCallSite()
+    if (frames->top()->registerCode != nullptr) {
+        goto runRegisterFrame;
+    }
+#ifdef YVM_THREADED_DISPATCH
+    static const void *const dispatchTable[256] = {
+        &&LABEL_op_nop, &&LABEL_op_aconst_null, &&LABEL_op_iconst_m1,
+        &&LABEL_op_iconst_0, &&LABEL_op_iconst_1, &&LABEL_op_iconst_2,
+        &&LABEL_op_iconst_3, &&LABEL_op_iconst_4, &&LABEL_op_iconst_5,
+        &&LABEL_op_lconst_0, &&LABEL_op_lconst_1, &&LABEL_op_fconst_0,
+        &&LABEL_op_fconst_1, &&LABEL_op_fconst_2, &&LABEL_op_dconst_0,
+        &&LABEL_op_dconst_1, &&LABEL_op_bipush, &&LABEL_op_sipush,
+        &&LABEL_op_ldc, &&LABEL_op_ldc_w, &&LABEL_op_ldc2_w, &&LABEL_op_iload,
+        &&LABEL_op_lload, &&LABEL_op_fload, &&LABEL_op_dload, &&LABEL_op_aload,
+        &&LABEL_op_iload_0, &&LABEL_op_iload_1, &&LABEL_op_iload_2,
+        &&LABEL_op_iload_3, &&LABEL_op_lload_0, &&LABEL_op_lload_1,
+        &&LABEL_op_lload_2, &&LABEL_op_lload_3, &&LABEL_op_fload_0,
+        &&LABEL_op_fload_1, &&LABEL_op_fload_2, &&LABEL_op_fload_3,
+        &&LABEL_op_dload_0, &&LABEL_op_dload_1, &&LABEL_op_dload_2,
+        &&LABEL_op_dload_3, &&LABEL_op_aload_0, &&LABEL_op_aload_1,
+        &&LABEL_op_aload_2, &&LABEL_op_aload_3, &&LABEL_op_iaload,
+        &&LABEL_op_laload, &&LABEL_op_faload, &&LABEL_op_daload,
+        &&LABEL_op_aaload, &&LABEL_op_baload, &&LABEL_op_caload,
+        &&LABEL_op_saload, &&LABEL_op_istore, &&LABEL_op_lstore,
+        &&LABEL_op_fstore, &&LABEL_op_dstore, &&LABEL_op_astore,
+        &&LABEL_op_istore_0, &&LABEL_op_istore_1, &&LABEL_op_istore_2,
+        &&LABEL_op_istore_3, &&LABEL_op_lstore_0, &&LABEL_op_lstore_1,
+        &&LABEL_op_lstore_2, &&LABEL_op_lstore_3, &&LABEL_op_fstore_0,
+        &&LABEL_op_fstore_1, &&LABEL_op_fstore_2, &&LABEL_op_fstore_3,
+        &&LABEL_op_dstore_0, &&LABEL_op_dstore_1, &&LABEL_op_dstore_2,
+        &&LABEL_op_dstore_3, &&LABEL_op_astore_0, &&LABEL_op_astore_1,
+        &&LABEL_op_astore_2, &&LABEL_op_astore_3, &&LABEL_op_iastore,
+        &&LABEL_op_lastore, &&LABEL_op_fastore, &&LABEL_op_dastore,
+        &&LABEL_op_aastore, &&LABEL_op_bastore, &&LABEL_op_castore,
+        &&LABEL_op_sastore, &&LABEL_op_pop, &&LABEL_op_pop2, &&LABEL_op_dup,
+        &&LABEL_op_dup_x1, &&LABEL_op_dup_x2, &&LABEL_op_dup2,
+        &&LABEL_op_dup2_x1, &&LABEL_op_dup2_x2, &&LABEL_op_swap,
+        &&LABEL_op_iadd, &&LABEL_op_ladd, &&LABEL_op_fadd, &&LABEL_op_dadd,
+        &&LABEL_op_isub, &&LABEL_op_lsub, &&LABEL_op_fsub, &&LABEL_op_dsub,
+        &&LABEL_op_imul, &&LABEL_op_lmul, &&LABEL_op_fmul, &&LABEL_op_dmul,
+        &&LABEL_op_idiv, &&LABEL_op_ldiv, &&LABEL_op_fdiv, &&LABEL_op_ddiv,
+        &&LABEL_op_irem, &&LABEL_op_lrem, &&LABEL_op_frem, &&LABEL_op_drem,
+        &&LABEL_op_ineg, &&LABEL_op_lneg, &&LABEL_op_fneg, &&LABEL_op_dneg,
+        &&LABEL_op_ishl, &&LABEL_op_lshl, &&LABEL_op_ishr, &&LABEL_op_lshr,
+        &&LABEL_op_iushr, &&LABEL_op_lushr, &&LABEL_op_iand, &&LABEL_op_land,
+        &&LABEL_op_ior, &&LABEL_op_lor, &&LABEL_op_ixor, &&LABEL_op_lxor,
+        &&LABEL_op_iinc, &&LABEL_op_i2l, &&LABEL_op_i2f, &&LABEL_op_i2d,
+        &&LABEL_op_l2i, &&LABEL_op_l2f, &&LABEL_op_l2d, &&LABEL_op_f2i,
+        &&LABEL_op_f2l, &&LABEL_op_f2d, &&LABEL_op_d2i, &&LABEL_op_d2l,
+        &&LABEL_op_d2f, &&LABEL_op_i2b, &&LABEL_op_i2c, &&LABEL_op_i2s,
+        &&LABEL_op_lcmp, &&LABEL_op_fcmpl, &&LABEL_op_fcmpg, &&LABEL_op_dcmpl,
+        &&LABEL_op_dcmpg, &&LABEL_op_ifeq, &&LABEL_op_ifne, &&LABEL_op_iflt,
+        &&LABEL_op_ifge, &&LABEL_op_ifgt, &&LABEL_op_ifle, &&LABEL_op_if_icmpeq,
+        &&LABEL_op_if_icmpne, &&LABEL_op_if_icmplt, &&LABEL_op_if_icmpge,
+        &&LABEL_op_if_icmpgt, &&LABEL_op_if_icmple, &&LABEL_op_if_acmpeq,
+        &&LABEL_op_if_acmpne, &&LABEL_op_goto, &&LABEL_op_jsr, &&LABEL_op_ret,
+        &&LABEL_op_tableswitch, &&LABEL_op_lookupswitch, &&LABEL_op_ireturn,
+        &&LABEL_op_lreturn, &&LABEL_op_freturn, &&LABEL_op_dreturn,
+        &&LABEL_op_areturn, &&LABEL_op_return, &&LABEL_op_getstatic,
+        &&LABEL_op_putstatic, &&LABEL_op_getfield, &&LABEL_op_putfield,
+        &&LABEL_op_invokevirtual, &&LABEL_op_invokespecial,
+        &&LABEL_op_invokestatic, &&LABEL_op_invokeinterface,
+        &&LABEL_op_invokedynamic, &&LABEL_op_new, &&LABEL_op_newarray,
+        &&LABEL_op_anewarray, &&LABEL_op_arraylength, &&LABEL_op_athrow,
+        &&LABEL_op_checkcast, &&LABEL_op_instanceof, &&LABEL_op_monitorenter,
+        &&LABEL_op_monitorexit, &&LABEL_op_wide, &&LABEL_op_multianewarray,
+        &&LABEL_op_ifnull, &&LABEL_op_ifnonnull, &&LABEL_op_goto_w,
+        &&LABEL_op_jsr_w, &&LABEL_op_breakpoint, &&LABEL_op_getstatic_quick,
+        &&LABEL_op_putstatic_quick, &&LABEL_op_getfield_quick,
+        &&LABEL_op_putfield_quick, &&LABEL_op_invokevirtual_quick,
+        &&LABEL_op_invokespecial_quick, &&LABEL_op_invokestatic_quick,
+        &&LABEL_op_invokeinterface_quick, &&LABEL_op_aload_0_getfield,
+        &&LABEL_op_iload_iload_iadd_istore, &&LABEL_op_iload_bipush_if_icmpge,
+        &&LABEL_op_iinc_goto, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_default, &&LABEL_default, &&LABEL_default, &&LABEL_default,
+        &&LABEL_op_impdep1, &&LABEL_op_impdep2};
+    DISPATCH();
+    // Mirror the loop and switch blocks of the portable dispatching
+    {
+        {
+#else
+    for (;;) {
 #ifdef YVM_DEBUG_SHOW_BYTECODE
-        for (int i = 0; i < frames.size(); i++) {
-            cout << "-";
-        }
-        Inspector::printOpcode(code, op);
+        Inspector::printOpcode(methodData->getCode(), decoded[op].pc);
 #endif
+        COUNT_DISPATCH
         // Interpreting through big switching
-        switch (code[op]) {
-            case op_nop: {
+        switch (decoded[op].opcode) {
+#endif
+            OPCODE(op_nop) {
                 // DO NOTHING :-)
-            } break;
-            case op_aconst_null: {
-                frames->top()->push(nullptr);
-            } break;
-            case op_iconst_m1: {
-                frames->top()->push(new JInt(-1));
-            } break;
-            case op_iconst_0: {
-                frames->top()->push(new JInt(0));
-            } break;
-            case op_iconst_1: {
-                frames->top()->push(new JInt(1));
-            } break;
-            case op_iconst_2: {
-                frames->top()->push(new JInt(2));
-            } break;
-            case op_iconst_3: {
-                frames->top()->push(new JInt(3));
-            } break;
-            case op_iconst_4: {
-                frames->top()->push(new JInt(4));
-            } break;
-            case op_iconst_5: {
-                frames->top()->push(new JInt(5));
-            } break;
-            case op_lconst_0: {
-                frames->top()->push(new JLong(0));
-            } break;
-            case op_lconst_1: {
-                frames->top()->push(new JLong(1));
-            } break;
-            case op_fconst_0: {
-                frames->top()->push(new JFloat(0.0f));
-            } break;
-            case op_fconst_1: {
-                frames->top()->push(new JFloat(1.0f));
-            } break;
-            case op_fconst_2: {
-                frames->top()->push(new JFloat(2.0f));
-            } break;
-            case op_dconst_0: {
-                frames->top()->push(new JDouble(0.0));
-            } break;
-            case op_dconst_1: {
-                frames->top()->push(new JDouble(1.0));
-            } break;
-            case op_bipush: {
-                const u1 byte = consumeU1(code, op);
-                frames->top()->push(new JInt(byte));
-            } break;
-            case op_sipush: {
-                const u2 byte = consumeU2(code, op);
-                frames->top()->push(new JInt(byte));
-            } break;
-            case op_ldc: {
-                const u1 index = consumeU1(code, op);
-                loadConstantPoolItem2Stack(jc, static_cast<u2>(index));
-            } break;
-            case op_ldc_w: {
-                const u2 index = consumeU2(code, op);
-                loadConstantPoolItem2Stack(jc, index);
-            } break;
-            case op_ldc2_w: {
-                const u2 index = consumeU2(code, op);
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_Double)) {
-                    auto val = dynamic_cast<CONSTANT_Double *>(
-                                   jc->raw.constPoolInfo[index])
-                                   ->val;
-                    JDouble *dval = new JDouble;
-                    dval->val = val;
-                    frames->top()->push(dval);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Long)) {
-                    auto val = dynamic_cast<CONSTANT_Long *>(
-                                   jc->raw.constPoolInfo[index])
-                                   ->val;
-                    JLong *lval = new JLong;
-                    lval->val = val;
-                    frames->top()->push(lval);
-                } else {
-                    throw runtime_error(
-                        "invalid symbolic reference index on "
-                        "constant pool");
-                }
-            } break;
-            case op_iload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JInt>(index);
-            } break;
-            case op_lload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JLong>(index);
-            } break;
-            case op_fload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JFloat>(index);
-            } break;
-            case op_dload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JDouble>(index);
-            } break;
-            case op_aload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JRef>(index);
-            } break;
-            case op_iload_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_aconst_null) {
+                frames->top()->push<JRef>(nullptr);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_m1) {
+                frames->top()->push<JInt>(-1);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_0) {
+                frames->top()->push<JInt>(0);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_1) {
+                frames->top()->push<JInt>(1);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_2) {
+                frames->top()->push<JInt>(2);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_3) {
+                frames->top()->push<JInt>(3);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_4) {
+                frames->top()->push<JInt>(4);
+            } NEXT_OPCODE();
+            OPCODE(op_iconst_5) {
+                frames->top()->push<JInt>(5);
+            } NEXT_OPCODE();
+            OPCODE(op_lconst_0) {
+                frames->top()->push<JLong>(0);
+            } NEXT_OPCODE();
+            OPCODE(op_lconst_1) {
+                frames->top()->push<JLong>(1);
+            } NEXT_OPCODE();
+            OPCODE(op_fconst_0) {
+                frames->top()->push<JFloat>(0.0f);
+            } NEXT_OPCODE();
+            OPCODE(op_fconst_1) {
+                frames->top()->push<JFloat>(1.0f);
+            } NEXT_OPCODE();
+            OPCODE(op_fconst_2) {
+                frames->top()->push<JFloat>(2.0f);
+            } NEXT_OPCODE();
+            OPCODE(op_dconst_0) {
+                frames->top()->push<JDouble>(0.0);
+            } NEXT_OPCODE();
+            OPCODE(op_dconst_1) {
+                frames->top()->push<JDouble>(1.0);
+            } NEXT_OPCODE();
+            OPCODE(op_bipush) {
+                frames->top()->push<JInt>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_sipush) {
+                frames->top()->push<JInt>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_ldc) {
+                const u2 index = decoded[op].operand;
+                frames->top()->push(cpCache->resolveConstant(index)->value);
+            } NEXT_OPCODE();
+            OPCODE(op_ldc_w) {
+                const u2 index = decoded[op].operand;
+                frames->top()->push(cpCache->resolveConstant(index)->value);
+            } NEXT_OPCODE();
+            OPCODE(op_ldc2_w) {
+                const u2 index = decoded[op].operand;
+                frames->top()->push(cpCache->resolveConstant(index)->value);
+            } NEXT_OPCODE();
+            OPCODE(op_iload) {
+                frames->top()->load<JInt>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_lload) {
+                frames->top()->load<JLong>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_fload) {
+                frames->top()->load<JFloat>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_dload) {
+                frames->top()->load<JDouble>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_aload) {
+                frames->top()->load<JRef>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_iload_0) {
                 frames->top()->load<JInt>(0);
-            } break;
-            case op_iload_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_iload_1) {
                 frames->top()->load<JInt>(1);
-            } break;
-            case op_iload_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_iload_2) {
                 frames->top()->load<JInt>(2);
-            } break;
-            case op_iload_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_iload_3) {
                 frames->top()->load<JInt>(3);
-            } break;
-            case op_lload_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_lload_0) {
                 frames->top()->load<JLong>(0);
-            } break;
-            case op_lload_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_lload_1) {
                 frames->top()->load<JLong>(1);
-            } break;
-            case op_lload_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_lload_2) {
                 frames->top()->load<JLong>(2);
-            } break;
-            case op_lload_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_lload_3) {
                 frames->top()->load<JLong>(3);
-            } break;
-            case op_fload_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_fload_0) {
                 frames->top()->load<JFloat>(0);
-            } break;
-            case op_fload_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_fload_1) {
                 frames->top()->load<JFloat>(1);
-            } break;
-            case op_fload_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_fload_2) {
                 frames->top()->load<JFloat>(2);
-            } break;
-            case op_fload_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_fload_3) {
                 frames->top()->load<JFloat>(3);
-            } break;
-            case op_dload_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_dload_0) {
                 frames->top()->load<JDouble>(0);
-            } break;
-            case op_dload_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_dload_1) {
                 frames->top()->load<JDouble>(1);
-            } break;
-            case op_dload_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_dload_2) {
                 frames->top()->load<JDouble>(2);
-            } break;
-            case op_dload_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_dload_3) {
                 frames->top()->load<JDouble>(3);
-            } break;
-            case op_aload_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_aload_0) {
                 frames->top()->load<JRef>(0);
-            } break;
-            case op_aload_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_aload_1) {
                 frames->top()->load<JRef>(1);
-            } break;
-            case op_aload_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_aload_2) {
                 frames->top()->load<JRef>(2);
-            } break;
-            case op_aload_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_aload_3) {
                 frames->top()->load<JRef>(3);
-            } break;
-            case op_saload:
-            case op_caload:
-            case op_baload:
-            case op_iaload: {
-                auto *index = frames->top()->pop<JInt>();
+            } NEXT_OPCODE();
+            OPCODE(op_iaload) {
+                auto index = frames->top()->pop<JInt>();
                 const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JInt *>(
-                    runtime.heap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_laload: {
-                auto *index = frames->top()->pop<JInt>();
+                frames->top()->push<JInt>(arrayElement<int32_t>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_laload) {
+                auto index = frames->top()->pop<JInt>();
                 const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JLong *>(
-                    runtime.heap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_faload: {
-                auto *index = frames->top()->pop<JInt>();
+                frames->top()->push<JLong>(
+                    arrayElement<int64_t>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_faload) {
+                auto index = frames->top()->pop<JInt>();
                 const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JFloat *>(
-                    runtime.heap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_daload: {
-                auto *index = frames->top()->pop<JInt>();
+                frames->top()->push<JFloat>(arrayElement<float>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_daload) {
+                auto index = frames->top()->pop<JInt>();
                 const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JDouble *>(
-                    runtime.heap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_aaload: {
-                auto *index = frames->top()->pop<JInt>();
+                frames->top()->push<JDouble>(
+                    arrayElement<double>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_aaload) {
+                auto index = frames->top()->pop<JInt>();
                 const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JRef *>(
-                    runtime.heap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_istore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JInt>(index);
-            } break;
-            case op_lstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JLong>(index);
-            } break;
-            case op_fstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JFloat>(index);
-            } break;
-            case op_dstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JDouble>(index);
-            } break;
-            case op_astore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JRef>(index);
-            } break;
-            case op_istore_0: {
+                frames->top()->push<JRef>(arrayElement<JType *>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_baload) {
+                auto index = frames->top()->pop<JInt>();
+                const auto *arrref = frames->top()->pop<JArray>();
+                frames->top()->push<JInt>(arrayElement<int8_t>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_caload) {
+                auto index = frames->top()->pop<JInt>();
+                const auto *arrref = frames->top()->pop<JArray>();
+                frames->top()->push<JInt>(
+                    arrayElement<uint16_t>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_saload) {
+                auto index = frames->top()->pop<JInt>();
+                const auto *arrref = frames->top()->pop<JArray>();
+                frames->top()->push<JInt>(arrayElement<int16_t>(arrref, index));
+            } NEXT_OPCODE();
+            OPCODE(op_istore) {
+                frames->top()->store<JInt>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_lstore) {
+                frames->top()->store<JLong>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_fstore) {
+                frames->top()->store<JFloat>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_dstore) {
+                frames->top()->store<JDouble>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_astore) {
+                frames->top()->store<JRef>(decoded[op].operand);
+            } NEXT_OPCODE();
+            OPCODE(op_istore_0) {
                 frames->top()->store<JInt>(0);
-            } break;
-            case op_istore_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_istore_1) {
                 frames->top()->store<JInt>(1);
-            } break;
-            case op_istore_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_istore_2) {
                 frames->top()->store<JInt>(2);
-            } break;
-            case op_istore_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_istore_3) {
                 frames->top()->store<JInt>(3);
-            } break;
-            case op_lstore_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_lstore_0) {
                 frames->top()->store<JLong>(0);
-            } break;
-            case op_lstore_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_lstore_1) {
                 frames->top()->store<JLong>(1);
-            } break;
-            case op_lstore_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_lstore_2) {
                 frames->top()->store<JLong>(2);
-            } break;
-            case op_lstore_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_lstore_3) {
                 frames->top()->store<JLong>(3);
-            } break;
-            case op_fstore_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_fstore_0) {
                 frames->top()->store<JFloat>(0);
-            } break;
-            case op_fstore_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_fstore_1) {
                 frames->top()->store<JFloat>(1);
-            } break;
-            case op_fstore_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_fstore_2) {
                 frames->top()->store<JFloat>(2);
-            } break;
-            case op_fstore_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_fstore_3) {
                 frames->top()->store<JFloat>(3);
-            } break;
-            case op_dstore_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_dstore_0) {
                 frames->top()->store<JDouble>(0);
-            } break;
-            case op_dstore_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_dstore_1) {
                 frames->top()->store<JDouble>(1);
-            } break;
-            case op_dstore_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_dstore_2) {
                 frames->top()->store<JDouble>(2);
-            } break;
-            case op_dstore_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_dstore_3) {
                 frames->top()->store<JDouble>(3);
-            } break;
-            case op_astore_0: {
+            } NEXT_OPCODE();
+            OPCODE(op_astore_0) {
                 frames->top()->store<JRef>(0);
-            } break;
-            case op_astore_1: {
+            } NEXT_OPCODE();
+            OPCODE(op_astore_1) {
                 frames->top()->store<JRef>(1);
-            } break;
-            case op_astore_2: {
+            } NEXT_OPCODE();
+            OPCODE(op_astore_2) {
                 frames->top()->store<JRef>(2);
-            } break;
-            case op_astore_3: {
+            } NEXT_OPCODE();
+            OPCODE(op_astore_3) {
                 frames->top()->store<JRef>(3);
-            } break;
-            case op_iastore: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *index = frames->top()->pop<JInt>();
+            } NEXT_OPCODE();
+            OPCODE(op_iastore) {
+                auto value = frames->top()->pop<JInt>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_lastore: {
-                auto *value = frames->top()->pop<JLong>();
-                auto *index = frames->top()->pop<JInt>();
+                arrayElement<int32_t>(arrref, index) = value;
+            } NEXT_OPCODE();
+            OPCODE(op_lastore) {
+                auto value = frames->top()->pop<JLong>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_fastore: {
-                auto *value = frames->top()->pop<JFloat>();
-                auto *index = frames->top()->pop<JInt>();
+                arrayElement<int64_t>(arrref, index) = value;
+            } NEXT_OPCODE();
+            OPCODE(op_fastore) {
+                auto value = frames->top()->pop<JFloat>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_dastore: {
-                auto *value = frames->top()->pop<JDouble>();
-                auto *index = frames->top()->pop<JInt>();
+                arrayElement<float>(arrref, index) = value;
+            } NEXT_OPCODE();
+            OPCODE(op_dastore) {
+                auto value = frames->top()->pop<JDouble>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_aastore: {
-                auto *value = frames->top()->pop<JType>();
-                auto *index = frames->top()->pop<JInt>();
+                arrayElement<double>(arrref, index) = value;
+            } NEXT_OPCODE();
+            OPCODE(op_aastore) {
+                auto value = frames->top()->pop<JRef>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_bastore: {
-                auto *value = frames->top()->pop<JInt>();
-                value->val = static_cast<int8_t>(value->val);
-                auto *index = frames->top()->pop<JInt>();
+                arrayElement<JType *>(arrref, index) = value;
+            } NEXT_OPCODE();
+            OPCODE(op_bastore) {
+                auto value = frames->top()->pop<JInt>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_sastore:
-            case op_castore: {
-                auto *value = frames->top()->pop<JInt>();
-                value->val = static_cast<int16_t>(value->val);
-
-                auto *index = frames->top()->pop<JInt>();
+                // Boolean arrays share the opcode with byte arrays
+                int8_t &elem = arrayElement<int8_t>(arrref, index);
+                elem = static_cast<int8_t>(arrref->type == 'Z' ? value & 1
+                                                                : value);
+            } NEXT_OPCODE();
+            OPCODE(op_sastore)
+            OPCODE(op_castore) {
+                auto value = frames->top()->pop<JInt>();
+                auto index = frames->top()->pop<JInt>();
                 auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                runtime.heap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_pop: {
-                frames->top()->pop<JType>();
-            } break;
-            case op_pop2: {
-                frames->top()->pop<JType>();
-                frames->top()->pop<JType>();
-            } break;
-            case op_dup: {
-                JType *value = frames->top()->pop<JType>();
-
-                assert(typeid(*value) != typeid(JLong) &&
-                       typeid(*value) != typeid(JDouble));
+                arrayElement<uint16_t>(arrref, index) =
+                    static_cast<uint16_t>(value);
+            } NEXT_OPCODE();
+            OPCODE(op_pop) {
+                frames->top()->pop();
+            } NEXT_OPCODE();
+            OPCODE(op_pop2) {
+                frames->top()->pop();
+                frames->top()->pop();
+            } NEXT_OPCODE();
+            OPCODE(op_dup) {
+                JValue value = frames->top()->pop();
+
+                assert(IS_COMPUTATIONAL_TYPE_1(value));
                 frames->top()->push(value);
-                frames->top()->push(cloneValue(value));
-            } break;
-            case op_dup_x1: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
+                frames->top()->push(value);
+            } NEXT_OPCODE();
+            OPCODE(op_dup_x1) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
 
                 assert(IS_COMPUTATIONAL_TYPE_1(value1));
                 assert(IS_COMPUTATIONAL_TYPE_1(value2));
 
-                frames->top()->push(cloneValue(value1));
+                frames->top()->push(value1);
                 frames->top()->push(value2);
                 frames->top()->push(value1);
-            } break;
-            case op_dup_x2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_dup_x2) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
+                JValue value3 = frames->top()->pop();
 
                 if (IS_COMPUTATIONAL_TYPE_1(value1) &&
                     IS_COMPUTATIONAL_TYPE_1(value2) &&
                     IS_COMPUTATIONAL_TYPE_1(value3)) {
                     // use structure 1
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value1);
                     frames->top()->push(value3);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
@@ -547,45 +820,45 @@ JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
                     // use structure 2
                     frames->top()->push(value3);
 
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value1);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
                 } else {
                     SHOULD_NOT_REACH_HERE
                 }
-            } break;
-            case op_dup2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_dup2) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
 
                 if (IS_COMPUTATIONAL_TYPE_1(value1) &&
                     IS_COMPUTATIONAL_TYPE_1(value2)) {
                     // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value2);
+                    frames->top()->push(value1);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
                 } else if (IS_COMPUTATIONAL_TYPE_2(value1)) {
                     // use structure 2
                     frames->top()->push(value2);
 
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value1);
                     frames->top()->push(value1);
                 } else {
                     SHOULD_NOT_REACH_HERE
                 }
-            } break;
-            case op_dup2_x1: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_dup2_x1) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
+                JValue value3 = frames->top()->pop();
 
                 if (IS_COMPUTATIONAL_TYPE_1(value1) &&
                     IS_COMPUTATIONAL_TYPE_1(value2) &&
                     IS_COMPUTATIONAL_TYPE_1(value3)) {
                     // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value2);
+                    frames->top()->push(value1);
                     frames->top()->push(value3);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
@@ -594,25 +867,25 @@ JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
                     // use structure 2
                     frames->top()->push(value3);
 
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value1);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
                 } else {
                     SHOULD_NOT_REACH_HERE
                 }
-            } break;
-            case op_dup2_x2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
-                JType *value4 = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_dup2_x2) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
+                JValue value3 = frames->top()->pop();
+                JValue value4 = frames->top()->pop();
                 if (IS_COMPUTATIONAL_TYPE_1(value1) &&
                     IS_COMPUTATIONAL_TYPE_1(value2) &&
                     IS_COMPUTATIONAL_TYPE_1(value3) &&
                     IS_COMPUTATIONAL_TYPE_1(value4)) {
                     // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value2);
+                    frames->top()->push(value1);
                     frames->top()->push(value4);
                     frames->top()->push(value3);
                     frames->top()->push(value2);
@@ -623,679 +896,524 @@ JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
                     // use structure 2
                     frames->top()->push(value4);
 
-                    frames->top()->push(cloneValue(value1));
+                    frames->top()->push(value1);
                     frames->top()->push(value4);
                     frames->top()->push(value2);
                     frames->top()->push(value1);
                 } else {
                     SHOULD_NOT_REACH_HERE
                 }
-            } break;
-            case op_swap: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_swap) {
+                JValue value1 = frames->top()->pop();
+                JValue value2 = frames->top()->pop();
 
                 assert(IS_COMPUTATIONAL_TYPE_1(value1));
                 assert(IS_COMPUTATIONAL_TYPE_1(value2));
-                if (typeid(*value1) == typeid(JInt) &&
-                    typeid(*value2) == typeid(JInt)) {
-                    swap(value1, value2);
-                } else if (typeid(*value1) == typeid(JInt) &&
-                           typeid(*value2) == typeid(JFloat)) {
-                    const int32_t temp = dynamic_cast<JInt *>(value1)->val;
-                    dynamic_cast<JInt *>(value1)->val = static_cast<int32_t>(
-                        dynamic_cast<JFloat *>(value2)->val);
-                    dynamic_cast<JFloat *>(value2)->val =
-                        static_cast<float>(temp);
-                } else if (typeid(*value1) == typeid(JFloat) &&
-                           typeid(*value2) == typeid(JInt)) {
-                    const float temp = dynamic_cast<JFloat *>(value1)->val;
-                    dynamic_cast<JFloat *>(value1)->val =
-                        static_cast<int32_t>(dynamic_cast<JInt *>(value2)->val);
-                    dynamic_cast<JInt *>(value2)->val =
-                        static_cast<int32_t>(temp);
-                } else if (typeid(*value1) == typeid(JFloat) &&
-                           typeid(*value2) == typeid(JFloat)) {
-                    swap(value1, value2);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_iadd: {
+                frames->top()->push(value1);
+                frames->top()->push(value2);
+            } NEXT_OPCODE();
+            OPCODE(op_iadd) {
                 binaryArithmetic<JInt>(plus<>());
-            } break;
-            case op_ladd: {
+            } NEXT_OPCODE();
+            OPCODE(op_ladd) {
                 binaryArithmetic<JLong>(plus<>());
-            } break;
-            case op_fadd: {
+            } NEXT_OPCODE();
+            OPCODE(op_fadd) {
                 binaryArithmetic<JFloat>(plus<>());
-            } break;
-            case op_dadd: {
+            } NEXT_OPCODE();
+            OPCODE(op_dadd) {
                 binaryArithmetic<JDouble>(plus<>());
-            } break;
-            case op_isub: {
+            } NEXT_OPCODE();
+            OPCODE(op_isub) {
                 binaryArithmetic<JInt>(minus<>());
-            } break;
-            case op_lsub: {
+            } NEXT_OPCODE();
+            OPCODE(op_lsub) {
                 binaryArithmetic<JLong>(minus<>());
-            } break;
-            case op_fsub: {
+            } NEXT_OPCODE();
+            OPCODE(op_fsub) {
                 binaryArithmetic<JFloat>(minus<>());
-            } break;
-            case op_dsub: {
+            } NEXT_OPCODE();
+            OPCODE(op_dsub) {
                 binaryArithmetic<JDouble>(minus<>());
-            } break;
-            case op_imul: {
+            } NEXT_OPCODE();
+            OPCODE(op_imul) {
                 binaryArithmetic<JInt>(multiplies<>());
-            } break;
-            case op_lmul: {
+            } NEXT_OPCODE();
+            OPCODE(op_lmul) {
                 binaryArithmetic<JLong>(multiplies<>());
-            } break;
-            case op_fmul: {
+            } NEXT_OPCODE();
+            OPCODE(op_fmul) {
                 binaryArithmetic<JFloat>(multiplies<>());
-            } break;
-            case op_dmul: {
+            } NEXT_OPCODE();
+            OPCODE(op_dmul) {
                 binaryArithmetic<JDouble>(multiplies<>());
-            } break;
-            case op_idiv: {
+            } NEXT_OPCODE();
+            OPCODE(op_idiv) {
                 binaryArithmetic<JInt>(divides<>());
-            } break;
-            case op_ldiv: {
+            } NEXT_OPCODE();
+            OPCODE(op_ldiv) {
                 binaryArithmetic<JLong>(divides<>());
-            } break;
-            case op_fdiv: {
+            } NEXT_OPCODE();
+            OPCODE(op_fdiv) {
                 binaryArithmetic<JFloat>(divides<>());
-            } break;
-            case op_ddiv: {
+            } NEXT_OPCODE();
+            OPCODE(op_ddiv) {
                 binaryArithmetic<JDouble>(divides<>());
 
-            } break;
-            case op_irem: {
+            } NEXT_OPCODE();
+            OPCODE(op_irem) {
                 binaryArithmetic<JInt>(modulus<>());
-            } break;
-            case op_lrem: {
+            } NEXT_OPCODE();
+            OPCODE(op_lrem) {
                 binaryArithmetic<JLong>(modulus<>());
-            } break;
-            case op_frem: {
-                fmodArithmetic<JFloat>();
-            } break;
-            case op_drem: {
+            } NEXT_OPCODE();
+            OPCODE(op_frem) {
                 fmodArithmetic<JFloat>();
-            } break;
-            case op_ineg: {
+            } NEXT_OPCODE();
+            OPCODE(op_drem) {
+                fmodArithmetic<JDouble>();
+            } NEXT_OPCODE();
+            OPCODE(op_ineg) {
                 unaryArithmetic<JInt>(negate<>());
-            } break;
-            case op_lneg: {
+            } NEXT_OPCODE();
+            OPCODE(op_lneg) {
                 unaryArithmetic<JLong>(negate<>());
-            } break;
-            case op_fneg: {
+            } NEXT_OPCODE();
+            OPCODE(op_fneg) {
                 unaryArithmetic<JFloat>(negate<>());
-            } break;
-            case op_dneg: {
+            } NEXT_OPCODE();
+            OPCODE(op_dneg) {
                 unaryArithmetic<JDouble>(negate<>());
-            } break;
-            case op_ishl: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    return a * pow(2, b & 0x1f);
-                });
-            } break;
-            case op_lshl: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    return a * pow(2, b & 0x3f);
-                });
-            } break;
-            case op_ishr: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    return floor(a / pow(2, b & 0x1f));
-                });
-            } break;
-            case op_lshr: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    return floor(a / pow(2, b & 0x3f));
-                });
-            } break;
-            case op_iushr: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    if (a > 0) {
-                        return a >> (b & 0x1f);
-                    } else if (a < 0) {
-                        return (a >> (b & 0x1f)) + (2 << ~(b & 0x1f));
-                    } else {
-                        throw runtime_error("0 is not handled");
-                    }
-                });
-            } break;
-            case op_lushr: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    if (a > 0) {
-                        return a >> (b & 0x3f);
-                    } else if (a < 0) {
-                        return (a >> (b & 0x1f)) + (2L << ~(b & 0x3f));
-                    } else {
-                        throw runtime_error("0 is not handled");
-                    }
-                });
-            } break;
-            case op_iand: {
+            } NEXT_OPCODE();
+            OPCODE(op_ishl) {
+                binaryArithmetic<JInt>(intShiftLeft);
+            } NEXT_OPCODE();
+            OPCODE(op_lshl) {
+                binaryArithmetic<JLong>(longShiftLeft);
+            } NEXT_OPCODE();
+            OPCODE(op_ishr) {
+                binaryArithmetic<JInt>(intShiftRight);
+            } NEXT_OPCODE();
+            OPCODE(op_lshr) {
+                binaryArithmetic<JLong>(longShiftRight);
+            } NEXT_OPCODE();
+            OPCODE(op_iushr) {
+                binaryArithmetic<JInt>(intUnsignedShiftRight);
+            } NEXT_OPCODE();
+            OPCODE(op_lushr) {
+                binaryArithmetic<JLong>(longUnsignedShiftRight);
+            } NEXT_OPCODE();
+            OPCODE(op_iand) {
                 binaryArithmetic<JInt>(bit_and<>());
-            } break;
-            case op_land: {
+            } NEXT_OPCODE();
+            OPCODE(op_land) {
                 binaryArithmetic<JLong>(bit_and<>());
-            } break;
-            case op_ior: {
+            } NEXT_OPCODE();
+            OPCODE(op_ior) {
                 binaryArithmetic<JInt>(bit_or<>());
-            } break;
-            case op_lor: {
+            } NEXT_OPCODE();
+            OPCODE(op_lor) {
                 binaryArithmetic<JLong>(bit_or<>());
-            } break;
-            case op_ixor: {
+            } NEXT_OPCODE();
+            OPCODE(op_ixor) {
                 binaryArithmetic<JInt>(bit_xor<>());
-            } break;
-            case op_lxor: {
+            } NEXT_OPCODE();
+            OPCODE(op_lxor) {
                 binaryArithmetic<JLong>(bit_xor<>());
-            } break;
-            case op_iinc: {
-                const u1 index = code[++op];
-                const int8_t count = code[++op];
-                const int32_t extendedCount = count;
-                if (IS_JINT(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JInt *>(frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JLong(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JLong *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JFloat(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JFloat *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JDouble(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JDouble *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_i2l: {
+            } NEXT_OPCODE();
+            OPCODE(op_iinc) {
+                const DecodedInstruction &insn = decoded[op];
+                frames->top()->getLocalVariable(insn.operand).i +=
+                    insn.operand2;
+            } NEXT_OPCODE();
+            OPCODE(op_i2l) {
                 typeCast<JInt, JLong>();
-            } break;
-            case op_i2f: {
+            } NEXT_OPCODE();
+            OPCODE(op_i2f) {
                 typeCast<JInt, JFloat>();
-            } break;
-            case op_i2d: {
+            } NEXT_OPCODE();
+            OPCODE(op_i2d) {
                 typeCast<JInt, JDouble>();
-            } break;
-            case op_l2i: {
+            } NEXT_OPCODE();
+            OPCODE(op_l2i) {
                 typeCast<JLong, JInt>();
-            } break;
-            case op_l2f: {
+            } NEXT_OPCODE();
+            OPCODE(op_l2f) {
                 typeCast<JLong, JFloat>();
-            } break;
-            case op_l2d: {
+            } NEXT_OPCODE();
+            OPCODE(op_l2d) {
                 typeCast<JLong, JDouble>();
-            } break;
-            case op_f2i: {
+            } NEXT_OPCODE();
+            OPCODE(op_f2i) {
                 typeCast<JFloat, JInt>();
-            } break;
-            case op_f2l: {
+            } NEXT_OPCODE();
+            OPCODE(op_f2l) {
                 typeCast<JFloat, JLong>();
-            } break;
-            case op_f2d: {
+            } NEXT_OPCODE();
+            OPCODE(op_f2d) {
                 typeCast<JFloat, JDouble>();
-            } break;
-            case op_d2i: {
+            } NEXT_OPCODE();
+            OPCODE(op_d2i) {
                 typeCast<JDouble, JInt>();
-            } break;
-            case op_d2l: {
+            } NEXT_OPCODE();
+            OPCODE(op_d2l) {
                 typeCast<JDouble, JLong>();
-            } break;
-            case op_d2f: {
+            } NEXT_OPCODE();
+            OPCODE(op_d2f) {
                 typeCast<JDouble, JFloat>();
-            } break;
-            case op_i2c:
-            case op_i2b: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *result = new JInt;
-                result->val = (int8_t)(value->val);
-                frames->top()->push(result);
-
-            } break;
-            case op_i2s: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *result = new JInt;
-                result->val = (int16_t)(value->val);
-                frames->top()->push(result);
-
-            } break;
-            case op_lcmp: {
-                auto *value2 = frames->top()->pop<JLong>();
-                auto *value1 = frames->top()->pop<JLong>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (value1->val == value2->val) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_fcmpg:
-            case op_fcmpl: {
-                auto *value2 = frames->top()->pop<JFloat>();
-                auto *value1 = frames->top()->pop<JFloat>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (abs(value1->val - value2->val) < 0.000001) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_dcmpl:
-            case op_dcmpg: {
-                auto *value2 = frames->top()->pop<JDouble>();
-                auto *value1 = frames->top()->pop<JDouble>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (abs(value1->val - value2->val) < 0.000000000001) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_ifeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val == 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val != 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_iflt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val < 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifge: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val >= 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifgt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val > 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifle: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val <= 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val == value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val != value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmplt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val < value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpge: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val >= value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpgt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val > value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmple: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val <= value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_acmpeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JObject>();
-                auto *value1 = frames->top()->pop<JObject>();
-                if (value1->offset == value2->offset &&
-                    value1->jc == value2->jc) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_acmpne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JObject>();
-                auto *value1 = frames->top()->pop<JObject>();
-                if (value1->offset != value2->offset ||
-                    value1->jc != value2->jc) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_goto: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                op = currentOffset + branchindex;
-            } break;
-            case op_jsr: {
+            } NEXT_OPCODE();
+            OPCODE(op_i2c)
+            OPCODE(op_i2b) {
+                auto value = frames->top()->pop<JInt>();
+                frames->top()->push<JInt>((int8_t)(value));
+
+            } NEXT_OPCODE();
+            OPCODE(op_i2s) {
+                auto value = frames->top()->pop<JInt>();
+                frames->top()->push<JInt>((int16_t)(value));
+
+            } NEXT_OPCODE();
+            OPCODE(op_lcmp) {
+                auto value2 = frames->top()->pop<JLong>();
+                auto value1 = frames->top()->pop<JLong>();
+                frames->top()->push<JInt>(compareLong(value1, value2));
+            } NEXT_OPCODE();
+            OPCODE(op_fcmpg)
+            OPCODE(op_fcmpl) {
+                auto value2 = frames->top()->pop<JFloat>();
+                auto value1 = frames->top()->pop<JFloat>();
+                frames->top()->push<JInt>(compareFloat(value1, value2));
+            } NEXT_OPCODE();
+            OPCODE(op_dcmpl)
+            OPCODE(op_dcmpg) {
+                auto value2 = frames->top()->pop<JDouble>();
+                auto value1 = frames->top()->pop<JDouble>();
+                frames->top()->push<JInt>(compareDouble(value1, value2));
+            } NEXT_OPCODE();
+            OPCODE(op_ifeq) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value == 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_ifne) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value != 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_iflt) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value < 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_ifge) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value >= 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_ifgt) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value > 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_ifle) {
+                auto value = frames->top()->pop<JInt>();
+                BRANCH_IF(value <= 0, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmpeq) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 == value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmpne) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 != value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmplt) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 < value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmpge) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 >= value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmpgt) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 > value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_icmple) {
+                auto value2 = frames->top()->pop<JInt>();
+                auto value1 = frames->top()->pop<JInt>();
+                BRANCH_IF(value1 <= value2, op, decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_acmpeq) {
+                auto *value2 = frames->top()->pop<JRef>();
+                auto *value1 = frames->top()->pop<JRef>();
+                BRANCH_IF(isSameReference(value1, value2), op,
+                          decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_if_acmpne) {
+                auto *value2 = frames->top()->pop<JRef>();
+                auto *value1 = frames->top()->pop<JRef>();
+                BRANCH_IF(!isSameReference(value1, value2), op,
+                          decoded[op].target)
+
+            } NEXT_OPCODE();
+            OPCODE(op_goto) {
+                JUMP(op, decoded[op].target)
+            } NEXT_OPCODE();
+            OPCODE(op_jsr) {
                 throw runtime_error("unsupported opcode [jsr]");
-            } break;
-            case op_ret: {
+            } NEXT_OPCODE();
+            OPCODE(op_ret) {
                 throw runtime_error("unsupported opcode [ret]");
-            } break;
-            case op_tableswitch: {
-                u4 currentOffset = op - 1;
-                op++;
-                op++;
-                op++;  // 3 bytes padding
-                int32_t defaultIndex = consumeU4(code, op);
-                int32_t low = consumeU4(code, op);
-                int32_t high = consumeU4(code, op);
-                vector<int32_t> jumpOffset;
-                FOR_EACH(i, high - low + 1) {
-                    jumpOffset.push_back(consumeU4(code, op));
+            } NEXT_OPCODE();
+            OPCODE(op_tableswitch)
+            OPCODE(op_lookupswitch) {
+                const SwitchTable &table =
+                    decodedCode->getSwitchTable(decoded[op].operand);
+                CONTINUE_AT(table.lookup(frames->top()->pop<JInt>()))
+            } NEXT_OPCODE();
+            OPCODE(op_ireturn) {
+                RETURN_TO_CALLER(frames->top()->pop(), true);
+            } NEXT_OPCODE();
+            OPCODE(op_lreturn) {
+                RETURN_TO_CALLER(frames->top()->pop(), true);
+            } NEXT_OPCODE();
+            OPCODE(op_freturn) {
+                RETURN_TO_CALLER(frames->top()->pop(), true);
+            } NEXT_OPCODE();
+            OPCODE(op_dreturn) {
+                RETURN_TO_CALLER(frames->top()->pop(), true);
+            } NEXT_OPCODE();
+            OPCODE(op_areturn) {
+                RETURN_TO_CALLER(frames->top()->pop(), true);
+            } NEXT_OPCODE();
+            OPCODE(op_return) {
+                RETURN_TO_CALLER(JValue{}, false);
+            } NEXT_OPCODE();
+            OPCODE(op_getstatic) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                if (entry->staticSlot == nullptr) {
+                    throw runtime_error("can not find static field " +
+                                        entry->name);
                 }
-
-                auto *index = frames->top()->pop<JInt>();
-                if (index->val < low || index->val > high) {
-                    op = currentOffset + defaultIndex;
-                } else {
-                    op = currentOffset + jumpOffset[index->val - low];
+                runtime.cs->initClassIfAbsent(*this,
+                                              entry->jc->getClassName());
+                frames->top()->push(loadValue(*entry->staticSlot));
+                methodData->quicken(decoded[op].pc, op_getstatic_quick);
+            } NEXT_OPCODE();
+            OPCODE(op_getstatic_quick) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                frames->top()->push(loadValue(*entry->staticSlot));
+            } NEXT_OPCODE();
+            OPCODE(op_putstatic) {
+                const u2 index = decoded[op].operand;
+                JValue value = frames->top()->pop();
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                if (entry->staticSlot == nullptr) {
+                    throw runtime_error("can not find static field " +
+                                        entry->name);
                 }
-
-            } break;
-            case op_lookupswitch: {
-                u4 currentOffset = op - 1;
-                op++;
-                op++;
-                op++;  // 3 bytes padding
-                int32_t defaultIndex = consumeU4(code, op);
-                int32_t npair = consumeU4(code, op);
-                map<int32_t, int32_t> matchOffset;
-                FOR_EACH(i, npair) {
-                    matchOffset.insert(
-                        make_pair(consumeU4(code, op), consumeU4(code, op)));
+                runtime.cs->initClassIfAbsent(*this,
+                                              entry->jc->getClassName());
+                storeValue(*entry->staticSlot, value);
+                methodData->quicken(decoded[op].pc, op_putstatic_quick);
+            } NEXT_OPCODE();
+            OPCODE(op_putstatic_quick) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                storeValue(*entry->staticSlot, frames->top()->pop());
+            } NEXT_OPCODE();
+            OPCODE(op_getfield) {
+                const u2 index = decoded[op].operand;
+                JObject *objectref = frames->top()->pop<JObject>();
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
                 }
-                auto *key = frames->top()->pop<JInt>();
-                auto res = matchOffset.find(key->val);
-                if (res != matchOffset.end()) {
-                    op = currentOffset + (*res).second;
-                } else {
-                    op = currentOffset + defaultIndex;
+                frames->top()->push(
+                    runtime.heap->getField(*objectref, entry->instanceField));
+                methodData->quicken(decoded[op].pc, op_getfield_quick);
+            } NEXT_OPCODE();
+            OPCODE(op_getfield_quick) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                JObject *objectref = frames->top()->pop<JObject>();
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
                 }
-            } break;
-            case op_ireturn: {
-                return cloneValue(frames->top()->pop<JInt>());
-            } break;
-            case op_lreturn: {
-                return cloneValue(frames->top()->pop<JLong>());
-            } break;
-            case op_freturn: {
-                return cloneValue(frames->top()->pop<JFloat>());
-            } break;
-            case op_dreturn: {
-                return cloneValue(frames->top()->pop<JDouble>());
-            } break;
-            case op_areturn: {
-                return cloneValue(frames->top()->pop<JType>());
-            } break;
-            case op_return: {
-                return nullptr;
-            } break;
-            case op_getstatic: {
-                const u2 index = consumeU2(code, op);
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                runtime.cs->linkClassIfAbsent(symbolicRef.jc->getClassName());
-                runtime.cs->initClassIfAbsent(*this,
-                                          symbolicRef.jc->getClassName());
-                JType *field = symbolicRef.jc->getStaticVar(
-                    symbolicRef.name, symbolicRef.descriptor);
-                frames->top()->push(field);
-            } break;
-            case op_putstatic: {
-                u2 index = consumeU2(code, op);
-                JType *value = frames->top()->pop<JType>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-
-                runtime.cs->linkClassIfAbsent(symbolicRef.jc->getClassName());
-                runtime.cs->initClassIfAbsent(*this,
-                                          symbolicRef.jc->getClassName());
-                symbolicRef.jc->setStaticVar(symbolicRef.name,
-                                             symbolicRef.descriptor, value);
-            } break;
-            case op_getfield: {
-                u2 index = consumeU2(code, op);
+                frames->top()->push(
+                    runtime.heap->getField(*objectref, entry->instanceField));
+            } NEXT_OPCODE();
+            OPCODE(op_putfield) {
+                const u2 index = decoded[op].operand;
+                JValue value = frames->top()->pop();
                 JObject *objectref = frames->top()->pop<JObject>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                JType *field = cloneValue(runtime.heap->getFieldByName(
-                    symbolicRef.jc, symbolicRef.name, symbolicRef.descriptor,
-                    objectref));
-                frames->top()->push(field);
-
-            } break;
-            case op_putfield: {
-                const u2 index = consumeU2(code, op);
-                JType *value = frames->top()->pop<JType>();
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
+                }
+                runtime.heap->putField(*objectref, entry->instanceField,
+                                       value);
+                methodData->quicken(decoded[op].pc, op_putfield_quick);
+            } NEXT_OPCODE();
+            OPCODE(op_putfield_quick) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveField(index);
+                JValue value = frames->top()->pop();
                 JObject *objectref = frames->top()->pop<JObject>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                runtime.heap->putFieldByName(symbolicRef.jc, symbolicRef.name,
-                                          symbolicRef.descriptor, objectref,
-                                          value);
-
-            } break;
-            case op_invokevirtual: {
-                const u2 index = consumeU2(code, op);
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
+                }
+                runtime.heap->putField(*objectref, entry->instanceField,
+                                       value);
+            } NEXT_OPCODE();
+            OPCODE(op_invokevirtual) {
+                const u2 index = decoded[op].operand;
                 assert(typeid(*jc->raw.constPoolInfo[index]) ==
                        typeid(CONSTANT_Methodref));
 
-                auto symbolicRef = parseMethodSymbolicReference(jc, index);
-
-                if (symbolicRef.name == "<init>") {
-                    runtime_error(
+                const ResolvedEntry *entry = cpCache->resolveMethod(index);
+                if (entry->name == "<init>") {
+                    throw runtime_error(
                         "invoking method should not be instance "
                         "initialization method\n");
                 }
                 if (!IS_SIGNATURE_POLYMORPHIC_METHOD(
-                        symbolicRef.jc->getClassName(), symbolicRef.name)) {
-                    invokeVirtual(symbolicRef.name, symbolicRef.descriptor);
+                        entry->jc->getClassName(), entry->name)) {
+                    methodData->quicken(decoded[op].pc,
+                                        op_invokevirtual_quick);
+                    INVOKE_CALLSITE(selectVirtualCallSite(
+                        entry, methodData,
+                        methodData->getInlineCache(decoded[op].pc)));
                 } else {
                     // TODO:TO BE IMPLEMENTED
                 }
-
-            } break;
-            case op_invokespecial: {
-                const u2 index = consumeU2(code, op);
-                SymbolicRef symbolicRef;
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_InterfaceMethodref)) {
-                    symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Methodref)) {
-                    symbolicRef = parseMethodSymbolicReference(jc, index);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-
-                // If all of the following are true, let C be the direct
-                // superclass of the current class :
-                JavaClass *symbolicRefClass = symbolicRef.jc;
-                if ("<init>" != symbolicRef.name) {
-                    if (!IS_CLASS_INTERFACE(
-                            symbolicRefClass->raw.accessFlags)) {
-                        if (symbolicRefClass->getClassName() ==
-                            jc->getSuperClassName()) {
-                            if (IS_CLASS_SUPER(jc->raw.accessFlags)) {
-                                invokeSpecial(runtime.cs->findJavaClass(
-                                                  jc->getSuperClassName()),
-                                              symbolicRef.name,
-                                              symbolicRef.descriptor);
-                                break;
-                            }
-                        }
-                    }
-                }
-                // Otherwise let C be the symbolic reference class
-                invokeSpecial(symbolicRef.jc, symbolicRef.name,
-                              symbolicRef.descriptor);
-            } break;
-            case op_invokestatic: {
+            } NEXT_OPCODE();
+            OPCODE(op_invokevirtual_quick) {
+                const u2 index = decoded[op].operand;
+                INVOKE_CALLSITE(selectVirtualCallSite(
+                    cpCache->resolveMethod(index), methodData,
+                    methodData->getInlineCache(decoded[op].pc)));
+            } NEXT_OPCODE();
+            OPCODE(op_invokespecial) {
+                const u2 index = decoded[op].operand;
+                // The resolved method is also the selected one. When the
+                // superclass rule of invokespecial applies, the referred class
+                // is already the direct superclass of current class
+                const ResolvedEntry *entry = cpCache->resolveMethod(index);
+                if (!entry->csite.isCallable() ||
+                    IS_METHOD_STATIC(entry->csite.accessFlags)) {
+                    throw runtime_error("can not find method " + entry->name +
+                                        " " + entry->descriptor);
+                }
+                methodData->quicken(decoded[op].pc, op_invokespecial_quick);
+                INVOKE_CALLSITE(entry->csite);
+            } NEXT_OPCODE();
+            OPCODE(op_invokespecial_quick) {
+                const u2 index = decoded[op].operand;
+                INVOKE_CALLSITE(cpCache->resolveMethod(index)->csite);
+            } NEXT_OPCODE();
+            OPCODE(op_invokestatic) {
                 // Invoke a class (static) method
-                const u2 index = consumeU2(code, op);
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_InterfaceMethodref)) {
-                    auto symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                    invokeStatic(symbolicRef.jc, symbolicRef.name,
-                                 symbolicRef.descriptor);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Methodref)) {
-                    auto symbolicRef = parseMethodSymbolicReference(jc, index);
-                    invokeStatic(symbolicRef.jc, symbolicRef.name,
-                                 symbolicRef.descriptor);
-                } else {
-                    SHOULD_NOT_REACH_HERE
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveMethod(index);
+                if (!entry->csite.isCallable() ||
+                    !IS_METHOD_STATIC(entry->csite.accessFlags)) {
+                    throw runtime_error("can not find method " + entry->name +
+                                        " " + entry->descriptor);
                 }
-            } break;
-            case op_invokeinterface: {
-                const u2 index = consumeU2(code, op);
-                ++op;  // read count and discard
-                ++op;  // opcode padding 0;
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
+                runtime.cs->initClassIfAbsent(*this,
+                                              entry->jc->getClassName());
+                methodData->quicken(decoded[op].pc, op_invokestatic_quick);
+                INVOKE_CALLSITE(entry->csite);
+            } NEXT_OPCODE();
+            OPCODE(op_invokestatic_quick) {
+                const u2 index = decoded[op].operand;
+                INVOKE_CALLSITE(cpCache->resolveMethod(index)->csite);
+            } NEXT_OPCODE();
+            OPCODE(op_invokeinterface) {
+                const u2 index = decoded[op].operand;
+                if (typeid(*jc->raw.constPoolInfo[index]) !=
                     typeid(CONSTANT_InterfaceMethodref)) {
-                    auto symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                    invokeInterface(symbolicRef.jc, symbolicRef.name,
-                                    symbolicRef.descriptor);
+                    SHOULD_NOT_REACH_HERE
                 }
-            } break;
-            case op_invokedynamic: {
+                methodData->quicken(decoded[op].pc, op_invokeinterface_quick);
+                // Interface methods are selected from receiver's class, which
+                // is the same as what invokevirtual does
+                INVOKE_CALLSITE(selectVirtualCallSite(
+                    cpCache->resolveMethod(index), methodData,
+                    methodData->getInlineCache(decoded[op].pc)));
+            } NEXT_OPCODE();
+            OPCODE(op_invokeinterface_quick) {
+                const u2 index = decoded[op].operand;
+                INVOKE_CALLSITE(selectVirtualCallSite(
+                    cpCache->resolveMethod(index), methodData,
+                    methodData->getInlineCache(decoded[op].pc)));
+            } NEXT_OPCODE();
+            OPCODE(op_invokedynamic) {
                 throw runtime_error("unsupported opcode [invokedynamic]");
-            } break;
-            case op_new: {
-                const u2 index = consumeU2(code, op);
+            } NEXT_OPCODE();
+            OPCODE(op_new) {
+                const u2 index = decoded[op].operand;
                 JObject *objectref = execNew(jc, index);
-                frames->top()->push(objectref);
-            } break;
-            case op_newarray: {
-                const u1 atype = code[++op];
-                JInt *count = frames->top()->pop<JInt>();
+                frames->top()->push<JObject>(objectref);
+            } NEXT_OPCODE();
+            OPCODE(op_newarray) {
+                const u1 atype = decoded[op].operand;
+                auto count = frames->top()->pop<JInt>();
 
-                if (count->val < 0) {
+                if (count < 0) {
                     throw runtime_error("negative array size");
                 }
                 JArray *arrayref =
-                    runtime.heap->createPODArray(atype, count->val);
+                    runtime.heap->createPODArray(atype, count);
 
-                frames->top()->push(arrayref);
+                frames->top()->push<JArray>(arrayref);
 
-            } break;
-            case op_anewarray: {
-                const u2 index = consumeU2(code, op);
-                auto symbolicRef = parseClassSymbolicReference(jc, index);
-                JInt *count = frames->top()->pop<JInt>();
+            } NEXT_OPCODE();
+            OPCODE(op_anewarray) {
+                const u2 index = decoded[op].operand;
+                const ResolvedEntry *entry = cpCache->resolveClass(index);
+                auto count = frames->top()->pop<JInt>();
 
-                if (count->val < 0) {
+                if (count < 0) {
                     throw runtime_error("negative array size");
                 }
-                JArray *arrayref = runtime.heap->createObjectArray(*symbolicRef.jc, count->val);
+                if (entry->jc == nullptr) {
+                    throw runtime_error("unsupported array component type " +
+                                        entry->name);
+                }
+                JArray *arrayref =
+                    runtime.heap->createObjectArray(*entry->jc, count);
 
-                frames->top()->push(arrayref);
-            } break;
-            case op_arraylength: {
+                frames->top()->push<JArray>(arrayref);
+            } NEXT_OPCODE();
+            OPCODE(op_arraylength) {
                 JArray *arrayref = frames->top()->pop<JArray>();
 
                 if (arrayref == nullptr) {
                     throw runtime_error("null pointer\n");
                 }
-                JInt *length = new JInt;
-                length->val = arrayref->length;
-                frames->top()->push(length);
+                frames->top()->push<JInt>(arrayref->length);
 
-            } break;
-            case op_athrow: {
+            } NEXT_OPCODE();
+            OPCODE(op_athrow) {
                 auto *throwobj = frames->top()->pop<JObject>();
                 if (throwobj == nullptr) {
                     throw runtime_error("null pointer");
@@ -1306,172 +1424,1362 @@ JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
                     throw runtime_error("it's not a throwable object");
                 }
 
-                if (handleException(jc, exceptLen, exceptTab, throwobj, op)) {
+                u4 pc = decoded[op].pc;
+                if (handleException(jc, exceptLen, exceptTab, throwobj, pc)) {
                     while (!frames->top()->emptyStack()) {
-                        frames->top()->pop<JType>();
+                        frames->top()->pop();
                     }
-                    frames->top()->push(throwobj);
+                    frames->top()->push<JObject>(throwobj);
+                    CONTINUE_AT(decodedCode->indexOf(pc))
                 } else /* Exception can not handled within method handlers */ {
                     exception.markException();
                     exception.setThrowExceptionInfo(throwobj);
-                    return throwobj;
+                    PROPAGATE_EXCEPTION(throwobj);
                 }
-            } break;
-            case op_checkcast: {
+            } NEXT_OPCODE();
+            OPCODE(op_checkcast) {
                 throw runtime_error("unsupported opcode [checkcast]");
-            } break;
-            case op_instanceof: {
-                const u2 index = consumeU2(code, op);
+            } NEXT_OPCODE();
+            OPCODE(op_instanceof) {
+                const u2 index = decoded[op].operand;
                 auto *objectref = frames->top()->pop<JObject>();
                 if (objectref == nullptr) {
-                    frames->top()->push(new JInt(0));
-                }
-                if (checkInstanceof(jc, index, objectref)) {
-                    frames->top()->push(new JInt(1));
+                    frames->top()->push<JInt>(0);
+                } else if (checkInstanceof(jc, index, objectref)) {
+                    frames->top()->push<JInt>(1);
                 } else {
-                    frames->top()->push(new JInt(0));
+                    frames->top()->push<JInt>(0);
                 }
-            } break;
-            case op_monitorenter: {
-                JType *ref = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_monitorenter) {
+                JType *ref = frames->top()->pop<JRef>();
 
                 if (ref == nullptr) {
                     throw runtime_error("null pointer");
                 }
 
                 if (!runtime.heap->hasMonitor(ref)) {
-                    dynamic_cast<JObject *>(ref)->offset =
-                        runtime.heap->createMonitor();
+                    runtime.heap->createMonitor(ref);
                 }
                 runtime.heap->findMonitor(ref)->enter(this_thread::get_id());
-            } break;
-            case op_monitorexit: {
-                JType *ref = frames->top()->pop<JType>();
+            } NEXT_OPCODE();
+            OPCODE(op_monitorexit) {
+                JType *ref = frames->top()->pop<JRef>();
 
                 if (ref == nullptr) {
                     throw runtime_error("null pointer");
                 }
                 if (!runtime.heap->hasMonitor(ref)) {
-                    dynamic_cast<JObject *>(ref)->offset =
-                        runtime.heap->createMonitor();
+                    runtime.heap->createMonitor(ref);
                 }
                 runtime.heap->findMonitor(ref)->exit();
 
+            } NEXT_OPCODE();
+            OPCODE(op_wide) {
+                throw runtime_error("unsupported opcode [wide]");
+            } NEXT_OPCODE();
+            OPCODE(op_multianewarray) {
+                throw runtime_error("unsupported opcode [multianewarray]");
+            } NEXT_OPCODE();
+            OPCODE(op_ifnull) {
+                JObject *value = frames->top()->pop<JObject>();
+                BRANCH_IF(value == nullptr, op, decoded[op].target)
+            } NEXT_OPCODE();
+            OPCODE(op_ifnonnull) {
+                JObject *value = frames->top()->pop<JObject>();
+                BRANCH_IF(value != nullptr, op, decoded[op].target)
+            } NEXT_OPCODE();
+            OPCODE(op_goto_w) {
+                JUMP(op, decoded[op].target)
+            } NEXT_OPCODE();
+            OPCODE(op_jsr_w) {
+                throw runtime_error("unsupported opcode [jsr_w]");
+            } NEXT_OPCODE();
+            OPCODE(op_aload_0_getfield) {
+                const DecodedInstruction &field = decoded[op + 1];
+                if (field.opcode == op_getfield_quick) {
+                    const ResolvedEntry *entry =
+                        cpCache->resolveField(field.operand);
+                    auto *objectref =
+                        frames->top()->getLocalVariable(0).as<JObject>();
+                    if (objectref == nullptr) {
+                        throw runtime_error("null pointer");
+                    }
+                    frames->top()->push(runtime.heap->getField(
+                        *objectref, entry->instanceField));
+                    CONTINUE_AT(op + 2)
+                } else {
+                    // getfield is executed by itself until it's quickened
+                    frames->top()->load<JRef>(0);
+                }
+            } NEXT_OPCODE();
+            OPCODE(op_iload_iload_iadd_istore) {
+                const u4 index1 = decoded[op].operand;
+                const u4 index2 = decoded[op + 1].operand;
+                const u4 index3 = decoded[op + 3].operand;
+                frames->top()->getLocalVariable(index3) = JValue::of<JInt>(
+                    frames->top()->getLocalVariable(index1).i +
+                    frames->top()->getLocalVariable(index2).i);
+                CONTINUE_AT(op + 4)
+            } NEXT_OPCODE();
+            OPCODE(op_iload_bipush_if_icmpge) {
+                const u4 index = decoded[op].operand;
+                const int32_t value = decoded[op + 1].operand;
+                BRANCH_IF(frames->top()->getLocalVariable(index).i >= value,
+                          op + 2, decoded[op + 2].target)
+                CONTINUE_AT(op + 3)
+            } NEXT_OPCODE();
+            OPCODE(op_iinc_goto) {
+                const DecodedInstruction &inc = decoded[op];
+                frames->top()->getLocalVariable(inc.operand).i += inc.operand2;
+                JUMP(op + 1, decoded[op + 1].target)
+            } NEXT_OPCODE();
+            OPCODE(op_breakpoint)
+            OPCODE(op_impdep1)
+            OPCODE(op_impdep2) {
+                // Reserved opcodde
+                cerr << "Are you a dot.class hacker? Or you were entered a "
+                        "strange region.";
+                exit(EXIT_FAILURE);
+            } NEXT_OPCODE();
+            DEFAULT_OPCODE
+                cerr << "The YVM can not recognize this opcode. Bytecode file "
+                        "was be corrupted.";
+                exit(EXIT_FAILURE);
+        }
+    // Top frame runs as register code or machine code until it returns, or
+    // calls a method which then continues in this loop
+    runRegisterFrame: {
+        JValue result;
+        if (!execRegisterFrame(result)) {
+            if (frames->top()->registerCode != nullptr) {
+                goto runRegisterFrame;
+            }
+            LOAD_METHOD_CONTEXT();
+            CONTINUE_AT(0)
+        }
+        if (exception.hasUnhandledException()) {
+            PROPAGATE_EXCEPTION(result.as<JObject>())
+        }
+        const bool hasResult =
+            frames->top()->method->getReturnType() != T_EXTRA_VOID;
+        RETURN_TO_CALLER(result, hasResult)
+        NEXT_OPCODE();
+    }
+    }
+    return JValue{};
+}
+
+//--------------------------------------------------------------------------------
+// Bytecode interpretation with stack caching. Up to two values on top of the
+// operand stack are kept in local variables tos and nos rather than in stack
+// slots, so that compilers can keep them in machine registers. The number of
+// cached values is the state of the interpreter, it's dispatched together
+// with the opcode and every instruction that works on the cache has a handler
+// for each state. Instructions without one, like calls and allocation, are
+// run after the cache is spilled into stack slots, therefore frames always
+// look complete to callees, GC and OSR. Methods using anything that needs
+// an exact operand stack in the middle of an instruction, exception handlers
+// for instance, are not run by it, see canCacheStack()
+//--------------------------------------------------------------------------------
+bool Interpreter::canCacheStack(const u1 *code, u4 codeLength,
+                                u2 exceptionTableLength) {
+    if (exceptionTableLength != 0) {
+        return false;
+    }
+    for (u4 pc = 0; pc < codeLength; pc += instructionLength(code, pc)) {
+        switch (code[pc]) {
+            case op_dup_x2:
+            case op_dup2_x1:
+            case op_dup2_x2:
+            case op_jsr:
+            case op_ret:
+            case op_tableswitch:
+            case op_lookupswitch:
+            case op_invokedynamic:
+            case op_athrow:
+            case op_checkcast:
+            case op_monitorenter:
+            case op_monitorexit:
+            case op_wide:
+            case op_multianewarray:
+            case op_goto_w:
+            case op_jsr_w:
+                return false;
+            default:
+                if (code[pc] >= op_breakpoint) {
+                    return false;
+                }
+        }
+    }
+    return true;
+}
+
+// Store value into local variable index, the second slot of long and double
+// is not addressable
+static forceinline void storeLocal(JValue *locals, u1 index,
+                                   const JValue &value) {
+    locals[index] = value;
+    if (value.isWide()) {
+        locals[index + 1].tag = ValueTag::Empty;
+    }
+}
+
+template <typename Type, typename Element>
+static JValue loadArrayElement(const JArray *arrayref, int32_t index) {
+    return JValue::of<Type>(arrayElement<Element>(arrayref, index));
+}
+
+// value is taken by copy, so that cached values never have their addresses
+// escape and stay in registers
+static void storeArrayElement(JArray *arrayref, int32_t index, JValue value) {
+    if (arrayref == nullptr) {
+        throw runtime_error("null pointer");
+    }
+    if (index >= arrayref->length || index < 0) {
+        throw runtime_error("array index out of bounds");
+    }
+    runtime.heap->putElement(*arrayref, index, value);
+}
+
+#define CACHED(state, opcode) case (state) << 8 | (opcode)
+
+// Continue at the next instruction with newState values cached, op is the
+// index of current instruction in decoded code like that of execByteCode()
+#define CACHED_NEXT(newState) \
+    {                         \
+        state = (newState);   \
+        op++;                 \
+        continue;             \
+    }
+
+#define SPILL_CACHE()         \
+    {                         \
+        if (state == 2) {     \
+            frame->push(nos); \
+        }                     \
+        if (state != 0) {     \
+            frame->push(tos); \
+        }                     \
+        state = 0;            \
+    }
+
+// Jump to the target of current instruction. Like JUMP(), backward jumps are
+// counted and may continue current activation in a faster tier, which needs
+// an exact operand stack
+#define CACHED_JUMP()                                                 \
+    {                                                                 \
+        const u4 jumpTarget = decoded[op].target;                     \
+        if (jumpTarget <= op) {                                       \
+            methodData->countBackedge();                              \
+            if (const RegisterCode *osrCode =                         \
+                    runtime.tierPolicy->osrCodeOf(jc, methodData)) {  \
+                SPILL_CACHE()                                         \
+                JValue osrResult;                                     \
+                if (execOsrCode(jc, methodData, *osrCode,             \
+                                decoded[jumpTarget].pc, osrResult)) { \
+                    if (exception.hasUnhandledException()) {          \
+                        CACHED_PROPAGATE(osrResult.as<JObject>())     \
+                    }                                                 \
+                    const bool osrHasResult =                         \
+                        methodData->getReturnType() != T_EXTRA_VOID;  \
+                    CACHED_RETURN(osrResult, osrHasResult)            \
+                }                                                     \
+            }                                                         \
+        }                                                             \
+        op = jumpTarget;                                              \
+        continue;                                                     \
+    }
+
+#define CACHED_BRANCH(taken)                                \
+    {                                                       \
+        methodData->profileBranch(decoded[op].pc, (taken)); \
+        if (taken) {                                        \
+            CACHED_JUMP()                                   \
+        }                                                   \
+        op++;                                               \
+        continue;                                           \
+    }
+
+// Handlers of all states, values pushed or popped by an instruction reach
+// the cache or stack slots through fallthrough from the states before
+#define CACHED_PUSH(opcode, value) \
+    CACHED(2, opcode):             \
+        frame->push(nos);          \
+        YVM_FALLTHROUGH;           \
+    CACHED(1, opcode):             \
+        nos = tos;                 \
+        tos = (value);             \
+        CACHED_NEXT(2)             \
+    CACHED(0, opcode):             \
+        tos = (value);             \
+        CACHED_NEXT(1)
+
+#define CACHED_UNARY(opcode, value) \
+    CACHED(0, opcode):              \
+        tos = frame->pop();         \
+        YVM_FALLTHROUGH;            \
+    CACHED(1, opcode):              \
+        tos = (value);              \
+        CACHED_NEXT(1)              \
+    CACHED(2, opcode):              \
+        tos = (value);              \
+        CACHED_NEXT(2)
+
+#define CACHED_BINARY(opcode, value) \
+    CACHED(0, opcode):               \
+        tos = frame->pop();          \
+        YVM_FALLTHROUGH;             \
+    CACHED(1, opcode):               \
+        nos = frame->pop();          \
+        YVM_FALLTHROUGH;             \
+    CACHED(2, opcode):               \
+        tos = (value);               \
+        CACHED_NEXT(1)
+
+#define CACHED_ARITHMETIC(opcode, type, function) \
+    CACHED_BINARY(opcode, JValue::of<type>(       \
+                              function(nos.as<type>(), tos.as<type>())))
+
+#define CACHED_STORE(opcode, index)       \
+    CACHED(0, opcode):                    \
+        tos = frame->pop();               \
+        YVM_FALLTHROUGH;                  \
+    CACHED(1, opcode):                    \
+        storeLocal(locals, (index), tos); \
+        CACHED_NEXT(0)                    \
+    CACHED(2, opcode):                    \
+        storeLocal(locals, (index), tos); \
+        tos = nos;                        \
+        CACHED_NEXT(1)
+
+#define CACHED_ARRAY_STORE(opcode, value)                               \
+    CACHED(0, opcode):                                                  \
+        tos = frame->pop();                                             \
+        YVM_FALLTHROUGH;                                                \
+    CACHED(1, opcode):                                                  \
+        nos = frame->pop();                                             \
+        YVM_FALLTHROUGH;                                                \
+    CACHED(2, opcode):                                                  \
+        storeArrayElement(frame->pop<JArray>(), nos.as<JInt>(), (value)); \
+        CACHED_NEXT(0)
+
+#define CACHED_IF(opcode, condition)        \
+    CACHED(0, opcode):                      \
+        tos = frame->pop();                 \
+        YVM_FALLTHROUGH;                    \
+    CACHED(1, opcode): {                    \
+        const bool taken = (condition);     \
+        state = 0;                          \
+        CACHED_BRANCH(taken)                \
+    }                                       \
+    CACHED(2, opcode): {                    \
+        const bool taken = (condition);     \
+        tos = nos;                          \
+        state = 1;                          \
+        CACHED_BRANCH(taken)                \
+    }
+
+#define CACHED_IF_CMP(opcode, condition)    \
+    CACHED(0, opcode):                      \
+        tos = frame->pop();                 \
+        YVM_FALLTHROUGH;                    \
+    CACHED(1, opcode):                      \
+        nos = frame->pop();                 \
+        YVM_FALLTHROUGH;                    \
+    CACHED(2, opcode): {                    \
+        const bool taken = (condition);     \
+        state = 0;                          \
+        CACHED_BRANCH(taken)                \
+    }
+
+// Handler of every state for instructions that leave the cache alone
+#define CACHED_ANY(opcode) \
+    CACHED(0, opcode):     \
+    CACHED(1, opcode):     \
+    CACHED(2, opcode)
+
+// Like execByteCode(), methods run with stack caching call each other within
+// one activation. Frame on top of the frame stack is the method to continue
+#define LOAD_CACHED_CONTEXT()                       \
+    {                                               \
+        frame = frames->top();                      \
+        jc = frame->jc;                             \
+        cpCache = jc->getConstPoolCache();          \
+        methodData = frame->method;                 \
+        decodedCode = methodData->getDecodedCode(); \
+        decoded = decodedCode->getInstructions();   \
+        locals = frame->localSlots;                 \
+    }
+
+// Call csite with spilled operand stack, it continues at the first
+// instruction of callee if callee runs with stack caching as well. Caller
+// resumes at op once callee returns
+#define CACHED_INVOKE(csite)                                      \
+    {                                                             \
+        const CallSite &callee = (csite);                         \
+        if (callee.data->getTrivialKind() != TrivialKind::None && \
+            invokeTrivialMethod(callee)) {                        \
+            /* Ran in current frame */                            \
+        } else if (IS_METHOD_NATIVE(callee.accessFlags) ||        \
+                   runtime.tierPolicy->registerCodeOf(callee) !=  \
+                       nullptr ||                                 \
+                   !isStackCached(callee)) {                      \
+            invokeCallSite(callee);                               \
+            if (exception.hasUnhandledException()) {              \
+                CACHED_PROPAGATE(frame->pop<JObject>())           \
+            }                                                     \
+        } else {                                                  \
+            frame->pc = decoded[op].pc;                           \
+            enterMethod(callee);                                  \
+            LOAD_CACHED_CONTEXT();                                \
+            op = 0;                                               \
+        }                                                         \
+    }
+
+// Return to the caller in this activation with empty cache, only the method
+// that the activation was entered with returns to C++ code
+#define CACHED_RETURN(returnValue, hasValue)                     \
+    {                                                            \
+        const JValue value = (returnValue);                      \
+        if (frames->depth() == entryDepth) {                     \
+            return value;                                        \
+        }                                                        \
+        frames->popFrame();                                      \
+        LOAD_CACHED_CONTEXT();                                   \
+        if (hasValue) {                                          \
+            frame->push(value);                                  \
+        }                                                        \
+        op = decodedCode->indexOf(frame->pc);                    \
+        state = 0;                                               \
+        GC_SAFE_POINT                                            \
+        if (runtime.gc->shallGC()) {                             \
+            runtime.gc->stopTheWorld();                          \
+            runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP); \
+        }                                                        \
+        continue;                                                \
+    }
+
+// Methods run with stack caching have no exception handlers, so throwobj
+// unwinds all frames of this activation and is left to C++ caller
+#define CACHED_PROPAGATE(throwobj)                          \
+    {                                                       \
+        JObject *propagated = (throwobj);                   \
+        u4 handlerPc;                                       \
+        unwindException(propagated, entryDepth, handlerPc); \
+        return JValue::of<JObject>(propagated);             \
+    }
+
+JValue Interpreter::execStackCachedCode(const CallSite &csite) {
+    // Frame of csite has been pushed by caller
+    Slots *frame = frames->top();
+    frame->jc = csite.jc;
+    frame->method = csite.data;
+
+    const size_t entryDepth = frames->depth();
+    const JavaClass *jc = csite.jc;
+    ConstPoolCache *cpCache = jc->getConstPoolCache();
+    MethodData *methodData = csite.data;
+    const DecodedCode *decodedCode = methodData->getDecodedCode();
+    const DecodedInstruction *decoded = decodedCode->getInstructions();
+    JValue *locals = frame->localSlots;
+    JValue tos;
+    JValue nos;
+    int state = 0;
+#ifdef YVM_DISPATCH_STATS
+    DispatchCounter dispatched;
+#endif
+    for (u4 op = 0;;) {
+        COUNT_DISPATCH
+        u1 opcode = decoded[op].opcode;
+    dispatch:
+        switch (state << 8 | opcode) {
+            CACHED_ANY(op_nop):
+                CACHED_NEXT(state)
+            CACHED_PUSH(op_aconst_null, JValue::of<JRef>(nullptr))
+            CACHED_PUSH(op_iconst_m1, JValue::of<JInt>(-1))
+            CACHED_PUSH(op_iconst_0, JValue::of<JInt>(0))
+            CACHED_PUSH(op_iconst_1, JValue::of<JInt>(1))
+            CACHED_PUSH(op_iconst_2, JValue::of<JInt>(2))
+            CACHED_PUSH(op_iconst_3, JValue::of<JInt>(3))
+            CACHED_PUSH(op_iconst_4, JValue::of<JInt>(4))
+            CACHED_PUSH(op_iconst_5, JValue::of<JInt>(5))
+            CACHED_PUSH(op_lconst_0, JValue::of<JLong>(0))
+            CACHED_PUSH(op_lconst_1, JValue::of<JLong>(1))
+            CACHED_PUSH(op_fconst_0, JValue::of<JFloat>(0.0f))
+            CACHED_PUSH(op_fconst_1, JValue::of<JFloat>(1.0f))
+            CACHED_PUSH(op_fconst_2, JValue::of<JFloat>(2.0f))
+            CACHED_PUSH(op_dconst_0, JValue::of<JDouble>(0.0))
+            CACHED_PUSH(op_dconst_1, JValue::of<JDouble>(1.0))
+            CACHED_PUSH(op_bipush, JValue::of<JInt>(decoded[op].operand))
+            CACHED_PUSH(op_sipush, JValue::of<JInt>(decoded[op].operand))
+            CACHED_PUSH(op_iload, locals[decoded[op].operand])
+            CACHED_PUSH(op_lload, locals[decoded[op].operand])
+            CACHED_PUSH(op_fload, locals[decoded[op].operand])
+            CACHED_PUSH(op_dload, locals[decoded[op].operand])
+            CACHED_PUSH(op_aload, locals[decoded[op].operand])
+            CACHED_PUSH(op_iload_0, locals[0])
+            CACHED_PUSH(op_iload_1, locals[1])
+            CACHED_PUSH(op_iload_2, locals[2])
+            CACHED_PUSH(op_iload_3, locals[3])
+            CACHED_PUSH(op_lload_0, locals[0])
+            CACHED_PUSH(op_lload_1, locals[1])
+            CACHED_PUSH(op_lload_2, locals[2])
+            CACHED_PUSH(op_lload_3, locals[3])
+            CACHED_PUSH(op_fload_0, locals[0])
+            CACHED_PUSH(op_fload_1, locals[1])
+            CACHED_PUSH(op_fload_2, locals[2])
+            CACHED_PUSH(op_fload_3, locals[3])
+            CACHED_PUSH(op_dload_0, locals[0])
+            CACHED_PUSH(op_dload_1, locals[1])
+            CACHED_PUSH(op_dload_2, locals[2])
+            CACHED_PUSH(op_dload_3, locals[3])
+            CACHED_PUSH(op_aload_0, locals[0])
+            CACHED_PUSH(op_aload_1, locals[1])
+            CACHED_PUSH(op_aload_2, locals[2])
+            CACHED_PUSH(op_aload_3, locals[3])
+            CACHED_BINARY(
+                op_iaload,
+                (loadArrayElement<JInt, int32_t>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_laload,
+                (loadArrayElement<JLong, int64_t>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_faload,
+                (loadArrayElement<JFloat, float>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_daload,
+                (loadArrayElement<JDouble, double>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_aaload,
+                (loadArrayElement<JRef, JType *>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_baload,
+                (loadArrayElement<JInt, int8_t>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_caload,
+                (loadArrayElement<JInt, uint16_t>(nos.as<JArray>(), tos.i)))
+            CACHED_BINARY(
+                op_saload,
+                (loadArrayElement<JInt, int16_t>(nos.as<JArray>(), tos.i)))
+            CACHED_STORE(op_istore, decoded[op].operand)
+            CACHED_STORE(op_lstore, decoded[op].operand)
+            CACHED_STORE(op_fstore, decoded[op].operand)
+            CACHED_STORE(op_dstore, decoded[op].operand)
+            CACHED_STORE(op_astore, decoded[op].operand)
+            CACHED_STORE(op_istore_0, 0)
+            CACHED_STORE(op_istore_1, 1)
+            CACHED_STORE(op_istore_2, 2)
+            CACHED_STORE(op_istore_3, 3)
+            CACHED_STORE(op_lstore_0, 0)
+            CACHED_STORE(op_lstore_1, 1)
+            CACHED_STORE(op_lstore_2, 2)
+            CACHED_STORE(op_lstore_3, 3)
+            CACHED_STORE(op_fstore_0, 0)
+            CACHED_STORE(op_fstore_1, 1)
+            CACHED_STORE(op_fstore_2, 2)
+            CACHED_STORE(op_fstore_3, 3)
+            CACHED_STORE(op_dstore_0, 0)
+            CACHED_STORE(op_dstore_1, 1)
+            CACHED_STORE(op_dstore_2, 2)
+            CACHED_STORE(op_dstore_3, 3)
+            CACHED_STORE(op_astore_0, 0)
+            CACHED_STORE(op_astore_1, 1)
+            CACHED_STORE(op_astore_2, 2)
+            CACHED_STORE(op_astore_3, 3)
+            CACHED_ARRAY_STORE(op_iastore, tos)
+            CACHED_ARRAY_STORE(op_lastore, tos)
+            CACHED_ARRAY_STORE(op_fastore, tos)
+            CACHED_ARRAY_STORE(op_dastore, tos)
+            CACHED_ARRAY_STORE(op_aastore, tos)
+            CACHED_ARRAY_STORE(op_bastore,
+                               JValue::of<JInt>(static_cast<int8_t>(tos.i)))
+            CACHED_ARRAY_STORE(op_castore,
+                               JValue::of<JInt>(static_cast<int16_t>(tos.i)))
+            CACHED_ARRAY_STORE(op_sastore,
+                               JValue::of<JInt>(static_cast<int16_t>(tos.i)))
+            CACHED(0, op_pop):
+                frame->pop();
+                CACHED_NEXT(0)
+            CACHED(1, op_pop):
+                CACHED_NEXT(0)
+            CACHED(2, op_pop):
+                tos = nos;
+                CACHED_NEXT(1)
+            CACHED(0, op_dup):
+                tos = frame->pop();
+                nos = tos;
+                CACHED_NEXT(2)
+            CACHED(2, op_dup):
+                frame->push(nos);
+                YVM_FALLTHROUGH;
+            CACHED(1, op_dup):
+                nos = tos;
+                CACHED_NEXT(2)
+            CACHED_ARITHMETIC(op_iadd, JInt, plus<>())
+            CACHED_ARITHMETIC(op_ladd, JLong, plus<>())
+            CACHED_ARITHMETIC(op_fadd, JFloat, plus<>())
+            CACHED_ARITHMETIC(op_dadd, JDouble, plus<>())
+            CACHED_ARITHMETIC(op_isub, JInt, minus<>())
+            CACHED_ARITHMETIC(op_lsub, JLong, minus<>())
+            CACHED_ARITHMETIC(op_fsub, JFloat, minus<>())
+            CACHED_ARITHMETIC(op_dsub, JDouble, minus<>())
+            CACHED_ARITHMETIC(op_imul, JInt, multiplies<>())
+            CACHED_ARITHMETIC(op_lmul, JLong, multiplies<>())
+            CACHED_ARITHMETIC(op_fmul, JFloat, multiplies<>())
+            CACHED_ARITHMETIC(op_dmul, JDouble, multiplies<>())
+            CACHED_ARITHMETIC(op_idiv, JInt, divides<>())
+            CACHED_ARITHMETIC(op_ldiv, JLong, divides<>())
+            CACHED_ARITHMETIC(op_fdiv, JFloat, divides<>())
+            CACHED_ARITHMETIC(op_ddiv, JDouble, divides<>())
+            CACHED_ARITHMETIC(op_irem, JInt, modulus<>())
+            CACHED_ARITHMETIC(op_lrem, JLong, modulus<>())
+            CACHED_ARITHMETIC(op_frem, JFloat, std::fmod)
+            CACHED_ARITHMETIC(op_drem, JDouble, std::fmod)
+            CACHED_UNARY(op_ineg, JValue::of<JInt>(-tos.as<JInt>()))
+            CACHED_UNARY(op_lneg, JValue::of<JLong>(-tos.as<JLong>()))
+            CACHED_UNARY(op_fneg, JValue::of<JFloat>(-tos.as<JFloat>()))
+            CACHED_UNARY(op_dneg, JValue::of<JDouble>(-tos.as<JDouble>()))
+            CACHED_ARITHMETIC(op_ishl, JInt, intShiftLeft)
+            CACHED_ARITHMETIC(op_lshl, JLong, longShiftLeft)
+            CACHED_ARITHMETIC(op_ishr, JInt, intShiftRight)
+            CACHED_ARITHMETIC(op_lshr, JLong, longShiftRight)
+            CACHED_ARITHMETIC(op_iushr, JInt, intUnsignedShiftRight)
+            CACHED_ARITHMETIC(op_lushr, JLong, longUnsignedShiftRight)
+            CACHED_ARITHMETIC(op_iand, JInt, bit_and<>())
+            CACHED_ARITHMETIC(op_land, JLong, bit_and<>())
+            CACHED_ARITHMETIC(op_ior, JInt, bit_or<>())
+            CACHED_ARITHMETIC(op_lor, JLong, bit_or<>())
+            CACHED_ARITHMETIC(op_ixor, JInt, bit_xor<>())
+            CACHED_ARITHMETIC(op_lxor, JLong, bit_xor<>())
+            CACHED_ANY(op_iinc):
+                locals[decoded[op].operand].i += decoded[op].operand2;
+                CACHED_NEXT(state)
+            CACHED_UNARY(op_i2l, JValue::of<JLong>(tos.as<JInt>()))
+            CACHED_UNARY(op_i2f, JValue::of<JFloat>(tos.as<JInt>()))
+            CACHED_UNARY(op_i2d, JValue::of<JDouble>(tos.as<JInt>()))
+            CACHED_UNARY(op_l2i, JValue::of<JInt>(tos.as<JLong>()))
+            CACHED_UNARY(op_l2f, JValue::of<JFloat>(tos.as<JLong>()))
+            CACHED_UNARY(op_l2d, JValue::of<JDouble>(tos.as<JLong>()))
+            CACHED_UNARY(op_f2i, JValue::of<JInt>(tos.as<JFloat>()))
+            CACHED_UNARY(op_f2l, JValue::of<JLong>(tos.as<JFloat>()))
+            CACHED_UNARY(op_f2d, JValue::of<JDouble>(tos.as<JFloat>()))
+            CACHED_UNARY(op_d2i, JValue::of<JInt>(tos.as<JDouble>()))
+            CACHED_UNARY(op_d2l, JValue::of<JLong>(tos.as<JDouble>()))
+            CACHED_UNARY(op_d2f, JValue::of<JFloat>(tos.as<JDouble>()))
+            CACHED_UNARY(op_i2b, JValue::of<JInt>(static_cast<int8_t>(tos.i)))
+            CACHED_UNARY(op_i2c, JValue::of<JInt>(static_cast<int8_t>(tos.i)))
+            CACHED_UNARY(op_i2s, JValue::of<JInt>(static_cast<int16_t>(tos.i)))
+            CACHED_BINARY(op_lcmp, JValue::of<JInt>(compareLong(
+                                       nos.as<JLong>(), tos.as<JLong>())))
+            CACHED_BINARY(op_fcmpl, JValue::of<JInt>(compareFloat(
+                                        nos.as<JFloat>(), tos.as<JFloat>())))
+            CACHED_BINARY(op_fcmpg, JValue::of<JInt>(compareFloat(
+                                        nos.as<JFloat>(), tos.as<JFloat>())))
+            CACHED_BINARY(op_dcmpl,
+                          JValue::of<JInt>(compareDouble(nos.as<JDouble>(),
+                                                         tos.as<JDouble>())))
+            CACHED_BINARY(op_dcmpg,
+                          JValue::of<JInt>(compareDouble(nos.as<JDouble>(),
+                                                         tos.as<JDouble>())))
+            CACHED_IF(op_ifeq, tos.i == 0)
+            CACHED_IF(op_ifne, tos.i != 0)
+            CACHED_IF(op_iflt, tos.i < 0)
+            CACHED_IF(op_ifge, tos.i >= 0)
+            CACHED_IF(op_ifgt, tos.i > 0)
+            CACHED_IF(op_ifle, tos.i <= 0)
+            CACHED_IF_CMP(op_if_icmpeq, nos.i == tos.i)
+            CACHED_IF_CMP(op_if_icmpne, nos.i != tos.i)
+            CACHED_IF_CMP(op_if_icmplt, nos.i < tos.i)
+            CACHED_IF_CMP(op_if_icmpge, nos.i >= tos.i)
+            CACHED_IF_CMP(op_if_icmpgt, nos.i > tos.i)
+            CACHED_IF_CMP(op_if_icmple, nos.i <= tos.i)
+            CACHED_IF_CMP(op_if_acmpeq, isSameReference(nos.ref, tos.ref))
+            CACHED_IF_CMP(op_if_acmpne, !isSameReference(nos.ref, tos.ref))
+            CACHED_IF(op_ifnull, tos.ref == nullptr)
+            CACHED_IF(op_ifnonnull, tos.ref != nullptr)
+            CACHED_ANY(op_goto):
+                CACHED_JUMP()
+            CACHED(0, op_ireturn):
+            CACHED(0, op_lreturn):
+            CACHED(0, op_freturn):
+            CACHED(0, op_dreturn):
+            CACHED(0, op_areturn):
+                CACHED_RETURN(frame->pop(), true)
+            CACHED(1, op_ireturn):
+            CACHED(1, op_lreturn):
+            CACHED(1, op_freturn):
+            CACHED(1, op_dreturn):
+            CACHED(1, op_areturn):
+            CACHED(2, op_ireturn):
+            CACHED(2, op_lreturn):
+            CACHED(2, op_freturn):
+            CACHED(2, op_dreturn):
+            CACHED(2, op_areturn):
+                CACHED_RETURN(tos, true)
+            CACHED_ANY(op_return):
+                CACHED_RETURN(JValue{}, false)
+            default:
+                break;
+        }
+
+        if (opcode >= op_aload_0_getfield) {
+            // Superinstructions run as their first instructions, whose
+            // operands they were decoded with
+            opcode = decoded[op].originalOpcode;
+            goto dispatch;
+        }
+        // Instructions below work on stack slots
+        SPILL_CACHE()
+        switch (opcode) {
+            case op_ldc:
+                frame->push(
+                    cpCache->resolveConstant(decoded[op].operand)->value);
+                op++;
+                break;
+            case op_ldc_w:
+            case op_ldc2_w:
+                frame->push(
+                    cpCache->resolveConstant(decoded[op].operand)->value);
+                op++;
+                break;
+            case op_pop2:
+                frame->pop();
+                frame->pop();
+                op++;
+                break;
+            case op_dup_x1: {
+                JValue value1 = frame->pop();
+                JValue value2 = frame->pop();
+                frame->push(value1);
+                frame->push(value2);
+                frame->push(value1);
+                op++;
+            } break;
+            case op_dup2: {
+                JValue value1 = frame->pop();
+                if (IS_COMPUTATIONAL_TYPE_2(value1)) {
+                    frame->push(value1);
+                    frame->push(value1);
+                } else {
+                    JValue value2 = frame->pop();
+                    frame->push(value2);
+                    frame->push(value1);
+                    frame->push(value2);
+                    frame->push(value1);
+                }
+                op++;
+            } break;
+            case op_swap: {
+                JValue value1 = frame->pop();
+                JValue value2 = frame->pop();
+                frame->push(value1);
+                frame->push(value2);
+                op++;
+            } break;
+            case op_getstatic:
+            case op_getstatic_quick: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveField(decoded[op].operand);
+                if (opcode == op_getstatic) {
+                    if (entry->staticSlot == nullptr) {
+                        throw runtime_error("can not find static field " +
+                                            entry->name);
+                    }
+                    runtime.cs->initClassIfAbsent(*this,
+                                                  entry->jc->getClassName());
+                    methodData->quicken(decoded[op].pc, op_getstatic_quick);
+                }
+                frame->push(loadValue(*entry->staticSlot));
+                op++;
+            } break;
+            case op_putstatic:
+            case op_putstatic_quick: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveField(decoded[op].operand);
+                if (opcode == op_putstatic) {
+                    if (entry->staticSlot == nullptr) {
+                        throw runtime_error("can not find static field " +
+                                            entry->name);
+                    }
+                    runtime.cs->initClassIfAbsent(*this,
+                                                  entry->jc->getClassName());
+                    methodData->quicken(decoded[op].pc, op_putstatic_quick);
+                }
+                storeValue(*entry->staticSlot, frame->pop());
+                op++;
+            } break;
+            case op_getfield:
+            case op_getfield_quick: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveField(decoded[op].operand);
+                JObject *objectref = frame->pop<JObject>();
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
+                }
+                frame->push(
+                    runtime.heap->getField(*objectref, entry->instanceField));
+                if (opcode == op_getfield) {
+                    methodData->quicken(decoded[op].pc, op_getfield_quick);
+                }
+                op++;
+            } break;
+            case op_putfield:
+            case op_putfield_quick: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveField(decoded[op].operand);
+                JValue value = frame->pop();
+                JObject *objectref = frame->pop<JObject>();
+                if (objectref == nullptr) {
+                    throw runtime_error("null pointer");
+                }
+                runtime.heap->putField(*objectref, entry->instanceField,
+                                       value);
+                if (opcode == op_putfield) {
+                    methodData->quicken(decoded[op].pc, op_putfield_quick);
+                }
+                op++;
+            } break;
+            case op_invokevirtual:
+            case op_invokevirtual_quick:
+            case op_invokeinterface:
+            case op_invokeinterface_quick: {
+                const u4 pc = decoded[op].pc;
+                const ResolvedEntry *entry =
+                    cpCache->resolveMethod(decoded[op].operand);
+                if (opcode == op_invokevirtual) {
+                    if (entry->name == "<init>") {
+                        throw runtime_error(
+                            "invoking method should not be instance "
+                            "initialization method\n");
+                    }
+                    if (IS_SIGNATURE_POLYMORPHIC_METHOD(
+                            entry->jc->getClassName(), entry->name)) {
+                        throw runtime_error(
+                            "unsupported signature polymorphic method " +
+                            entry->name);
+                    }
+                    methodData->quicken(pc, op_invokevirtual_quick);
+                } else if (opcode == op_invokeinterface) {
+                    methodData->quicken(pc, op_invokeinterface_quick);
+                }
+                op++;
+                CACHED_INVOKE(selectVirtualCallSite(
+                    entry, methodData, methodData->getInlineCache(pc)));
             } break;
-            case op_wide: {
-                throw runtime_error("unsupported opcode [wide]");
+            case op_invokespecial:
+            case op_invokestatic: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveMethod(decoded[op].operand);
+                const bool isStatic = opcode == op_invokestatic;
+                if (!entry->csite.isCallable() ||
+                    static_cast<bool>(IS_METHOD_STATIC(
+                        entry->csite.accessFlags)) != isStatic) {
+                    throw runtime_error("can not find method " + entry->name +
+                                        " " + entry->descriptor);
+                }
+                if (isStatic) {
+                    runtime.cs->initClassIfAbsent(*this,
+                                                  entry->jc->getClassName());
+                }
+                methodData->quicken(decoded[op].pc,
+                                    isStatic ? op_invokestatic_quick
+                                             : op_invokespecial_quick);
+                op++;
+                CACHED_INVOKE(entry->csite);
             } break;
-            case op_multianewarray: {
-                throw runtime_error("unsupported opcode [multianewarray]");
+            case op_invokespecial_quick:
+            case op_invokestatic_quick: {
+                const u2 index = decoded[op].operand;
+                op++;
+                CACHED_INVOKE(cpCache->resolveMethod(index)->csite);
             } break;
-            case op_ifnull: {
-                u4 currentOffset = op - 1;
-                int16_t branchIndex = consumeU2(code, op);
-                JObject *value = frames->top()->pop<JObject>();
-                if (value == nullptr) {
-                    op = currentOffset + branchIndex;
+            case op_new:
+                frame->push<JObject>(execNew(jc, decoded[op].operand));
+                op++;
+                break;
+            case op_newarray: {
+                auto count = frame->pop<JInt>();
+                if (count < 0) {
+                    throw runtime_error("negative array size");
                 }
+                frame->push<JArray>(
+                    runtime.heap->createPODArray(decoded[op].operand, count));
+                op++;
             } break;
-            case op_ifnonnull: {
-                u4 currentOffset = op - 1;
-                int16_t branchIndex = consumeU2(code, op);
-                JObject *value = frames->top()->pop<JObject>();
-                if (value != nullptr) {
-                    op = currentOffset + branchIndex;
+            case op_anewarray: {
+                const ResolvedEntry *entry =
+                    cpCache->resolveClass(decoded[op].operand);
+                auto count = frame->pop<JInt>();
+                if (count < 0) {
+                    throw runtime_error("negative array size");
                 }
+                if (entry->jc == nullptr) {
+                    throw runtime_error("unsupported array component type " +
+                                        entry->name);
+                }
+                frame->push<JArray>(
+                    runtime.heap->createObjectArray(*entry->jc, count));
+                op++;
             } break;
-            case op_goto_w: {
-                u4 currentOffset = op - 1;
-                int32_t branchIndex = consumeU4(code, op);
-                op = currentOffset + branchIndex;
-            } break;
-            case op_jsr_w: {
-                throw runtime_error("unsupported opcode [jsr_w]");
+            case op_arraylength: {
+                JArray *arrayref = frame->pop<JArray>();
+                if (arrayref == nullptr) {
+                    throw runtime_error("null pointer\n");
+                }
+                frame->push<JInt>(arrayref->length);
+                op++;
             } break;
-            case op_breakpoint:
-            case op_impdep1:
-            case op_impdep2: {
-                // Reserved opcodde
-                cerr << "Are you a dot.class hacker? Or you were entered a "
-                        "strange region.";
-                exit(EXIT_FAILURE);
+            case op_instanceof: {
+                auto *objectref = frame->pop<JObject>();
+                frame->push<JInt>(
+                    objectref != nullptr &&
+                            checkInstanceof(jc, decoded[op].operand,
+                                            objectref)
+                        ? 1
+                        : 0);
+                op++;
             } break;
             default:
-                cerr << "The YVM can not recognize this opcode. Bytecode file "
-                        "was be corrupted.";
-                exit(EXIT_FAILURE);
+                // Rejected by canCacheStack()
+                SHOULD_NOT_REACH_HERE
         }
     }
-    return nullptr;
 }
+
 //--------------------------------------------------------------------------------
-//  This function does "ldc" opcode jc type of JavaClass, which indicate where
-//  to resolve
+// Execute register code of a method whose frame has been pushed by caller.
+// Operands that are negative are constants, see RegisterInstruction. It
+// returns when the method returns or after it pushed the frame of a method it
+// calls, see execRegisterFrame()
 //--------------------------------------------------------------------------------
-void Interpreter::loadConstantPoolItem2Stack(const JavaClass *jc, u2 index) {
-    if (typeid(*jc->raw.constPoolInfo[index]) == typeid(CONSTANT_Integer)) {
-        auto val =
-            dynamic_cast<CONSTANT_Integer *>(jc->raw.constPoolInfo[index])->val;
-        JInt *ival = new JInt;
-        ival->val = val;
-        frames->top()->push(ival);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_Float)) {
-        auto val =
-            dynamic_cast<CONSTANT_Float *>(jc->raw.constPoolInfo[index])->val;
-        JFloat *fval = new JFloat;
-        fval->val = val;
-        frames->top()->push(fval);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_String)) {
-        auto val = jc->getString(
-            dynamic_cast<CONSTANT_String *>(jc->raw.constPoolInfo[index])
-                ->stringIndex);
-        JObject *str = runtime.heap->createObject(
-            *runtime.cs->loadClassIfAbsent("java/lang/String"));
-        JArray *value = runtime.heap->createCharArray(val, val.length());
-        // Put string  into str's field; according the source file of
-        // java.lang.Object, we know that its first field was used to store
-        // chars
-        runtime.heap->putFieldByOffset(*str, 0, value);
-        frames->top()->push(str);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_Class)) {
-        throw runtime_error("nonsupport region");
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_MethodType)) {
-        throw runtime_error("nonsupport region");
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_MethodHandle)) {
-        throw runtime_error("nonsupport region");
-    } else {
-        throw runtime_error(
-            "invalid symbolic reference index on constant "
-            "pool");
+#define REGISTER_OPERAND(x) ((x) >= 0 ? regs[(x)] : consts[-(x)-1])
+
+#define REGISTER_ARITHMETIC(expression)                        \
+    {                                                          \
+        const int32_t a = REGISTER_OPERAND(instruction->a).i;  \
+        const int32_t b = REGISTER_OPERAND(instruction->b).i;  \
+        regs[instruction->dst] = JValue::of<JInt>(expression); \
+    }                                                          \
+    break;
+
+// pc is moved to the instruction before target. Backward branches are counted
+// so that loops make a method compiled sooner, a loop running when it's
+// compiled continues as machine code at its header
+#define REGISTER_JUMP()                                                     \
+    {                                                                       \
+        if (instruction->target <= static_cast<int32_t>(pc)) {              \
+            csite.data->countBackedge();                                    \
+            if (const JitCode *jitCode =                                    \
+                    runtime.tierPolicy->jitCodeOf(csite)) {                 \
+                return execJitCode(csite, registerCode, *jitCode,           \
+                                   instruction->target);                    \
+            }                                                               \
+        }                                                                   \
+        pc = instruction->target - 1;                                       \
+    }
+
+#define REGISTER_BRANCH(condition) \
+    if (condition) {               \
+        REGISTER_JUMP();           \
+    }                              \
+    break;
+
+JValue Interpreter::execRegisterCode(const CallSite &csite,
+                                     const RegisterCode &registerCode,
+                                     int32_t entry) {
+    Slots *frame = frames->top();
+    frame->jc = csite.jc;
+    frame->method = csite.data;
+
+    JValue *regs = frame->localSlots;
+    const JValue *consts = registerCode.getConstants();
+    const RegisterInstruction *code = registerCode.getInstructions();
+    for (u4 pc = static_cast<u4>(entry);; pc++) {
+        const RegisterInstruction *instruction = &code[pc];
+        switch (instruction->opcode) {
+            case reg_move:
+                regs[instruction->dst] = REGISTER_OPERAND(instruction->a);
+                break;
+            case reg_iadd:
+                // Java arithmetic wraps around on overflow
+                REGISTER_ARITHMETIC(static_cast<int32_t>(
+                    static_cast<uint32_t>(a) + static_cast<uint32_t>(b)))
+            case reg_isub:
+                REGISTER_ARITHMETIC(static_cast<int32_t>(
+                    static_cast<uint32_t>(a) - static_cast<uint32_t>(b)))
+            case reg_imul:
+                REGISTER_ARITHMETIC(static_cast<int32_t>(
+                    static_cast<uint32_t>(a) * static_cast<uint32_t>(b)))
+            case reg_idiv:
+                REGISTER_ARITHMETIC(a / b)
+            case reg_irem:
+                REGISTER_ARITHMETIC(a % b)
+            case reg_iand:
+                REGISTER_ARITHMETIC(a & b)
+            case reg_ior:
+                REGISTER_ARITHMETIC(a | b)
+            case reg_ixor:
+                REGISTER_ARITHMETIC(a ^ b)
+            case reg_ineg:
+                regs[instruction->dst] = JValue::of<JInt>(static_cast<int32_t>(
+                    0u - static_cast<uint32_t>(
+                             REGISTER_OPERAND(instruction->a).i)));
+                break;
+            case reg_ifeq:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i == 0)
+            case reg_ifne:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i != 0)
+            case reg_iflt:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i < 0)
+            case reg_ifge:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i >= 0)
+            case reg_ifgt:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i > 0)
+            case reg_ifle:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i <= 0)
+            case reg_if_icmpeq:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i ==
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_icmpne:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i !=
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_icmplt:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i <
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_icmpge:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i >=
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_icmpgt:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i >
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_icmple:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).i <=
+                                REGISTER_OPERAND(instruction->b).i)
+            case reg_if_acmpeq:
+                REGISTER_BRANCH(
+                    isSameReference(REGISTER_OPERAND(instruction->a).ref,
+                                    REGISTER_OPERAND(instruction->b).ref))
+            case reg_if_acmpne:
+                REGISTER_BRANCH(
+                    !isSameReference(REGISTER_OPERAND(instruction->a).ref,
+                                     REGISTER_OPERAND(instruction->b).ref))
+            case reg_ifnull:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).ref ==
+                                nullptr)
+            case reg_ifnonnull:
+                REGISTER_BRANCH(REGISTER_OPERAND(instruction->a).ref !=
+                                nullptr)
+            case reg_goto:
+                REGISTER_JUMP();
+                break;
+            case reg_return:
+                return REGISTER_OPERAND(instruction->a);
+            case reg_return_void:
+                return JValue{};
+            default:
+                switch (execRegisterRuntimeCall(csite, registerCode,
+                                                instruction)) {
+                    case JIT_EXCEPTION:
+                        // Register code never catches exceptions, keep
+                        // propagating the one callee left on stack
+                        return frame->pop();
+                    case JIT_CALL:
+                        return JValue{};
+                }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Execute a register instruction that needs the runtime: constants, arrays,
+// fields, allocation and calls. Return a JitStatus, a Java method that is
+// called gets its frame pushed and is left to the dispatch loop
+//--------------------------------------------------------------------------------
+int Interpreter::execRegisterRuntimeCall(
+    const CallSite &csite, const RegisterCode &registerCode,
+    const RegisterInstruction *instruction) {
+    Slots *frame = frames->top();
+    ConstPoolCache *cpCache = csite.jc->getConstPoolCache();
+    JValue *regs = frame->localSlots;
+    const JValue *consts = registerCode.getConstants();
+    switch (instruction->opcode) {
+        case reg_ldc:
+            regs[instruction->dst] =
+                cpCache->resolveConstant(instruction->index)->value;
+            break;
+        case reg_iaload:
+        case reg_aaload: {
+            // Shared by all int-like loads, so element width is decided by the
+            // array rather than by the instruction
+            const auto *arrref = REGISTER_OPERAND(instruction->a).as<JArray>();
+            const int32_t index = REGISTER_OPERAND(instruction->b).i;
+            if (arrref == nullptr) {
+                throw runtime_error("nullpointerexception");
+            }
+            if (index >= arrref->length || index < 0) {
+                throw runtime_error("array index out of bounds");
+            }
+            regs[instruction->dst] = runtime.heap->getElement(*arrref, index);
+        } break;
+        case reg_iastore:
+        case reg_aastore: {
+            auto *arrref = REGISTER_OPERAND(instruction->a).as<JArray>();
+            const int32_t index = REGISTER_OPERAND(instruction->b).i;
+            if (arrref == nullptr) {
+                throw runtime_error("null pointer");
+            }
+            if (index >= arrref->length || index < 0) {
+                throw runtime_error("array index out of bounds");
+            }
+            runtime.heap->putElement(*arrref, index,
+                                     REGISTER_OPERAND(instruction->dst));
+        } break;
+        case reg_arraylength: {
+            const auto *arrref = REGISTER_OPERAND(instruction->a).as<JArray>();
+            if (arrref == nullptr) {
+                throw runtime_error("null pointer\n");
+            }
+            regs[instruction->dst] = JValue::of<JInt>(arrref->length);
+        } break;
+        case reg_getfield: {
+            auto *objectref = REGISTER_OPERAND(instruction->a).as<JObject>();
+            const ResolvedEntry *entry =
+                cpCache->resolveField(instruction->index);
+            if (objectref == nullptr) {
+                throw runtime_error("null pointer");
+            }
+            regs[instruction->dst] =
+                runtime.heap->getField(*objectref, entry->instanceField);
+        } break;
+        case reg_putfield: {
+            auto *objectref = REGISTER_OPERAND(instruction->a).as<JObject>();
+            const ResolvedEntry *entry =
+                cpCache->resolveField(instruction->index);
+            if (objectref == nullptr) {
+                throw runtime_error("null pointer");
+            }
+            runtime.heap->putField(*objectref, entry->instanceField,
+                                   REGISTER_OPERAND(instruction->b));
+        } break;
+        case reg_getstatic:
+            regs[instruction->dst] = loadValue(
+                *cpCache->resolveField(instruction->index)->staticSlot);
+            break;
+        case reg_putstatic:
+            storeValue(*cpCache->resolveField(instruction->index)->staticSlot,
+                       REGISTER_OPERAND(instruction->a));
+            break;
+        case reg_new:
+            frame->stackTop = instruction->depth;
+            regs[instruction->dst] =
+                JValue::of<JObject>(execNew(csite.jc, instruction->index));
+            break;
+        case reg_invokestatic:
+        case reg_invokespecial:
+        case reg_invokevirtual: {
+            frame->stackTop = instruction->depth;
+            const ResolvedEntry *entry =
+                cpCache->resolveMethod(instruction->index);
+            const CallSite &callee =
+                instruction->opcode == reg_invokevirtual
+                    ? selectVirtualCallSite(
+                          entry, csite.data,
+                          registerCode.getInlineCache(instruction->target))
+                    : entry->csite;
+            if (callee.data->getTrivialKind() != TrivialKind::None &&
+                invokeTrivialMethod(callee)) {
+                break;
+            }
+            const RegisterCode *calleeCode =
+                IS_METHOD_NATIVE(callee.accessFlags)
+                    ? nullptr
+                    : runtime.tierPolicy->registerCodeOf(callee);
+            if (IS_METHOD_NATIVE(callee.accessFlags) ||
+                (calleeCode == nullptr && isStackCached(callee))) {
+                invokeCallSite(callee);
+                if (exception.hasUnhandledException()) {
+                    return JIT_EXCEPTION;
+                }
+                break;
+            }
+            // Continue after the call once callee returned
+            frame->pc = static_cast<u4>(
+                instruction - registerCode.getInstructions() + 1);
+            enterMethod(callee);
+            frames->top()->registerCode = calleeCode;
+            return JIT_CALL;
+        }
+        case reg_resolve_getstatic:
+        case reg_resolve_putstatic: {
+            frame->stackTop = instruction->depth;
+            const ResolvedEntry *entry =
+                cpCache->resolveField(instruction->index);
+            if (entry->staticSlot == nullptr) {
+                throw runtime_error("can not find static field " +
+                                    entry->name);
+            }
+            runtime.cs->initClassIfAbsent(*this, entry->jc->getClassName());
+            registerCode.quicken(instruction,
+                                 instruction->opcode == reg_resolve_getstatic
+                                     ? reg_getstatic
+                                     : reg_putstatic);
+            return execRegisterRuntimeCall(csite, registerCode, instruction);
+        }
+        case reg_resolve_invokestatic:
+        case reg_resolve_invokespecial: {
+            frame->stackTop = instruction->depth;
+            const bool isStatic =
+                instruction->opcode == reg_resolve_invokestatic;
+            const ResolvedEntry *entry =
+                cpCache->resolveMethod(instruction->index);
+            if (!entry->csite.isCallable() ||
+                IS_METHOD_STATIC(entry->csite.accessFlags) != isStatic) {
+                throw runtime_error("can not find method " + entry->name +
+                                    " " + entry->descriptor);
+            }
+            if (isStatic) {
+                runtime.cs->initClassIfAbsent(*this,
+                                              entry->jc->getClassName());
+            }
+            registerCode.quicken(instruction, isStatic ? reg_invokestatic
+                                                       : reg_invokespecial);
+            return execRegisterRuntimeCall(csite, registerCode, instruction);
+        }
+        case reg_resolve_invokevirtual:
+            if (cpCache->resolveMethod(instruction->index)->name == "<init>") {
+                throw runtime_error(
+                    "invoking method should not be instance "
+                    "initialization method\n");
+            }
+            registerCode.quicken(instruction, reg_invokevirtual);
+            return execRegisterRuntimeCall(csite, registerCode, instruction);
+        default:
+            SHOULD_NOT_REACH_HERE
+    }
+    return JIT_OK;
+}
+
+int Interpreter::runtimeCallFromJit(JitContext *context,
+                                   const RegisterInstruction *instruction) {
+    try {
+        return context->interpreter->execRegisterRuntimeCall(
+            *context->csite, *context->registerCode, instruction);
+    } catch (...) {
+        context->error = std::current_exception();
+        return JIT_ERROR;
+    }
+}
+
+JValue Interpreter::execJitCode(const CallSite &csite,
+                                const RegisterCode &registerCode,
+                                const JitCode &jitCode, int32_t entry) {
+    Slots *frame = frames->top();
+    frame->jc = csite.jc;
+    frame->method = csite.data;
+
+    JitContext context{this, &csite, &registerCode, JValue{}, nullptr, entry};
+    switch (jitCode.getEntry()(frame->localSlots, &context)) {
+        case JIT_EXCEPTION:
+            return frame->pop();
+        case JIT_ERROR:
+            std::rethrow_exception(context.error);
+        case JIT_CALL:
+            return JValue{};
+        default:
+            return context.result;
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Run method of the top frame as register code, or as machine code if that is
+// due, from the register instruction saved in its pc. Return false if it
+// pushed the frame of a method it calls, it continues at the instruction
+// after the call once that returned. Otherwise result is the return value or
+// the exception it threw
+//--------------------------------------------------------------------------------
+bool Interpreter::execRegisterFrame(JValue &result) {
+    Slots *frame = frames->top();
+    const size_t depth = frames->depth();
+    // Register code only looks at class and MethodData of its method
+    CallSite csite;
+    csite.jc = frame->jc;
+    csite.data = frame->method;
+    const auto entry = static_cast<int32_t>(frame->pc);
+    const JitCode *jitCode = runtime.tierPolicy->jitCodeOf(csite);
+    result = jitCode != nullptr
+                 ? execJitCode(csite, *frame->registerCode, *jitCode, entry)
+                 : execRegisterCode(csite, *frame->registerCode, entry);
+    return frames->depth() == depth;
+}
+
+//--------------------------------------------------------------------------------
+// Replace the activation of a method running with stack caching on top of the
+// frame stack, it continues at loop header pc as register code, or as machine
+// code if that is due. The frame has the layout of a register file, so the
+// local variables and operand stack are taken over in place. Methods it calls
+// run in a dispatch loop of execByteCode(). Return false if pc is not an OSR
+// entry of registerCode
+//--------------------------------------------------------------------------------
+bool Interpreter::execOsrCode(const JavaClass *jc, MethodData *methodData,
+                              const RegisterCode &registerCode, u4 pc,
+                              JValue &result) {
+    const int32_t entry = registerCode.getOsrEntry(pc);
+    if (entry < 0) {
+        return false;
+    }
+    frames->top()->registerCode = &registerCode;
+    frames->top()->pc = static_cast<u4>(entry);
+    CallSite csite;
+    csite.jc = jc;
+    csite.data = methodData;
+    result = execByteCode(csite);
+    return true;
+}
+
+JObject *Interpreter::catchPropagatedException(const JavaClass *jc,
+                                               u2 exceptLen,
+                                               ExceptionTable *exceptTab,
+                                               u4 &op) {
+    auto *throwobj = frames->top()->pop<JObject>();
+    if (throwobj == nullptr) {
+        throw runtime_error("null pointer");
+    }
+    if (!hasInheritanceRelationship(
+            throwobj->jc,
+            runtime.cs->loadClassIfAbsent("java/lang/Throwable"))) {
+        throw runtime_error("it's not a throwable object");
+    }
+
+    if (handleException(jc, exceptLen, exceptTab, throwobj, op)) {
+        while (!frames->top()->emptyStack()) {
+            frames->top()->pop();
+        }
+        frames->top()->push<JObject>(throwobj);
+        exception.sweepException();
+        return nullptr;
     }
+    return throwobj;
 }
 
 bool Interpreter::handleException(const JavaClass *jc, u2 exceptLen,
                                   ExceptionTable *exceptTab,
                                   const JObject *objectref, u4 &op) {
     FOR_EACH(i, exceptLen) {
-        const string &catchTypeName =
-            jc->getString(dynamic_cast<CONSTANT_Class *>(
-                              jc->raw.constPoolInfo[exceptTab[i].catchType])
-                              ->nameIndex);
-
-        if (hasInheritanceRelationship(
-                runtime.cs->findJavaClass(objectref->jc->getClassName()),
-                runtime.cs->findJavaClass(catchTypeName)) &&
-            exceptTab[i].startPC <= op && op < exceptTab[i].endPC) {
-            // start<=op<end
+        // start<=op<end
+        if (op < exceptTab[i].startPC || exceptTab[i].endPC <= op) {
+            continue;
+        }
+        // Zero catch type catches all exceptions, it's used to implement
+        // finally block
+        if (exceptTab[i].catchType == 0 ||
+            hasInheritanceRelationship(
+                objectref->jc, jc->getConstPoolCache()
+                                   ->resolveClass(exceptTab[i].catchType)
+                                   ->jc)) {
             // If we found a proper exception handler, set current pc as
             // handlerPC of this exception table item;
-            op = exceptTab[i].handlerPC - 1;
-            return true;
-        }
-        if (exceptTab[i].catchType == 0) {
-            op = exceptTab[i].handlerPC - 1;
+            op = exceptTab[i].handlerPC;
             return true;
         }
     }
@@ -1480,157 +2788,73 @@ bool Interpreter::handleException(const JavaClass *jc, u2 exceptLen,
 }
 
 JObject *Interpreter::execNew(const JavaClass *jc, u2 index) {
-    runtime.cs->linkClassIfAbsent(const_cast<JavaClass *>(jc)->getClassName());
-    runtime.cs->initClassIfAbsent(*this,
-                              const_cast<JavaClass *>(jc)->getClassName());
-
     if (typeid(*jc->raw.constPoolInfo[index]) != typeid(CONSTANT_Class)) {
         throw runtime_error(
             "operand index of new is not a class or "
             "interface\n");
     }
-    string className = jc->getString(
-        dynamic_cast<CONSTANT_Class *>(jc->raw.constPoolInfo[index])
-            ->nameIndex);
-    JavaClass *newClass = runtime.cs->loadClassIfAbsent(className);
+    JavaClass *newClass = jc->getConstPoolCache()->resolveClass(index)->jc;
+    runtime.cs->initClassIfAbsent(*this, newClass->getClassName());
     return runtime.heap->createObject(*newClass);
 }
 
 bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
                                   JType *objectref) {
-    string TclassName =
-        (char *)dynamic_cast<CONSTANT_Utf8 *>(
-            jc->raw.constPoolInfo[dynamic_cast<CONSTANT_Class *>(
-                                      jc->raw.constPoolInfo[index])
-                                      ->nameIndex])
-            ->bytes;
-    constexpr short TYPE_ARRAY = 1;
-    constexpr short TYPE_CLASS = 2;
-    constexpr short TYPE_INTERFACE = 3;
-
-    short tType = 0;
-    if (TclassName.find('[') != string::npos) {
-        tType = TYPE_ARRAY;
-    } else {
-        if (IS_CLASS_INTERFACE(
-                runtime.cs->findJavaClass(TclassName)->raw.accessFlags)) {
-            tType = TYPE_INTERFACE;
-        } else {
-            tType = TYPE_CLASS;
-        }
-    }
+    const ResolvedEntry *target =
+        jc->getConstPoolCache()->resolveClass(index);
 
-    if (typeid(objectref) == typeid(JObject)) {
-        if (!IS_CLASS_INTERFACE(
-                dynamic_cast<JObject *>(objectref)->jc->raw.accessFlags)) {
-            // If it's an ordinary class
-            if (tType == TYPE_CLASS) {
-                if (runtime.cs
-                            ->findJavaClass(dynamic_cast<JObject *>(objectref)
-                                              ->jc->getClassName())
-                            ->getClassName() == TclassName ||
-                    runtime.cs
-                            ->findJavaClass(dynamic_cast<JObject *>(objectref)
-                                              ->jc->getSuperClassName())
-                            ->getClassName() == TclassName) {
-                    return true;
-                }
-            } else if (tType == TYPE_INTERFACE) {
-                auto &&interfaceIdxs = dynamic_cast<JObject *>(objectref)
-                                           ->jc->getInterfacesIndex();
-                FOR_EACH(i, interfaceIdxs.size()) {
-                    string interfaceName =
-                        dynamic_cast<JObject *>(objectref)->jc->getString(
-                            dynamic_cast<CONSTANT_Class *>(
-                                dynamic_cast<JObject *>(objectref)
-                                    ->jc->raw.constPoolInfo[interfaceIdxs[i]])
-                                ->nameIndex);
-                    if (interfaceName == TclassName) {
-                        return true;
-                    }
-                }
-            } else {
-                SHOULD_NOT_REACH_HERE
-            }
-        } else {
-            // Otherwise, it's an interface class
-            if (tType == TYPE_CLASS) {
-                if (TclassName == "java/lang/Object") {
-                    return true;
-                }
-            } else if (tType == TYPE_INTERFACE) {
-                if (TclassName == dynamic_cast<JObject *>(objectref)
-                                      ->jc->getClassName() ||
-                    TclassName == dynamic_cast<JObject *>(objectref)
-                                      ->jc->getSuperClassName()) {
-                    return true;
-                }
-            } else {
-                SHOULD_NOT_REACH_HERE
-            }
+    if (typeid(*objectref) == typeid(JObject)) {
+        if (target->name[0] == '[') {
+            return false;
         }
-    } else if (typeid(objectref) == typeid(JArray)) {
-        if (tType == TYPE_CLASS) {
-            if (TclassName == "java/lang/Object") {
-                return true;
-            }
-        } else if (tType == TYPE_INTERFACE) {
-            auto *firstComponent = dynamic_cast<JObject *>(runtime.heap->getElement(*dynamic_cast<JArray *>(objectref), 0));
-            auto &&interfaceIdxs = firstComponent->jc->getInterfacesIndex();
-            FOR_EACH(i, interfaceIdxs.size()) {
-                if (firstComponent->jc->getString(
-                        dynamic_cast<CONSTANT_Class *>(
-                            firstComponent->jc->raw
-                                .constPoolInfo[interfaceIdxs[i]])
-                            ->nameIndex) == TclassName) {
-                    return true;
-                }
-            }
-        } else if (tType == TYPE_ARRAY) {
+        const JavaClass *source = dynamic_cast<JObject *>(objectref)->jc;
+        if (IS_CLASS_INTERFACE(target->jc->raw.accessFlags)) {
+            return hasImplementationRelationship(source, target->jc);
+        }
+        return hasInheritanceRelationship(source, target->jc);
+    }
+    if (typeid(*objectref) == typeid(JArray)) {
+        // Arrays only extend java/lang/Object and implement
+        // java/lang/Cloneable and java/io/Serializable
+        if (target->name[0] == '[') {
             throw runtime_error("to be continue\n");
-        } else {
-            SHOULD_NOT_REACH_HERE
         }
-    } else {
-        SHOULD_NOT_REACH_HERE
+        return target->name == "java/lang/Object" ||
+               target->name == "java/lang/Cloneable" ||
+               target->name == "java/io/Serializable";
     }
+    SHOULD_NOT_REACH_HERE
+    return false;
 }
 
-void Interpreter::pushMethodArguments(vector<int> &parameter,
-                                      bool isObjectMethod) {
-    if (parameter.size() > 0) {
-        for (int localIndex = parameter.size() - (isObjectMethod ? 0 : 1),
-                 paramIndex = parameter.size() - 1;
-             paramIndex >= 0; localIndex--, paramIndex--) {
-            if (parameter[paramIndex] == T_INT ||
-                parameter[paramIndex] == T_BOOLEAN ||
-                parameter[paramIndex] == T_CHAR ||
-                parameter[paramIndex] == T_BYTE ||
-                parameter[paramIndex] == T_SHORT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JInt>());
-            } else if (parameter[paramIndex] == T_FLOAT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JFloat>());
-            } else if (parameter[paramIndex] == T_DOUBLE) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JDouble>());
-            } else if (parameter[paramIndex] == T_LONG) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JLong>());
-            } else if (parameter[paramIndex] == T_EXTRA_ARRAY) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JArray>());
-            } else if (parameter[paramIndex] == T_EXTRA_OBJECT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JObject>());
-            } else {
-                SHOULD_NOT_REACH_HERE;
-            }
-        }
+//--------------------------------------------------------------------------------
+// Arguments are already the first local variables of callee since its frame
+// overlaps caller's operand stack. Long and double arguments take one operand
+// stack slot but two local variable slots, arguments after them are moved up
+// in place, starting from the last one
+//--------------------------------------------------------------------------------
+void Interpreter::placeMethodArguments(const CallSite &csite) {
+    const MethodData *data = csite.data;
+    if (data->getArgumentSlots() == data->getArgumentCount()) {
+        return;
     }
-    if (isObjectMethod) {
-        frames->top()->setLocalVariable(0, frames->nextFrame()->pop<JObject>());
+    const vector<int> &parameter = data->getParameter();
+    JValue *locals = frames->top()->localSlots;
+    int valueIndex = data->getArgumentCount();
+    int localIndex = data->getArgumentSlots();
+    for (int paramIndex = parameter.size() - 1; paramIndex >= 0;
+         paramIndex--) {
+        valueIndex--;
+        if (parameter[paramIndex] == T_LONG ||
+            parameter[paramIndex] == T_DOUBLE) {
+            localIndex -= 2;
+            locals[localIndex] = locals[valueIndex];
+            // The second slot of long and double is not addressable
+            locals[localIndex + 1].tag = ValueTag::Empty;
+        } else {
+            localIndex--;
+            locals[localIndex] = locals[valueIndex];
+        }
     }
 }
 //--------------------------------------------------------------------------------
@@ -1638,8 +2862,6 @@ void Interpreter::pushMethodArguments(vector<int> &parameter,
 //--------------------------------------------------------------------------------
 void Interpreter::invokeByName(JavaClass *jc, const string &name,
                                const string &descriptor) {
-    const int returnType = get<0>(peelMethodParameterAndType(descriptor));
-
     MethodInfo *m = jc->findMethod(name, descriptor);
     CallSite csite = CallSite::makeCallSite(jc, m);
     if (!csite.isCallable()) {
@@ -1647,15 +2869,15 @@ void Interpreter::invokeByName(JavaClass *jc, const string &name,
     }
 
     frames->pushFrame(csite.maxLocal, csite.maxStack);
+    csite.data->countInvocation();
 
-    JType *returnValue{};
+    JValue returnValue;
     if (IS_METHOD_NATIVE(m->accessFlags)) {
-        returnValue =
-            cloneValue(execNativeMethod(jc->getClassName(), name, descriptor));
+        returnValue = execNativeMethod(csite);
+    } else if (isStackCached(csite)) {
+        returnValue = execStackCachedCode(csite);
     } else {
-        returnValue =
-            cloneValue(execByteCode(jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
+        returnValue = execByteCode(csite);
     }
     frames->popFrame();
 
@@ -1664,7 +2886,7 @@ void Interpreter::invokeByName(JavaClass *jc, const string &name,
     // need to push its value into upper frame  again (In fact there is no more
     // frame), we just print stack trace inforamtion to notice user and
     // return directly
-    if (returnType != T_EXTRA_VOID) {
+    if (csite.data->getReturnType() != T_EXTRA_VOID) {
         frames->top()->push(returnValue);
     }
     if (exception.hasUnhandledException()) {
@@ -1683,129 +2905,100 @@ void Interpreter::invokeByName(JavaClass *jc, const string &name,
 //--------------------------------------------------------------------------------
 void Interpreter::invokeInterface(const JavaClass *jc, const string &name,
                                   const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
-    auto csite = findInstanceMethod(jc, name, descriptor);
+    auto csite = selectVirtualMethod(jc, name, descriptor);
     if (!csite.isCallable()) {
-        csite = findInstanceMethodOnSupers(jc, name, descriptor);
-        if (!csite.isCallable()) {
-            csite = findMaximallySpecifiedMethod(jc, name, descriptor);
-            if (!csite.isCallable()) {
-                throw runtime_error("can not find method " + name + " " +
-                                    descriptor);
-            }
-        }
-    }
-
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
-    }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
-
-    JType *returnValue{};
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
-    } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
-    }
-    frames->popFrame();
-
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
-    }
-
-    GC_SAFE_POINT
-    if (runtime.gc->shallGC()) {
-        runtime.gc->stopTheWorld();
-        runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
+        throw runtime_error("can not find method " + name + " " + descriptor);
     }
+    invokeCallSite(csite);
 }
 
 //--------------------------------------------------------------------------------
 // Invoke instance method; dispatch based on class
 //--------------------------------------------------------------------------------
 void Interpreter::invokeVirtual(const string &name, const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
+    const size_t parameterCount =
+        get<1>(peelMethodParameterAndType(descriptor)).size();
     auto *thisRef =
-        (JObject *)frames->top()
-            ->stackSlots[frames->top()->stackTop - parameter.size() - 1];
+        frames->top()
+            ->stackSlots[frames->top()->stackTop - parameterCount - 1]
+            .as<JObject>();
 
-    auto csite = findInstanceMethod(thisRef->jc, name, descriptor);
+    auto csite = selectVirtualMethod(thisRef->jc, name, descriptor);
     if (!csite.isCallable()) {
-        csite = findInstanceMethodOnSupers(thisRef->jc, name, descriptor);
-        if (!csite.isCallable()) {
-            csite = findMaximallySpecifiedMethod(thisRef->jc, name, descriptor);
-            if (!csite.isCallable()) {
-                throw runtime_error("can not find method " + name + " " +
-                                    descriptor);
-            }
-        }
-    }
-
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
+        throw runtime_error("can not find method " + name + " " + descriptor);
     }
+    invokeCallSite(csite);
+}
 
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
-    JType *returnValue{};
-    if (csite.isCallable()) {
-        if (IS_METHOD_NATIVE(csite.accessFlags)) {
-            returnValue = cloneValue(
-                execNativeMethod(csite.jc->getClassName(), name, descriptor));
-        } else {
-            returnValue =
-                cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                        csite.exceptionLen, csite.exception));
+//--------------------------------------------------------------------------------
+// Select the method resolved into entry from vtable or itable of receiver's
+// class, fall back to looking it up by name into selected if it has no slot
+//--------------------------------------------------------------------------------
+static const CallSite *selectVirtualMethod(const JavaClass *receiverClass,
+                                           const ResolvedEntry *entry,
+                                           CallSite &selected) {
+    if (entry->methodSlot != JavaClass::METHOD_NOT_FOUND) {
+        if (entry->slotOwner == nullptr) {
+            return &receiverClass->getVirtualMethod(entry->methodSlot);
+        }
+        const vector<CallSite> *itable =
+            receiverClass->getItable(entry->slotOwner);
+        if (itable != nullptr) {
+            return &(*itable)[entry->methodSlot];
         }
-    } else {
-        throw runtime_error("can not find method to call");
     }
-    frames->popFrame();
+    selected =
+        selectVirtualMethod(receiverClass, entry->name, entry->descriptor);
+    return &selected;
+}
 
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
+//--------------------------------------------------------------------------------
+// Select instance method resolved into entry based on class of receiver. The
+// selected method is remembered in inline cache of the call site if there is
+// one
+//--------------------------------------------------------------------------------
+const CallSite &Interpreter::selectVirtualCallSite(const ResolvedEntry *entry,
+                                                   MethodData *methodData,
+                                                   InlineCache *cache) {
+    auto *thisRef =
+        frames->top()
+            ->stackSlots[frames->top()->stackTop - entry->parameter.size() - 1]
+            .as<JObject>();
+    if (thisRef == nullptr) {
+        throw runtime_error("null pointer");
     }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
+
+    if (cache != nullptr) {
+        const CallSite *cached = cache->lookup(thisRef->jc);
+        if (likely(cached != nullptr)) {
+            return *cached;
         }
     }
 
-    GC_SAFE_POINT
-    if (runtime.gc->shallGC()) {
-        runtime.gc->stopTheWorld();
-        runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
+    const CallSite *csite =
+        selectVirtualMethod(thisRef->jc, entry, selectedByName);
+    if (!csite->isCallable() || IS_METHOD_ABSTRACT(csite->accessFlags)) {
+        throw runtime_error("can not find method " + entry->name + " " +
+                            entry->descriptor);
     }
+    if (cache != nullptr && !cache->isMegamorphic()) {
+        methodData->updateInlineCache(cache, thisRef->jc, *csite);
+    }
+    return *csite;
 }
+
 //--------------------------------------------------------------------------------
 //  Invoke instance method; special handling for superclass, private,
 //  and instance initialization method invocations
 //--------------------------------------------------------------------------------
 void Interpreter::invokeSpecial(const JavaClass *jc, const string &name,
                                 const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
+    invokeCallSite(resolveSpecialMethod(jc, name, descriptor));
+}
 
+CallSite Interpreter::resolveSpecialMethod(const JavaClass *jc,
+                                           const string &name,
+                                           const string &descriptor) {
     auto csite = findInstanceMethod(jc, name, descriptor);
     if (!csite.isCallable()) {
         csite = findInstanceMethodOnSupers(jc, name, descriptor);
@@ -1820,42 +3013,17 @@ void Interpreter::invokeSpecial(const JavaClass *jc, const string &name,
             }
         }
     }
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
-    }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
-    JType *returnValue{};
-
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
-    } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
-    }
-    frames->popFrame();
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
-    }
-
-    GC_SAFE_POINT
-    if (runtime.gc->shallGC()) {
-        runtime.gc->stopTheWorld();
-        runtime.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
-    }
+    return csite;
 }
 
 void Interpreter::invokeStatic(const JavaClass *jc, const string &name,
                                const string &descriptor) {
+    invokeCallSite(resolveStaticMethod(jc, name, descriptor));
+}
+
+CallSite Interpreter::resolveStaticMethod(const JavaClass *jc,
+                                          const string &name,
+                                          const string &descriptor) {
     // Get instance method name and descriptor from CONSTANT_Methodref
     // locating by index and get interface method parameter and return value
     // descriptor
@@ -1863,10 +3031,6 @@ void Interpreter::invokeStatic(const JavaClass *jc, const string &name,
     runtime.cs->initClassIfAbsent(*this,
                               const_cast<JavaClass *>(jc)->getClassName());
 
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
     auto csite = CallSite::makeCallSite(jc, jc->findMethod(name, descriptor));
     if (!csite.isCallable()) {
         throw runtime_error("can not find method " + name + " " + descriptor);
@@ -1874,32 +3038,155 @@ void Interpreter::invokeStatic(const JavaClass *jc, const string &name,
     assert(IS_METHOD_STATIC(csite.accessFlags) == true);
     assert(IS_METHOD_ABSTRACT(csite.accessFlags) == false);
     assert("<init>" != name);
+    return csite;
+}
 
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size();
+//--------------------------------------------------------------------------------
+// Push frame of a method called from the dispatch loop, its arguments are
+// taken over from caller's operand stack
+//--------------------------------------------------------------------------------
+void Interpreter::enterMethod(const CallSite &csite) {
+    csite.data->countInvocation();
+    frames->pushFrame(csite.maxLocal, csite.maxStack,
+                      csite.data->getArgumentCount());
+    placeMethodArguments(csite);
+    frames->top()->jc = csite.jc;
+    frames->top()->method = csite.data;
+}
+
+//--------------------------------------------------------------------------------
+// Unwind frames above entryDepth for throwobj, until a method can handle it.
+// That method becomes the top frame and op is set to its handler. Return false
+// if none of them can handle it
+//--------------------------------------------------------------------------------
+bool Interpreter::unwindException(JObject *throwobj, size_t entryDepth,
+                                  u4 &pc) {
+    while (frames->depth() > entryDepth) {
+        exception.extendExceptionStackTrace(frames->top()->method->getName());
+        frames->popFrame();
+
+        Slots *caller = frames->top();
+        pc = caller->pc;
+        if (handleException(caller->jc,
+                            caller->method->getExceptionTableLength(),
+                            caller->method->getExceptionTable(), throwobj,
+                            pc)) {
+            while (!caller->emptyStack()) {
+                caller->pop();
+            }
+            caller->push<JObject>(throwobj);
+            exception.sweepException();
+            return true;
+        }
     }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, false);
-    JType *returnValue{};
+    return false;
+}
+
+//--------------------------------------------------------------------------------
+// Run a method classified as trivial in the invoking frame. Its arguments are
+// taken from the operand stack and its result is pushed there, as if it was
+// invoked. The method is neither profiled nor a GC safe point. Return false
+// and leave the operand stack alone if csite must be invoked normally
+//--------------------------------------------------------------------------------
+bool Interpreter::invokeTrivialMethod(const CallSite &csite) {
+    const MethodData *data = csite.data;
+    Slots *frame = frames->top();
+    const int base = frame->stackTop - data->getArgumentCount();
+    const JValue *args = frame->stackSlots + base;
+    JValue result;
+    switch (data->getTrivialKind()) {
+        case TrivialKind::None:
+            return false;
+        case TrivialKind::Empty:
+            break;
+        case TrivialKind::Constant:
+            result = data->getTrivialConstant();
+            break;
+        case TrivialKind::Getter:
+        case TrivialKind::Setter: {
+            const ResolvedEntry *entry =
+                csite.jc->getConstPoolCache()->resolveField(
+                    data->getTrivialIndex());
+            JObject *objectref = args[0].as<JObject>();
+            if (objectref == nullptr) {
+                throw runtime_error("null pointer");
+            }
+            if (data->getTrivialKind() == TrivialKind::Getter) {
+                result =
+                    runtime.heap->getField(*objectref, entry->instanceField);
+            } else {
+                runtime.heap->putField(*objectref, entry->instanceField,
+                                       args[1]);
+            }
+        } break;
+        case TrivialKind::SuperConstructor: {
+            // Follow constructors up the class hierarchy, the whole chain is
+            // trivial if it ends at an empty one
+            const CallSite *target = &csite;
+            while (target->data->getTrivialKind() ==
+                   TrivialKind::SuperConstructor) {
+                target = &target->jc->getConstPoolCache()
+                              ->resolveMethod(target->data->getTrivialIndex())
+                              ->csite;
+                if (!target->isCallable() ||
+                    IS_METHOD_STATIC(target->accessFlags) ||
+                    strcmp(target->data->getName(), "<init>") != 0 ||
+                    target->data->getArgumentCount() != 1) {
+                    return false;
+                }
+            }
+            if (target->data->getTrivialKind() != TrivialKind::Empty) {
+                return false;
+            }
+        } break;
+    }
+    frame->stackTop = base;
+    if (data->getReturnType() != T_EXTRA_VOID) {
+        frame->push(result);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+// Execute a resolved method. Callee's frame takes arguments over from caller's
+// operand stack, and then return value or the propagated exception is pushed
+// back to it. The frame size and argument kinds come from MethodData of
+// callee, so nothing is allocated here
+//--------------------------------------------------------------------------------
+void Interpreter::invokeCallSite(const CallSite &csite) {
+    if (csite.data->getTrivialKind() != TrivialKind::None &&
+        invokeTrivialMethod(csite)) {
+        return;
+    }
+    // Callee runs in a nested C++ call, unlike those entered by execByteCode()
+    frames->checkNativeStack();
+    csite.data->countInvocation();
+    frames->pushFrame(csite.maxLocal, csite.maxStack,
+                      csite.data->getArgumentCount());
+    placeMethodArguments(csite);
+
+    JValue returnValue;
     if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
+        returnValue = execNativeMethod(csite);
+    } else if (const RegisterCode *registerCode =
+                   runtime.tierPolicy->registerCodeOf(csite)) {
+        // Methods it calls run in the same dispatch loop
+        frames->top()->registerCode = registerCode;
+        returnValue = execByteCode(csite);
+    } else if (isStackCached(csite)) {
+        returnValue = execStackCachedCode(csite);
     } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
+        returnValue = execByteCode(csite);
     }
     frames->popFrame();
 
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
     if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
+        // Leave the thrown object on caller's stack, it will be handled or
+        // propagated again before caller executes its next instruction
+        frames->top()->push(returnValue);
+        exception.extendExceptionStackTrace(csite.data->getName());
+    } else if (csite.data->getReturnType() != T_EXTRA_VOID) {
         frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
     }
 
     GC_SAFE_POINT
@@ -24,8 +24,11 @@
 #ifndef YVM_INTERPRETER_H
 #define YVM_INTERPRETER_H
 
+#include <atomic>
+#include <cmath>
 #include <typeinfo>
 #include "../classfile/ClassFile.h"
+#include "CallSite.h"
 #include "../runtime/JavaException.h"
 #include "../runtime/JavaFrame.hpp"
 #include "../runtime/JavaHeap.hpp"
@@ -35,6 +38,13 @@
 #pragma warning(disable : 4244)
 
 struct MethodInfo;
+class MethodData;
+struct InlineCache;
+class RegisterCode;
+class JitCode;
+struct JitContext;
+struct RegisterInstruction;
+struct ResolvedEntry;
 struct RuntimeEnv;
 extern RuntimeEnv runtime;
 using std::string;
@@ -56,22 +66,69 @@ public:
                       const string& descriptor);
     void invokeVirtual(const string& name, const string& descriptor);
 
+    // Name of the bytecode dispatching technique this build uses
+    static const char* dispatchMode();
+
+    // Whether execStackCachedCode() can run code of a method
+    static bool canCacheStack(const u1* code, u4 codeLength,
+                              u2 exceptionTableLength);
+
+    // Entry of runtime calls made by compiled code, return a JitStatus
+    static int runtimeCallFromJit(JitContext* context,
+                                  const RegisterInstruction* instruction);
+
+#ifdef YVM_DISPATCH_STATS
+    // Bytecodes interpreted by all threads so far
+    static std::atomic<uint64_t> totalDispatched;
+#endif
+
 private:
     bool checkInstanceof(const JavaClass* jc, u2 index, JType* objectref);
 
     JObject* execNew(const JavaClass* jc, u2 index);
-    JType* execByteCode(const JavaClass* jc, u1* code, u4 codeLength,
-                        u2 exceptLen, ExceptionTable* exceptTab);
-    JType* execNativeMethod(const string& className, const string& methodName,
-                            const string& methodDescriptor);
-
-    void loadConstantPoolItem2Stack(const JavaClass* jc, u2 index);
+    JValue execByteCode(const CallSite& csite);
+    // Interpret with the top of operand stack cached in variables, it takes
+    // methods canCacheStack() accepts when stack caching is enabled
+    JValue execStackCachedCode(const CallSite& csite);
+    JValue execNativeMethod(const CallSite& csite);
+    // Run register code or machine code of a method from instruction entry,
+    // which is 0, an OSR entry of registerCode or the instruction after a call
+    JValue execRegisterCode(const CallSite& csite,
+                            const RegisterCode& registerCode,
+                            int32_t entry = 0);
+    int execRegisterRuntimeCall(const CallSite& csite,
+                                const RegisterCode& registerCode,
+                                const RegisterInstruction* instruction);
+    JValue execJitCode(const CallSite& csite, const RegisterCode& registerCode,
+                       const JitCode& jitCode, int32_t entry = 0);
+    bool execRegisterFrame(JValue& result);
+    bool execOsrCode(const JavaClass* jc, MethodData* methodData,
+                     const RegisterCode& registerCode, u4 pc, JValue& result);
 
     bool handleException(const JavaClass* jc, u2 exceptLen,
                          ExceptionTable* exceptTab, const JObject* objectref,
                          u4& op);
 
-    void pushMethodArguments(std::vector<int>& parameter, bool isObjectMethod);
+    // Handle the exception object a callee left on the operand stack, return
+    // it if current method can not catch it
+    JObject* catchPropagatedException(const JavaClass* jc, u2 exceptLen,
+                                      ExceptionTable* exceptTab, u4& op);
+
+    void placeMethodArguments(const CallSite& csite);
+
+    CallSite resolveSpecialMethod(const JavaClass* jc, const string& name,
+                                  const string& descriptor);
+    CallSite resolveStaticMethod(const JavaClass* jc, const string& name,
+                                 const string& descriptor);
+    const CallSite& selectVirtualCallSite(const ResolvedEntry* entry,
+                                          MethodData* methodData,
+                                          InlineCache* cache);
+
+    void enterMethod(const CallSite& csite);
+    bool unwindException(JObject* throwobj, size_t entryDepth, u4& pc);
+
+    void invokeCallSite(const CallSite& csite);
+    bool invokeTrivialMethod(const CallSite& csite);
 
 private:
     template <typename ResultType>
@@ -89,39 +146,34 @@ private:
 private:
     JavaFrame* frames;
     JavaException exception;
+    // Virtual method looked up by name, see selectVirtualCallSite()
+    CallSite selectedByName;
 };
 
 template <typename ResultType, typename CallableObjectType>
 void Interpreter::binaryArithmetic(CallableObjectType op) {
-    auto* value2 = frames->top()->pop<ResultType>();
-    auto* value1 = frames->top()->pop<ResultType>();
-    auto* result = new ResultType;
-    result->val = op(value1->val, value2->val);
-    frames->top()->push(result);
+    auto value2 = frames->top()->pop<ResultType>();
+    auto value1 = frames->top()->pop<ResultType>();
+    frames->top()->push<ResultType>(op(value1, value2));
 }
 
 template <typename ResultType, typename CallableObjectType>
 void Interpreter::unaryArithmetic(CallableObjectType op) {
-    auto* ival = frames->top()->pop<ResultType>();
-    ival->val = op(ival->val);
-    frames->top()->push(ival);
+    auto ival = frames->top()->pop<ResultType>();
+    frames->top()->push<ResultType>(op(ival));
 }
 
 template <typename Type1, typename Type2>
 void Interpreter::typeCast() const {
-    auto* value = frames->top()->pop<Type1>();
-    auto* result = new Type2;
-    result->val = value->val;
-    frames->top()->push(result);
+    auto value = frames->top()->pop<Type1>();
+    frames->top()->push<Type2>(value);
 }
 
 template <typename ResultType>
 void Interpreter::fmodArithmetic() const {
-    auto* value2 = frames->top()->pop<ResultType>();
-    auto* value1 = frames->top()->pop<ResultType>();
-    auto* result = new ResultType;
-    result->val = std::fmod(value1->val, value2->val);
-    frames->top()->push(result);
+    auto value2 = frames->top()->pop<ResultType>();
+    auto value1 = frames->top()->pop<ResultType>();
+    frames->top()->push<ResultType>(std::fmod(value1, value2));
 }
 
 #endif  // YVM_INTERPRETER_H
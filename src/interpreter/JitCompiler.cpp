@@ -0,0 +1,402 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "JitCompiler.h"
+#include "../misc/Option.h"
+#include "../misc/Utils.h"
+#include "Interpreter.hpp"
+#include "RegisterCode.h"
+
+#ifdef YVM_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------
+// Executable memory reserved on first use. Compiled code is bump-allocated
+// from it and never freed
+//--------------------------------------------------------------------------------
+class CodeCache {
+public:
+    static void* allocate(size_t size) {
+        static CodeCache cache;
+        std::lock_guard<std::mutex> lock(cache.mtx);
+        if (cache.base == nullptr ||
+            cache.top + size > YVM_JIT_CODE_CACHE_SIZE) {
+            return nullptr;
+        }
+        void* code = cache.base + cache.top;
+        // Keep entries of compiled methods 16 bytes aligned
+        cache.top += (size + 15) & ~static_cast<size_t>(15);
+        return code;
+    }
+
+private:
+    CodeCache() {
+        void* mem = mmap(nullptr, YVM_JIT_CODE_CACHE_SIZE,
+                         PROT_READ | PROT_WRITE | PROT_EXEC,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        base = mem == MAP_FAILED ? nullptr : static_cast<u1*>(mem);
+    }
+
+    u1* base;
+    size_t top = 0;
+    std::mutex mtx;
+};
+
+static_assert(sizeof(JValue) == 16 && offsetof(JValue, tag) == 8,
+              "compiled code depends on layout of JValue");
+
+// Register numbers of x86-64 used by templates
+enum { RAX = 0, RCX = 1, RSI = 6, RDI = 7 };
+
+//--------------------------------------------------------------------------------
+// Emit machine code for register code. rbx holds the register file, which is
+// the local variables of current frame, and r12 holds JitContext. eax and ecx
+// are scratch registers, operands are loaded from registers or encoded as
+// immediates if they are constants
+//--------------------------------------------------------------------------------
+class X64Assembler {
+public:
+    explicit X64Assembler(const RegisterCode& registerCode)
+        : registerCode(registerCode),
+          consts(registerCode.getConstants()),
+          labels(registerCode.size()) {}
+
+    std::vector<u1>& assemble();
+
+private:
+    void emit(std::initializer_list<u1> bytes) {
+        code.insert(code.end(), bytes);
+    }
+    void emit32(u4 value) {
+        for (int i = 0; i < 4; i++) {
+            code.push_back(static_cast<u1>(value >> (i * 8)));
+        }
+    }
+    void emit64(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            code.push_back(static_cast<u1>(value >> (i * 8)));
+        }
+    }
+    template <typename T>
+    void emitPointer(T* pointer) {
+        emit64(reinterpret_cast<uint64_t>(pointer));
+    }
+
+    static u4 disp(int16_t reg) {
+        return static_cast<u4>(reg) * sizeof(JValue);
+    }
+    const JValue& constant(int16_t operand) const {
+        return consts[-operand - 1];
+    }
+
+    void loadInt(int r, int16_t operand);
+    void loadRef(int r, int16_t operand);
+    void storeInt(int16_t dst);
+    void loadOperand(int16_t operand);
+    void arithmetic(const RegisterInstruction& instruction);
+    void compare(const RegisterInstruction& instruction);
+    void jump(u1 condition, int32_t target);
+    void exitIfFailed();
+    void call(const void* function);
+
+private:
+    const RegisterCode& registerCode;
+    const JValue* consts;
+    std::vector<u1> code;
+    // Offset of each register instruction in code
+    std::vector<size_t> labels;
+    // Offsets of rel32 fields and register instructions they jump to
+    std::vector<std::pair<size_t, int32_t>> fixups;
+    // Offsets of rel32 fields jumping to the epilogue
+    std::vector<size_t> exits;
+};
+
+// mov r32, [rbx + disp32] or mov r32, imm32
+void X64Assembler::loadInt(int r, int16_t operand) {
+    if (operand >= 0) {
+        emit({0x8b, static_cast<u1>(0x83 | (r << 3))});
+        emit32(disp(operand));
+    } else {
+        emit({static_cast<u1>(0xb8 + r)});
+        emit32(static_cast<u4>(constant(operand).i));
+    }
+}
+
+// mov r64, [rbx + disp32] or mov r64, imm64
+void X64Assembler::loadRef(int r, int16_t operand) {
+    if (operand >= 0) {
+        emit({0x48, 0x8b, static_cast<u1>(0x83 | (r << 3))});
+        emit32(disp(operand));
+    } else {
+        emit({0x48, static_cast<u1>(0xb8 + r)});
+        emitPointer(constant(operand).ref);
+    }
+}
+
+// mov [rbx + disp32], rax; mov byte [rbx + disp32 + 8], ValueTag::Int. Upper
+// half of rax is cleared by the 32 bits instruction that computed eax
+void X64Assembler::storeInt(int16_t dst) {
+    emit({0x48, 0x89, 0x83});
+    emit32(disp(dst));
+    emit({0xc6, 0x83});
+    emit32(disp(dst) + 8);
+    emit({static_cast<u1>(ValueTag::Int)});
+}
+
+// movups xmm0, [rbx + disp32] or movups xmm0, [constant]
+void X64Assembler::loadOperand(int16_t operand) {
+    if (operand >= 0) {
+        emit({0x0f, 0x10, 0x83});
+        emit32(disp(operand));
+    } else {
+        emit({0x48, 0xb8});
+        emitPointer(&constant(operand));
+        emit({0x0f, 0x10, 0x00});
+    }
+}
+
+void X64Assembler::arithmetic(const RegisterInstruction& instruction) {
+    loadInt(RAX, instruction.a);
+    switch (instruction.opcode) {
+        case reg_idiv:
+        case reg_irem:
+            // cdq; idiv ecx, remainder is in edx
+            loadInt(RCX, instruction.b);
+            emit({0x99, 0xf7, 0xf9});
+            if (instruction.opcode == reg_irem) {
+                emit({0x89, 0xd0});
+            }
+            break;
+        case reg_ineg:
+            emit({0xf7, 0xd8});
+            break;
+        case reg_imul:
+            if (instruction.b >= 0) {
+                emit({0x0f, 0xaf, 0x83});
+                emit32(disp(instruction.b));
+            } else {
+                emit({0x69, 0xc0});
+                emit32(static_cast<u4>(constant(instruction.b).i));
+            }
+            break;
+        default: {
+            // add, sub, and, or, xor with a memory or an immediate operand
+            static const u1 memoryForm[] = {0x03, 0x2b, 0, 0, 0,
+                                            0x23, 0x0b, 0x33};
+            static const u1 immediateForm[] = {0x05, 0x2d, 0, 0, 0,
+                                               0x25, 0x0d, 0x35};
+            const int i = instruction.opcode - reg_iadd;
+            if (instruction.b >= 0) {
+                emit({memoryForm[i], 0x83});
+                emit32(disp(instruction.b));
+            } else {
+                emit({immediateForm[i]});
+                emit32(static_cast<u4>(constant(instruction.b).i));
+            }
+        }
+    }
+    storeInt(instruction.dst);
+}
+
+// Jump to target if condition(second byte of jcc rel32) holds, or always if
+// condition is 0
+void X64Assembler::jump(u1 condition, int32_t target) {
+    if (condition == 0) {
+        emit({0xe9});
+    } else {
+        emit({0x0f, condition});
+    }
+    fixups.emplace_back(code.size(), target);
+    emit32(0);
+}
+
+void X64Assembler::compare(const RegisterInstruction& instruction) {
+    enum : u1 {
+        JE = 0x84,
+        JNE = 0x85,
+        JL = 0x8c,
+        JGE = 0x8d,
+        JLE = 0x8e,
+        JG = 0x8f
+    };
+    static const u1 conditions[] = {JE, JNE, JL, JGE, JG, JLE};
+    const u1 op = instruction.opcode;
+    if (op >= reg_ifeq && op <= reg_if_icmple) {
+        loadInt(RAX, instruction.a);
+        const bool withZero = op <= reg_ifle;
+        if (!withZero && instruction.b >= 0) {
+            // cmp eax, [rbx + disp32]
+            emit({0x3b, 0x83});
+            emit32(disp(instruction.b));
+        } else {
+            // cmp eax, imm32
+            emit({0x3d});
+            emit32(withZero ? 0 : static_cast<u4>(constant(instruction.b).i));
+        }
+        jump(conditions[withZero ? op - reg_ifeq : op - reg_if_icmpeq],
+             instruction.target);
+    } else if (op == reg_ifnull || op == reg_ifnonnull) {
+        // test rax, rax
+        loadRef(RAX, instruction.a);
+        emit({0x48, 0x85, 0xc0});
+        jump(op == reg_ifnull ? JE : JNE, instruction.target);
+    } else {
+        // test al, al on result of isSameReference()
+        loadRef(RDI, instruction.a);
+        loadRef(RSI, instruction.b);
+        call(reinterpret_cast<const void*>(&isSameReference));
+        emit({0x84, 0xc0});
+        jump(op == reg_if_acmpeq ? JNE : JE, instruction.target);
+    }
+}
+
+// mov rax, imm64; call rax
+void X64Assembler::call(const void* function) {
+    emit({0x48, 0xb8});
+    emitPointer(function);
+    emit({0xff, 0xd0});
+}
+
+// test eax, eax; jnz epilogue
+void X64Assembler::exitIfFailed() {
+    emit({0x85, 0xc0, 0x0f, 0x85});
+    exits.push_back(code.size());
+    emit32(0);
+}
+
+std::vector<u1>& X64Assembler::assemble() {
+    // push rbx; push r12; sub rsp, 8; mov rbx, rdi; mov r12, rsi
+    emit({0x53, 0x41, 0x54, 0x48, 0x83, 0xec, 0x08});
+    emit({0x48, 0x89, 0xfb, 0x49, 0x89, 0xf4});
+
+    // mov eax, [r12 + entry]; test eax, eax; jnz reentry
+    emit({0x41, 0x8b, 0x84, 0x24});
+    emit32(offsetof(JitContext, entry));
+    emit({0x85, 0xc0, 0x0f, 0x85});
+    const size_t reentryJump = code.size();
+    emit32(0);
+
+    const RegisterInstruction* instructions = registerCode.getInstructions();
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        const RegisterInstruction& instruction = instructions[i];
+        labels[i] = code.size();
+        switch (instruction.opcode) {
+            case reg_move:
+                // movups [rbx + disp32], xmm0
+                loadOperand(instruction.a);
+                emit({0x0f, 0x11, 0x83});
+                emit32(disp(instruction.dst));
+                break;
+            case reg_iadd:
+            case reg_isub:
+            case reg_imul:
+            case reg_idiv:
+            case reg_irem:
+            case reg_iand:
+            case reg_ior:
+            case reg_ixor:
+            case reg_ineg:
+                arithmetic(instruction);
+                break;
+            case reg_goto:
+                jump(0, instruction.target);
+                break;
+            case reg_return:
+                // lea rax, [r12 + result]; movups [rax], xmm0
+                loadOperand(instruction.a);
+                emit({0x49, 0x8d, 0x84, 0x24});
+                emit32(offsetof(JitContext, result));
+                emit({0x0f, 0x11, 0x00});
+                // Fall through
+            case reg_return_void:
+                // xor eax, eax; jmp epilogue
+                emit({0x31, 0xc0, 0xe9});
+                exits.push_back(code.size());
+                emit32(0);
+                break;
+            default:
+                if (instruction.opcode >= reg_ifeq &&
+                    instruction.opcode <= reg_ifnonnull) {
+                    compare(instruction);
+                } else {
+                    // mov rdi, r12; mov rsi, instruction
+                    emit({0x4c, 0x89, 0xe7, 0x48, 0xbe});
+                    emitPointer(&instruction);
+                    call(reinterpret_cast<const void*>(
+                        &Interpreter::runtimeCallFromJit));
+                    exitIfFailed();
+                }
+        }
+    }
+
+    // add rsp, 8; pop r12; pop rbx; ret
+    const size_t epilogue = code.size();
+    emit({0x48, 0x83, 0xc4, 0x08, 0x41, 0x5c, 0x5b, 0xc3});
+
+    auto patch = [this](size_t at, size_t target) {
+        const u4 rel = static_cast<u4>(target - (at + 4));
+        memcpy(&code[at], &rel, sizeof(rel));
+    };
+    // Loop headers and instructions after calls are entered through a table
+    // holding offsets of every instruction from the table:
+    // lea rcx, [rip + table]; movsxd rax, [rcx + rax * 4]; add rax, rcx;
+    // jmp rax
+    patch(reentryJump, code.size());
+    emit({0x48, 0x8d, 0x0d});
+    emit32(9);
+    emit({0x48, 0x63, 0x04, 0x81, 0x48, 0x01, 0xc8, 0xff, 0xe0});
+    const size_t table = code.size();
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        emit32(static_cast<u4>(labels[i] - table));
+    }
+    for (const auto& fixup : fixups) {
+        patch(fixup.first, labels[fixup.second]);
+    }
+    for (size_t at : exits) {
+        patch(at, epilogue);
+    }
+    return code;
+}
+
+const JitCode* JitCode::compile(const RegisterCode& registerCode) {
+    X64Assembler assembler(registerCode);
+    const std::vector<u1>& code = assembler.assemble();
+    void* entry = CodeCache::allocate(code.size());
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    memcpy(entry, code.data(), code.size());
+    return new JitCode(reinterpret_cast<JitEntry>(entry), code.size());
+}
+
+#else
+
+const JitCode* JitCode::compile(const RegisterCode& registerCode) {
+    return nullptr;
+}
+
+#endif  // YVM_JIT_AVAILABLE
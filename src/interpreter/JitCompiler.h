@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_JITCOMPILER_H
+#define YVM_JITCOMPILER_H
+
+#include <cstddef>
+#include <exception>
+#include "../runtime/JavaType.h"
+
+//--------------------------------------------------------------------------------
+// Machine code is only generated for x86-64 System V targets, methods keep
+// running as register code everywhere else
+//--------------------------------------------------------------------------------
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define YVM_JIT_AVAILABLE
+#endif
+
+class Interpreter;
+class RegisterCode;
+struct CallSite;
+struct RegisterInstruction;
+
+// Status returned by compiled code and the runtime calls it makes
+enum JitStatus {
+    // Method returned, or the runtime call is done
+    JIT_OK = 0,
+    // Callee left an exception on operand stack of current frame
+    JIT_EXCEPTION,
+    // A C++ exception is saved in JitContext::error
+    JIT_ERROR,
+    // Frame of a callee has been pushed, compiled code returns so that callee
+    // runs in the dispatch loop, and is entered again at the instruction after
+    // the call once callee returned
+    JIT_CALL
+};
+
+//--------------------------------------------------------------------------------
+// JitContext is shared by compiled code of a method activation and runtime
+// calls it makes. C++ exceptions can not unwind through compiled frames, so
+// runtime calls catch them and compiled code returns before they are rethrown
+//--------------------------------------------------------------------------------
+struct JitContext {
+    Interpreter* interpreter;
+    const CallSite* csite;
+    const RegisterCode* registerCode;
+    JValue result;
+    std::exception_ptr error;
+    // Register instruction to start at, it's an OSR entry of register code or
+    // the instruction after a call if it's not 0. Methods compiled by yvmc
+    // never run as bytecode, so their functions are only entered after calls
+    int32_t entry;
+};
+
+using JitEntry = int (*)(JValue* regs, JitContext* context);
+
+//--------------------------------------------------------------------------------
+// JitCode is x86-64 machine code compiled from register code of a method, one
+// template per register instruction. Registers are addressed in the frame
+// directly, int arithmetic, compares and branches are inlined, everything
+// else calls back into Interpreter::runtimeCallFromJit(). Code is kept in an
+// executable code cache for the life of the VM. Functions yvmc generated from
+// register code follow the same convention
+//--------------------------------------------------------------------------------
+class JitCode {
+public:
+    // Return nullptr if there is no JIT for this platform or code cache is
+    // exhausted
+    static const JitCode* compile(const RegisterCode& registerCode);
+    // Function generated by yvmc, it's available on every platform
+    static const JitCode* precompiled(JitEntry entry) {
+        return new JitCode(entry, 0);
+    }
+
+    JitEntry getEntry() const { return entry; }
+    size_t getSize() const { return size; }
+
+private:
+    JitCode(JitEntry entry, size_t size) : entry(entry), size(size) {}
+
+    JitEntry entry;
+    size_t size;
+};
+
+#endif  // YVM_JITCOMPILER_H
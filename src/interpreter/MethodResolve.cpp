@@ -52,8 +52,7 @@ CallSite findInstanceMethodOnSupers(const JavaClass *jc,
         return CallSite{};
     }
 
-    JavaClass *superClass =
-        runtime.cs->loadClassIfAbsent(jc->getSuperClassName());
+    JavaClass *superClass = jc->getSuperClass();
     auto methodInfo = superClass->findMethod(methodName, methodDescriptor);
     if (methodInfo && !IS_METHOD_STATIC(methodInfo->accessFlags)) {
         return CallSite::makeCallSite(superClass, methodInfo);
@@ -90,16 +89,11 @@ CallSite findMaximallySpecifiedMethod(const JavaClass *jc,
     if (!jc->hasSuperClass()) {
         return CallSite{};
     }
-    JavaClass *superClass =
-        runtime.cs->loadClassIfAbsent(jc->getSuperClassName());
+    JavaClass *superClass = jc->getSuperClass();
 
     if (superClass->getInterfaceCount()) {
         FOR_EACH(eachInterface, jc->getInterfaceCount()) {
-            const std::string &interfaceName =
-                jc->getInterfaceClassName(eachInterface);
-
-            JavaClass *interfaceClass =
-                runtime.cs->loadClassIfAbsent(interfaceName);
+            JavaClass *interfaceClass = jc->getInterfaceClass(eachInterface);
             auto *methodInfo =
                 interfaceClass->findMethod(methodName, methodDescriptor);
             if (methodInfo && (!IS_METHOD_ABSTRACT(methodInfo->accessFlags) &&
@@ -117,3 +111,42 @@ CallSite findMaximallySpecifiedMethod(const JavaClass *jc,
     return findMaximallySpecifiedMethod(superClass, methodName,
                                         methodDescriptor);
 }
+
+//--------------------------------------------------------------------------------
+// Method resolution(5.4.3.3), it looks up the referred method in C and its
+// superclasses, and then in superinterfaces of C. The result is cached in
+// constant pool cache of the referring class, and used by invokespecial and
+// invokestatic directly
+//--------------------------------------------------------------------------------
+CallSite resolveMethod(const JavaClass *jc, const std::string &methodName,
+                       const std::string &methodDescriptor) {
+    for (const JavaClass *c = jc; c != nullptr; c = c->getSuperClass()) {
+        auto *methodInfo = c->findMethod(methodName, methodDescriptor);
+        if (methodInfo) {
+            return CallSite::makeCallSite(c, methodInfo);
+        }
+    }
+    auto csite = findJavaLangObjectMethod(jc, methodName, methodDescriptor);
+    if (!csite.isCallable()) {
+        csite = findMaximallySpecifiedMethod(jc, methodName, methodDescriptor);
+    }
+    return csite;
+}
+
+//--------------------------------------------------------------------------------
+// Method selection(5.4.6) of invokevirtual and invokeinterface by name, it
+// looks up the method in receiver's class C, its superclasses and finally its
+// superinterfaces
+//--------------------------------------------------------------------------------
+CallSite selectVirtualMethod(const JavaClass *jc, const std::string &methodName,
+                             const std::string &methodDescriptor) {
+    auto csite = findInstanceMethod(jc, methodName, methodDescriptor);
+    if (!csite.isCallable()) {
+        csite = findInstanceMethodOnSupers(jc, methodName, methodDescriptor);
+        if (!csite.isCallable()) {
+            csite =
+                findMaximallySpecifiedMethod(jc, methodName, methodDescriptor);
+        }
+    }
+    return csite;
+}
@@ -65,4 +65,10 @@ CallSite findJavaLangObjectMethod(const JavaClass* jc,
                                   const std::string& methodName,
                                   const std::string& methodDescriptor);
 
+CallSite resolveMethod(const JavaClass* jc, const std::string& methodName,
+                       const std::string& methodDescriptor);
+
+CallSite selectVirtualMethod(const JavaClass* jc, const std::string& methodName,
+                             const std::string& methodDescriptor);
+
 #endif  // !_METHODRESOLVE_H
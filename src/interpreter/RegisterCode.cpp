@@ -0,0 +1,669 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "RegisterCode.h"
+#include "../misc/Utils.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/MethodData.h"
+#include "AotRuntime.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <tuple>
+
+//--------------------------------------------------------------------------------
+// Translate bytecode of a method by walking it once while simulating its
+// operand stack. Every stack value is an operand: a local variable register,
+// a constant or its own stack slot register. Values that are not in their
+// stack slots yet are materialized before branches, at branch targets and
+// before instructions that may run Java code, so control flow merges and
+// callees always see a canonical operand stack
+//--------------------------------------------------------------------------------
+class RegisterTranslator {
+public:
+    RegisterTranslator(const JavaClass* jc, const MethodData* data,
+                       RegisterCode& result)
+        : jc(jc),
+          data(data),
+          code(data->getCode()),
+          originalCode(data->getOriginalCode()),
+          codeLength(data->getCodeLength()),
+          base(data->getMaxLocals()),
+          maxStack(data->getMaxStack()),
+          result(result),
+          branchTarget(data->getCodeLength(), false),
+          targetDepth(data->getCodeLength(), -1),
+          label(data->getCodeLength(), -1) {}
+
+    bool translate();
+
+private:
+    bool findBranchTargets();
+    bool readMethodRef(u2 index, bool isInterface, std::string& className,
+                       std::string& name, std::string& descriptor) const;
+    bool translateInstruction(u4 pc, u1 opcode);
+
+    int depth() const { return static_cast<int>(stack.size()); }
+    int16_t slotOf(int d) const { return static_cast<int16_t>(base + d); }
+
+    int16_t constant(const JValue& value);
+    int16_t pop();
+    bool pushSlot();
+    void materialize(int d);
+    void materializeAll();
+    bool isReferred(int16_t reg) const;
+    void materializeReferences(int16_t reg);
+    void storeLocal(int16_t local, bool producedTop);
+
+    RegisterInstruction& emit(u1 opcode, int16_t dst = 0, int16_t a = 0,
+                              int16_t b = 0);
+    bool emitBranch(u1 opcode, u4 pc, int16_t a = 0, int16_t b = 0);
+
+private:
+    const JavaClass* jc;
+    const MethodData* data;
+    const u1* code;
+    const u1* originalCode;
+    const u4 codeLength;
+    const int base;
+    const int maxStack;
+    RegisterCode& result;
+
+    // Operand of each simulated stack value
+    std::vector<int16_t> stack;
+    std::vector<bool> branchTarget;
+    // Stack depth expected at branch targets, or -1 if it's not known yet
+    std::vector<int> targetDepth;
+    // Index of first register instruction of each bytecode instruction
+    std::vector<int> label;
+    // Branch instructions and bytecode pcs they jump to
+    std::vector<std::pair<size_t, u4>> fixups;
+    // Targets of backward branches
+    std::vector<u4> loopHeaders;
+    bool reachable = true;
+    // Whether the last register instruction computed the value on stack top
+    bool lastProducedTop = false;
+};
+
+int16_t RegisterTranslator::constant(const JValue& value) {
+    result.constants.push_back(value);
+    return static_cast<int16_t>(-static_cast<int>(result.constants.size()));
+}
+
+int16_t RegisterTranslator::pop() {
+    const int16_t operand = stack.back();
+    stack.pop_back();
+    return operand;
+}
+
+// Push the value an instruction puts into stack slot register of current
+// depth
+bool RegisterTranslator::pushSlot() {
+    if (depth() >= maxStack) {
+        return false;
+    }
+    stack.push_back(slotOf(depth()));
+    return true;
+}
+
+void RegisterTranslator::materialize(int d) {
+    if (stack[d] != slotOf(d)) {
+        emit(reg_move, slotOf(d), stack[d]);
+        stack[d] = slotOf(d);
+    }
+}
+
+// Moving values upward from the bottom is safe, a value never refers to the
+// stack slot of a lower value unless that value is already in its slot
+void RegisterTranslator::materializeAll() {
+    for (int d = 0; d < depth(); d++) {
+        materialize(d);
+    }
+}
+
+bool RegisterTranslator::isReferred(int16_t reg) const {
+    for (int16_t operand : stack) {
+        if (operand == reg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Values still referring to a local variable must be moved out of it before
+// the local variable is overwritten
+void RegisterTranslator::materializeReferences(int16_t reg) {
+    for (int d = 0; d < depth(); d++) {
+        if (stack[d] == reg) {
+            materialize(d);
+        }
+    }
+}
+
+// Store stack top into local. If it was just computed by the previous register
+// instruction, that instruction writes local directly instead
+void RegisterTranslator::storeLocal(int16_t local, bool producedTop) {
+    const int16_t value = pop();
+    if (producedTop && value == slotOf(depth()) && !isReferred(local)) {
+        result.instructions.back().dst = local;
+        return;
+    }
+    materializeReferences(local);
+    emit(reg_move, local, value);
+}
+
+RegisterInstruction& RegisterTranslator::emit(u1 opcode, int16_t dst,
+                                              int16_t a, int16_t b) {
+    RegisterInstruction instruction{};
+    instruction.opcode = opcode;
+    instruction.dst = dst;
+    instruction.a = a;
+    instruction.b = b;
+    result.instructions.push_back(instruction);
+    return result.instructions.back();
+}
+
+// Operands must have been popped, the rest of stack is materialized since it
+// is what the branch target starts with
+bool RegisterTranslator::emitBranch(u1 opcode, u4 pc, int16_t a, int16_t b) {
+    const u4 target = pc + static_cast<int16_t>((code[pc + 1] << 8) |
+                                                code[pc + 2]);
+    materializeAll();
+    if (targetDepth[target] == -1) {
+        targetDepth[target] = depth();
+    } else if (targetDepth[target] != depth()) {
+        return false;
+    }
+    emit(opcode, 0, a, b);
+    fixups.emplace_back(result.instructions.size() - 1, target);
+    if (target <= pc) {
+        loopHeaders.push_back(target);
+    }
+    return true;
+}
+
+// Read symbolic reference of a call from constant pool, nothing is resolved.
+// invokeinterface must refer to an interface method
+bool RegisterTranslator::readMethodRef(u2 index, bool isInterface,
+                                       std::string& className,
+                                       std::string& name,
+                                       std::string& descriptor) const {
+    const ConstantPoolInfo* item = jc->getConstPoolItem(index);
+    u2 classIndex = 0;
+    u2 nameAndTypeIndex = 0;
+    if (const auto* mr = dynamic_cast<const CONSTANT_Methodref*>(item)) {
+        if (isInterface) {
+            return false;
+        }
+        classIndex = mr->classIndex;
+        nameAndTypeIndex = mr->nameAndTypeIndex;
+    } else if (const auto* imr =
+                   dynamic_cast<const CONSTANT_InterfaceMethodref*>(item)) {
+        classIndex = imr->classIndex;
+        nameAndTypeIndex = imr->nameAndTypeIndex;
+    } else {
+        return false;
+    }
+    const auto* nat = dynamic_cast<const CONSTANT_NameAndType*>(
+        jc->getConstPoolItem(nameAndTypeIndex));
+    const auto* classItem =
+        dynamic_cast<const CONSTANT_Class*>(jc->getConstPoolItem(classIndex));
+    if (nat == nullptr || classItem == nullptr) {
+        return false;
+    }
+    className = jc->getString(classItem->nameIndex);
+    name = jc->getString(nat->nameIndex);
+    descriptor = jc->getString(nat->descriptorIndex);
+    return true;
+}
+
+// Calls that were not executed yet resolve their method first. Interface
+// methods are selected like virtual ones, and resolving them checks nothing
+static u1 invokeOpcodeOf(u1 opcode) {
+    switch (opcode) {
+        case op_invokestatic:
+            return reg_resolve_invokestatic;
+        case op_invokespecial:
+            return reg_resolve_invokespecial;
+        case op_invokevirtual:
+            return reg_resolve_invokevirtual;
+        case op_invokestatic_quick:
+            return reg_invokestatic;
+        case op_invokespecial_quick:
+            return reg_invokespecial;
+        default:
+            return reg_invokevirtual;
+    }
+}
+
+static bool isBranch(u1 opcode) {
+    return (opcode >= op_ifeq && opcode <= op_goto) || opcode == op_ifnull ||
+           opcode == op_ifnonnull;
+}
+
+bool RegisterTranslator::findBranchTargets() {
+    for (u4 pc = 0; pc < codeLength;
+         pc += instructionLength(originalCode, pc)) {
+        if (isBranch(originalCode[pc])) {
+            const u4 target = pc + static_cast<int16_t>(
+                                       (code[pc + 1] << 8) | code[pc + 2]);
+            if (target >= codeLength) {
+                return false;
+            }
+            branchTarget[target] = true;
+        }
+    }
+    return true;
+}
+
+bool RegisterTranslator::translate() {
+    if (data->getExceptionTableLength() != 0 ||
+        base + maxStack > std::numeric_limits<int16_t>::max() ||
+        !findBranchTargets()) {
+        return false;
+    }
+    for (u4 pc = 0; pc < codeLength;
+         pc += instructionLength(originalCode, pc)) {
+        if (branchTarget[pc]) {
+            if (reachable) {
+                materializeAll();
+                if (targetDepth[pc] != -1 && targetDepth[pc] != depth()) {
+                    return false;
+                }
+                targetDepth[pc] = depth();
+            } else {
+                // Only reached by branches, which are all backward if depth
+                // is still unknown. They are checked against it later
+                if (targetDepth[pc] == -1) {
+                    targetDepth[pc] = 0;
+                }
+                stack.clear();
+                for (int d = 0; d < targetDepth[pc]; d++) {
+                    stack.push_back(slotOf(d));
+                }
+            }
+            reachable = true;
+            lastProducedTop = false;
+        }
+        label[pc] = static_cast<int>(result.instructions.size());
+        if (!reachable) {
+            continue;
+        }
+        // Superinstructions only rewrote opcode of their first instruction,
+        // and quickened instructions are only recognized in private code
+        const u1 opcode = code[pc] > op_invokeinterface_quick
+                              ? originalCode[pc]
+                              : code[pc];
+        if (!translateInstruction(pc, opcode)) {
+            return false;
+        }
+    }
+    if (reachable) {
+        // Falling off the end of code
+        return false;
+    }
+    for (const auto& fixup : fixups) {
+        result.instructions[fixup.first].target = label[fixup.second];
+    }
+    std::sort(loopHeaders.begin(), loopHeaders.end());
+    loopHeaders.erase(std::unique(loopHeaders.begin(), loopHeaders.end()),
+                      loopHeaders.end());
+    for (u4 pc : loopHeaders) {
+        result.osrEntries.emplace_back(pc, label[pc]);
+    }
+    return true;
+}
+
+bool RegisterTranslator::translateInstruction(u4 pc, u1 opcode) {
+    const bool producedTop = lastProducedTop;
+    lastProducedTop = false;
+
+    switch (opcode) {
+        case op_nop:
+            break;
+        case op_aconst_null:
+            stack.push_back(constant(JValue::of<JRef>(nullptr)));
+            break;
+        case op_iconst_m1:
+        case op_iconst_0:
+        case op_iconst_1:
+        case op_iconst_2:
+        case op_iconst_3:
+        case op_iconst_4:
+        case op_iconst_5:
+            stack.push_back(constant(JValue::of<JInt>(opcode - op_iconst_0)));
+            break;
+        case op_bipush:
+            stack.push_back(constant(
+                JValue::of<JInt>(static_cast<int8_t>(code[pc + 1]))));
+            break;
+        case op_sipush:
+            stack.push_back(constant(JValue::of<JInt>(
+                static_cast<int16_t>((code[pc + 1] << 8) | code[pc + 2]))));
+            break;
+        case op_ldc:
+        case op_ldc_w: {
+            const u2 index = opcode == op_ldc
+                                 ? code[pc + 1]
+                                 : ((code[pc + 1] << 8) | code[pc + 2]);
+            const int16_t dst = slotOf(depth());
+            if (!pushSlot()) {
+                return false;
+            }
+            emit(reg_ldc, dst).index = index;
+            lastProducedTop = true;
+        } break;
+        case op_iload:
+        case op_aload:
+            stack.push_back(code[pc + 1]);
+            break;
+        case op_iload_0:
+        case op_iload_1:
+        case op_iload_2:
+        case op_iload_3:
+            stack.push_back(opcode - op_iload_0);
+            break;
+        case op_aload_0:
+        case op_aload_1:
+        case op_aload_2:
+        case op_aload_3:
+            stack.push_back(opcode - op_aload_0);
+            break;
+        case op_istore:
+        case op_astore:
+            storeLocal(code[pc + 1], producedTop);
+            break;
+        case op_istore_0:
+        case op_istore_1:
+        case op_istore_2:
+        case op_istore_3:
+            storeLocal(opcode - op_istore_0, producedTop);
+            break;
+        case op_astore_0:
+        case op_astore_1:
+        case op_astore_2:
+        case op_astore_3:
+            storeLocal(opcode - op_astore_0, producedTop);
+            break;
+        case op_iinc: {
+            const int16_t local = code[pc + 1];
+            materializeReferences(local);
+            emit(reg_iadd, local, local,
+                 constant(JValue::of<JInt>(static_cast<int8_t>(code[pc + 2]))));
+        } break;
+        case op_pop:
+            pop();
+            break;
+        case op_dup:
+            if (depth() >= maxStack) {
+                return false;
+            }
+            stack.push_back(stack.back());
+            break;
+        case op_iadd:
+        case op_isub:
+        case op_imul:
+        case op_idiv:
+        case op_irem:
+        case op_iand:
+        case op_ior:
+        case op_ixor: {
+            static const u1 arithmetic[] = {
+                reg_iadd, reg_isub, reg_imul, reg_idiv, reg_irem};
+            static const u1 bitwise[] = {reg_iand, reg_ior, reg_ixor};
+            const u1 regOpcode = opcode <= op_irem
+                                     ? arithmetic[(opcode - op_iadd) / 4]
+                                     : bitwise[(opcode - op_iand) / 2];
+            const int16_t b = pop();
+            const int16_t a = pop();
+            emit(regOpcode, slotOf(depth()), a, b);
+            pushSlot();
+            lastProducedTop = true;
+        } break;
+        case op_ineg: {
+            const int16_t a = pop();
+            emit(reg_ineg, slotOf(depth()), a);
+            pushSlot();
+            lastProducedTop = true;
+        } break;
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+        case op_ifnull:
+        case op_ifnonnull: {
+            const u1 regOpcode =
+                opcode == op_ifnull
+                    ? reg_ifnull
+                    : (opcode == op_ifnonnull ? reg_ifnonnull
+                                              : reg_ifeq + (opcode - op_ifeq));
+            const int16_t a = pop();
+            if (!emitBranch(regOpcode, pc, a)) {
+                return false;
+            }
+        } break;
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+        case op_if_acmpeq:
+        case op_if_acmpne: {
+            const int16_t b = pop();
+            const int16_t a = pop();
+            if (!emitBranch(reg_if_icmpeq + (opcode - op_if_icmpeq), pc, a,
+                            b)) {
+                return false;
+            }
+        } break;
+        case op_goto:
+            if (!emitBranch(reg_goto, pc)) {
+                return false;
+            }
+            reachable = false;
+            break;
+        case op_iaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+        case op_aaload: {
+            const int16_t index = pop();
+            const int16_t array = pop();
+            emit(opcode == op_aaload ? reg_aaload : reg_iaload,
+                 slotOf(depth()), array, index);
+            pushSlot();
+            lastProducedTop = true;
+        } break;
+        case op_iastore:
+        case op_aastore: {
+            const int16_t value = pop();
+            const int16_t index = pop();
+            const int16_t array = pop();
+            emit(opcode == op_iastore ? reg_iastore : reg_aastore, value,
+                 array, index);
+        } break;
+        case op_arraylength: {
+            const int16_t array = pop();
+            emit(reg_arraylength, slotOf(depth()), array);
+            pushSlot();
+            lastProducedTop = true;
+        } break;
+        case op_getfield:
+        case op_getfield_quick: {
+            const int16_t object = pop();
+            emit(reg_getfield, slotOf(depth()), object).index =
+                (code[pc + 1] << 8) | code[pc + 2];
+            pushSlot();
+            lastProducedTop = true;
+        } break;
+        case op_putfield:
+        case op_putfield_quick: {
+            const int16_t value = pop();
+            const int16_t object = pop();
+            emit(reg_putfield, 0, object, value).index =
+                (code[pc + 1] << 8) | code[pc + 2];
+        } break;
+        case op_getstatic:
+        case op_getstatic_quick: {
+            const int16_t dst = slotOf(depth());
+            u2 stackDepth = 0;
+            if (opcode == op_getstatic) {
+                materializeAll();
+                stackDepth = static_cast<u2>(depth());
+            }
+            if (!pushSlot()) {
+                return false;
+            }
+            RegisterInstruction& instruction =
+                emit(opcode == op_getstatic ? reg_resolve_getstatic
+                                            : reg_getstatic,
+                     dst);
+            instruction.index = (code[pc + 1] << 8) | code[pc + 2];
+            instruction.depth = stackDepth;
+            lastProducedTop = true;
+        } break;
+        case op_putstatic:
+        case op_putstatic_quick: {
+            // Stored value stays on stack while class initialization runs
+            u2 stackDepth = 0;
+            if (opcode == op_putstatic) {
+                materializeAll();
+                stackDepth = static_cast<u2>(depth());
+            }
+            RegisterInstruction& instruction =
+                emit(opcode == op_putstatic ? reg_resolve_putstatic
+                                            : reg_putstatic,
+                     0, pop());
+            instruction.index = (code[pc + 1] << 8) | code[pc + 2];
+            instruction.depth = stackDepth;
+        } break;
+        case op_new: {
+            materializeAll();
+            const int16_t dst = slotOf(depth());
+            RegisterInstruction& instruction = emit(reg_new, dst);
+            instruction.index = (code[pc + 1] << 8) | code[pc + 2];
+            instruction.depth = static_cast<u2>(depth());
+            if (!pushSlot()) {
+                return false;
+            }
+        } break;
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+        case op_invokevirtual_quick:
+        case op_invokespecial_quick:
+        case op_invokestatic_quick:
+        case op_invokeinterface_quick: {
+            const u2 index = (code[pc + 1] << 8) | code[pc + 2];
+            std::string className;
+            std::string name;
+            std::string descriptor;
+            if (!readMethodRef(index, opcode == op_invokeinterface, className,
+                               name, descriptor) ||
+                IS_SIGNATURE_POLYMORPHIC_METHOD(className, name)) {
+                return false;
+            }
+            const auto parameterAndReturnType =
+                peelMethodParameterAndType(descriptor);
+            const bool isStatic = opcode == op_invokestatic ||
+                                  opcode == op_invokestatic_quick;
+            const int argumentCount =
+                static_cast<int>(std::get<1>(parameterAndReturnType).size()) +
+                (isStatic ? 0 : 1);
+            if (argumentCount > depth()) {
+                return false;
+            }
+            materializeAll();
+            RegisterInstruction& instruction = emit(invokeOpcodeOf(opcode));
+            instruction.index = index;
+            instruction.depth = static_cast<u2>(depth());
+            if (instruction.opcode == reg_invokevirtual ||
+                instruction.opcode == reg_resolve_invokevirtual) {
+                instruction.target =
+                    static_cast<int32_t>(result.inlineCaches.size());
+                result.inlineCaches.push_back(data->getInlineCache(pc));
+            }
+            stack.resize(depth() - argumentCount);
+            if (std::get<0>(parameterAndReturnType) != T_EXTRA_VOID &&
+                !pushSlot()) {
+                return false;
+            }
+        } break;
+        case op_ireturn:
+        case op_areturn:
+            emit(reg_return, 0, pop());
+            reachable = false;
+            break;
+        case op_return:
+            emit(reg_return_void);
+            reachable = false;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+int32_t RegisterCode::getOsrEntry(u4 pc) const {
+    auto iter = std::lower_bound(
+        osrEntries.begin(), osrEntries.end(), pc,
+        [](const std::pair<u4, int32_t>& entry, u4 pc) {
+            return entry.first < pc;
+        });
+    return iter != osrEntries.end() && iter->first == pc ? iter->second : -1;
+}
+
+RegisterCode* RegisterCode::translate(const JavaClass* jc,
+                                     const MethodData* data) {
+    std::unique_ptr<RegisterCode> registerCode(new RegisterCode);
+    if (!RegisterTranslator(jc, data, *registerCode).translate()) {
+        return nullptr;
+    }
+    return registerCode.release();
+}
+
+RegisterCode* RegisterCode::load(const AotMethod& method,
+                                 const MethodData* data) {
+    std::unique_ptr<RegisterCode> registerCode(new RegisterCode);
+    registerCode->instructions.assign(
+        method.instructions, method.instructions + method.instructionCount);
+    for (size_t i = 0; i < method.constantCount; i++) {
+        const AotConstant& constant = method.constants[i];
+        registerCode->constants.push_back(
+            constant.tag == ValueTag::Ref ? JValue::of<JRef>(nullptr)
+                                          : JValue::of<JInt>(constant.value));
+    }
+    for (size_t i = 0; i < method.inlineCacheCount; i++) {
+        InlineCache* cache = data->getInlineCache(method.inlineCachePcs[i]);
+        if (cache == nullptr) {
+            return nullptr;
+        }
+        registerCode->inlineCaches.push_back(cache);
+    }
+    return registerCode.release();
+}
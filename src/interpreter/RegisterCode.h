@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_REGISTERCODE_H
+#define YVM_REGISTERCODE_H
+
+#include <utility>
+#include <vector>
+#include "../runtime/JavaType.h"
+#include "Internal.h"
+
+class JavaClass;
+class MethodData;
+struct AotMethod;
+struct InlineCache;
+
+// register instruction opcodes
+#define reg_move 0
+#define reg_iadd 1
+#define reg_isub 2
+#define reg_imul 3
+#define reg_idiv 4
+#define reg_irem 5
+#define reg_iand 6
+#define reg_ior 7
+#define reg_ixor 8
+#define reg_ineg 9
+#define reg_ifeq 10
+#define reg_ifne 11
+#define reg_iflt 12
+#define reg_ifge 13
+#define reg_ifgt 14
+#define reg_ifle 15
+#define reg_if_icmpeq 16
+#define reg_if_icmpne 17
+#define reg_if_icmplt 18
+#define reg_if_icmpge 19
+#define reg_if_icmpgt 20
+#define reg_if_icmple 21
+#define reg_if_acmpeq 22
+#define reg_if_acmpne 23
+#define reg_ifnull 24
+#define reg_ifnonnull 25
+#define reg_goto 26
+#define reg_ldc 27
+#define reg_iaload 28
+#define reg_aaload 29
+#define reg_iastore 30
+#define reg_aastore 31
+#define reg_arraylength 32
+#define reg_getfield 33
+#define reg_putfield 34
+#define reg_getstatic 35
+#define reg_putstatic 36
+#define reg_new 37
+#define reg_invokestatic 38
+#define reg_invokespecial 39
+#define reg_invokevirtual 40
+#define reg_return 41
+#define reg_return_void 42
+// Resolve the operand and initialize its class first, then quicken into
+// the instructions above
+#define reg_resolve_getstatic 43
+#define reg_resolve_putstatic 44
+#define reg_resolve_invokestatic 45
+#define reg_resolve_invokespecial 46
+#define reg_resolve_invokevirtual 47
+
+//--------------------------------------------------------------------------------
+// One instruction of register code. Registers are the local variables of a
+// frame followed by its operand stack slots, so that register maxLocals + k
+// is the operand stack value at depth k. An operand that is negative refers to
+// constant -operand - 1 of the method instead
+//
+// Instructions that may run Java code(calls, new, resolving instructions)
+// expect operand stack values below depth to be in their stack slots, the
+// frame's stack top is set to depth before they run so that GC sees them.
+// Calls take their arguments from the top of that stack and leave the result
+// at register maxLocals + depth - argumentCount
+//--------------------------------------------------------------------------------
+struct RegisterInstruction {
+    u1 opcode;
+    // Constant pool index of ldc, fields, new and calls
+    u2 index;
+    u2 depth;
+    // Result register. iastore and aastore read the stored value from it
+    int16_t dst;
+    int16_t a;
+    int16_t b;
+    // Index of branch target, or inline cache of invokevirtual
+    int32_t target;
+};
+
+//--------------------------------------------------------------------------------
+// RegisterCode is a register based translation of a method's bytecode. Values
+// an instruction pushes are assigned to the stack slot register of their
+// depth, pushes of local variables and constants are not materialized but
+// used as operands of the instruction consuming them. Only straight code on
+// int and reference values, field accesses and calls is translated, methods
+// using anything else keep running as bytecode. Translation needs nothing
+// but the class file, symbolic references are resolved by the resolving
+// instructions when they first run
+//
+// Headers of loops are OSR entries. The operand stack is materialized there,
+// so a frame running the bytecode of a loop can continue at the register
+// instruction of its header without moving any value
+//--------------------------------------------------------------------------------
+class RegisterCode {
+public:
+    // Return nullptr if method can not be translated
+    static RegisterCode* translate(const JavaClass* jc, const MethodData* data);
+    // Register code a method was translated into ahead of time by yvmc
+    static RegisterCode* load(const AotMethod& method, const MethodData* data);
+
+    const RegisterInstruction* getInstructions() const {
+        return instructions.data();
+    }
+    const JValue* getConstants() const { return constants.data(); }
+    size_t getConstantCount() const { return constants.size(); }
+    InlineCache* getInlineCache(int32_t i) const { return inlineCaches[i]; }
+    size_t getInlineCacheCount() const { return inlineCaches.size(); }
+    size_t size() const { return instructions.size(); }
+
+    // Index of the register instruction of loop header at bytecode pc, or -1
+    // if pc is not a loop header
+    int32_t getOsrEntry(u4 pc) const;
+
+    // Rewrite a resolving instruction into quickOpcode after it resolved its
+    // operand. Threads still running the resolving version are not affected
+    void quicken(const RegisterInstruction* instruction,
+                 u1 quickOpcode) const {
+        const_cast<volatile u1&>(instruction->opcode) = quickOpcode;
+    }
+
+private:
+    friend class RegisterTranslator;
+
+    std::vector<RegisterInstruction> instructions;
+    std::vector<JValue> constants;
+    std::vector<InlineCache*> inlineCaches;
+    std::vector<std::pair<u4, int32_t>> osrEntries;
+};
+
+#endif  // YVM_REGISTERCODE_H
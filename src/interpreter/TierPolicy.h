@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_TIERPOLICY_H
+#define YVM_TIERPOLICY_H
+
+#include <cstdint>
+#include "../misc/Option.h"
+#include "../misc/Utils.h"
+#include "../runtime/MethodData.h"
+#include "CallSite.h"
+
+class JitCode;
+class RegisterCode;
+
+// Execution modes of a method, from the slowest to the fastest
+enum class Tier { Bytecode, RegisterCode, MachineCode };
+
+//--------------------------------------------------------------------------------
+// TierPolicy decides when a method moves to a faster execution mode. It looks
+// at the hotness of a method, which is its invocations plus the backward
+// branches it took in any tier. A method is translated into register code once
+// its hotness reaches registerCodeThreshold, and compiled into machine code
+// once its hotness grew by jitThreshold after that. Methods yvmc compiled
+// start at the fastest tier
+//
+// An activation stuck in a loop is moved while it runs: once a method took
+// osrThreshold backward branches as bytecode, its loops continue as register
+// code, and loops of register code continue as machine code once it's due
+//--------------------------------------------------------------------------------
+class TierPolicy {
+public:
+    // Register code to run method with, or nullptr if it keeps running as
+    // bytecode
+    forceinline const RegisterCode* registerCodeOf(
+        const CallSite& csite) const {
+        const RegisterCode* registerCode = csite.data->getRegisterCode();
+        if (registerCode != nullptr || registerCodeThreshold == 0 ||
+            csite.data->getHotness() < registerCodeThreshold) {
+            return registerCode;
+        }
+        return csite.data->translateRegisterCode(csite.jc);
+    }
+
+    // Machine code to run method with, the method must be running as
+    // register code. Return nullptr if it keeps running as register code
+    forceinline const JitCode* jitCodeOf(const CallSite& csite) const {
+        const JitCode* jitCode = csite.data->getJitCode();
+        if (jitCode != nullptr || interpretOnly ||
+            csite.data->getHotness() - csite.data->getRegisterCodeHotness() <
+                jitThreshold) {
+            return jitCode;
+        }
+        return csite.data->compileRegisterCode();
+    }
+
+    // Register code to continue a loop of a method running as bytecode with,
+    // or nullptr if it keeps running as bytecode
+    forceinline const RegisterCode* osrCodeOf(const JavaClass* jc,
+                                              MethodData* data) const {
+        if (osrThreshold == 0 || registerCodeThreshold == 0 ||
+            data->getBackedgeCount() < osrThreshold) {
+            return nullptr;
+        }
+        const RegisterCode* registerCode = data->getRegisterCode();
+        return registerCode != nullptr ? registerCode
+                                       : data->translateRegisterCode(jc);
+    }
+
+    static Tier tierOf(const MethodData* data);
+    static const char* nameOf(Tier tier);
+
+public:
+    // 0 keeps every method running as bytecode
+    uint64_t registerCodeThreshold = YVM_REGISTER_CODE_THRESHOLD;
+    uint64_t jitThreshold = YVM_JIT_THRESHOLD;
+    // 0 never replaces a running activation
+    uint64_t osrThreshold = YVM_OSR_THRESHOLD;
+    // Never compile methods into machine code
+    bool interpretOnly = false;
+};
+
+#endif  // YVM_TIERPOLICY_H
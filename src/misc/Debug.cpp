@@ -21,9 +21,15 @@
 // SOFTWARE.
 //
 
+#include <algorithm>
+#include <map>
+#include <vector>
 #include "../classfile/AccessFlag.h"
+#include "../interpreter/TierPolicy.h"
 #include "Debug.h"
+#include "../runtime/ClassSpace.h"
 #include "../runtime/JavaType.h"
+#include "../runtime/MethodData.h"
 
 void Inspector::printConstantPool(const JavaClass& jc) {
     using namespace std;
@@ -303,6 +309,114 @@ void Inspector::printSizeofInternalTypes() {
     d.show();
 }
 
+void Inspector::printDispatchStats(const char* mode, uint64_t dispatched,
+                                   double seconds) {
+    std::cerr << "[" << mode << " dispatch] " << dispatched
+              << " bytecodes in " << seconds << "s, "
+              << static_cast<uint64_t>(seconds > 0 ? dispatched / seconds : 0)
+              << " bytecodes/s\n";
+}
+
+void Inspector::printMethodLookupStats(uint64_t lookups, uint64_t compares) {
+    std::cerr << "[method lookup] " << lookups << " lookups, " << compares
+              << " methods compared\n";
+}
+
+// Print counters of inline caches that have been reached, classes are sorted
+// by name so that outputs of different runs are comparable
+void Inspector::printInlineCaches(const ClassSpace& cs) {
+    std::map<std::string, const JavaClass*> classes;
+    for (const auto& jc : cs.classTable) {
+        classes.insert(std::make_pair(jc.first, jc.second));
+    }
+    for (const auto& entry : classes) {
+        const JavaClass* jc = entry.second;
+        FOR_EACH(i, jc->raw.methodsCount) {
+            const MethodInfo& m = jc->raw.methods[i];
+            if (m.data == nullptr) {
+                continue;
+            }
+            FOR_EACH(k, m.data->getInlineCacheCount()) {
+                const InlineCache& ic = m.data->getInlineCacheAt(k);
+                if (ic.hits() + ic.misses + ic.megamorphicCalls == 0) {
+                    continue;
+                }
+                const char* state = ic.isMegamorphic()
+                                        ? "megamorphic"
+                                        : ic.receiverCount() > 1
+                                              ? "polymorphic"
+                                              : "monomorphic";
+                std::cerr << "[inline cache] " << entry.first << "."
+                          << jc->getString(m.nameIndex)
+                          << jc->getString(m.descriptorIndex) << "@" << ic.pc
+                          << " " << state << " receivers=" << ic.receiverCount()
+                          << " hits=" << ic.hits() << " misses=" << ic.misses
+                          << " megamorphic=" << ic.megamorphicCalls << "\n";
+            }
+        }
+    }
+}
+
+// Methods are ordered by hotness, each one is followed by the profile of its
+// branches and receiver types of its call sites
+void Inspector::printHotMethods(const ClassSpace& cs, size_t count) {
+    std::vector<std::pair<const JavaClass*, const MethodInfo*>> methods;
+    for (const auto& entry : cs.classTable) {
+        const JavaClass* jc = entry.second;
+        FOR_EACH(i, jc->raw.methodsCount) {
+            const MethodInfo& m = jc->raw.methods[i];
+            if (m.data != nullptr && m.data->getHotness() != 0) {
+                methods.emplace_back(jc, &m);
+            }
+        }
+    }
+    std::sort(methods.begin(), methods.end(),
+              [](const std::pair<const JavaClass*, const MethodInfo*>& a,
+                 const std::pair<const JavaClass*, const MethodInfo*>& b) {
+                  return a.second->data->getHotness() >
+                         b.second->data->getHotness();
+              });
+    if (methods.size() > count) {
+        methods.resize(count);
+    }
+
+    for (const auto& method : methods) {
+        const JavaClass* jc = method.first;
+        const MethodData* data = method.second->data;
+        std::cerr << "[hot method] " << jc->getClassName() << "."
+                  << jc->getString(method.second->nameIndex)
+                  << jc->getString(method.second->descriptorIndex)
+                  << " invocations=" << data->getInvocationCount()
+                  << " backedges=" << data->getBackedgeCount() << " tier="
+                  << (data->getCode() == nullptr
+                          ? "native"
+                          : TierPolicy::nameOf(TierPolicy::tierOf(data)))
+                  << "\n";
+        FOR_EACH(k, data->getBranchProfileCount()) {
+            const BranchProfile& branch = data->getBranchProfileAt(k);
+            if (branch.taken + branch.notTaken != 0) {
+                std::cerr << "    branch@" << branch.pc
+                          << " taken=" << branch.taken
+                          << " not-taken=" << branch.notTaken << "\n";
+            }
+        }
+        FOR_EACH(k, data->getInlineCacheCount()) {
+            const InlineCache& ic = data->getInlineCacheAt(k);
+            if (ic.hits() + ic.misses + ic.megamorphicCalls == 0) {
+                continue;
+            }
+            std::cerr << "    call@" << ic.pc << " receivers=";
+            for (int r = 0; r < ic.receiverCount(); r++) {
+                std::cerr << (r == 0 ? "" : ",")
+                          << ic.receivers[r]->getClassName() << ":"
+                          << ic.receiverHits[r];
+            }
+            std::cerr << " misses=" << ic.misses
+                      << " megamorphic=" << ic.megamorphicCalls << "\n";
+        }
+    }
+}
+
 void Inspector::printOpcode(u1* code, u4 index) {
     switch (code[index]) {
         case 0:
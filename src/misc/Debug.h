@@ -32,6 +32,7 @@
 #include "../runtime/JavaClass.h"
 
 class JavaClass;
+class ClassSpace;
 
 struct Inspector {
     static void printConstantPool(const JavaClass& jc);
@@ -44,6 +45,11 @@ struct Inspector {
 
     static void printSizeofInternalTypes();
     static void printOpcode(u1* code, u4 index);
+    static void printDispatchStats(const char* mode, uint64_t dispatched,
+                                   double seconds);
+    static void printMethodLookupStats(uint64_t lookups, uint64_t compares);
+    static void printInlineCaches(const ClassSpace& cs);
+    static void printHotMethods(const ClassSpace& cs, size_t count);
 };
 
 class DbgPleasant {
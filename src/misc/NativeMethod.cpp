@@ -23,6 +23,7 @@
 
 #include "NativeMethod.h"
 
+#include <atomic>
 #include <future>
 #include <iostream>
 #include <random>
@@ -30,179 +31,170 @@
 
 #include "../runtime/ClassSpace.h"
 #include "../runtime/JavaClass.h"
+#include "../runtime/JavaFrame.hpp"
 #include "../runtime/JavaHeap.hpp"
 #include "../vm/YVM.h"
 
-JType* ydk_lang_IO_print_str(RuntimeEnv* env, JType** args, int numArgs) {
-    JObject* str = (JObject*)args[0];
+JValue ydk_lang_IO_print_str(RuntimeEnv* env, JValue* args, int numArgs) {
+    JObject* str = args[0].as<JObject>();
     if (nullptr != str) {
-        auto fields = env->heap->getFields(str);
-        JArray* chararr = (JArray*)fields[0];
-        auto lengthAndData = env->heap->getElements(chararr);
-        char* s = new char[lengthAndData.first + 1];
-        for (int i = 0; i < lengthAndData.first; i++) {
-            s[i] = (char)((JInt*)lengthAndData.second[i])->val;
+        JArray* chararr = env->heap->getFieldBySlot(*str, 0).as<JArray>();
+        char* s = new char[chararr->length + 1];
+        for (int i = 0; i < chararr->length; i++) {
+            s[i] = (char)chararr->elements<uint16_t>()[i];
         }
-        s[lengthAndData.first] = '\0';
+        s[chararr->length] = '\0';
         std::cout << s;
         delete[] s;
     } else {
         std::cout << "null";
     }
 
-    return nullptr;
+    return JValue{};
 }
 
-JType* ydk_lang_IO_print_I(RuntimeEnv* env, JType** args, int numArgs) {
-    JInt* num = (JInt*)args[0];
-    std::cout << num->val;
-    return nullptr;
+JValue ydk_lang_IO_print_I(RuntimeEnv* env, JValue* args, int numArgs) {
+    std::cout << args[0].i;
+    return JValue{};
 }
 
-JType* ydk_lang_IO_print_C(RuntimeEnv* env, JType** args, int numArgs) {
-    JInt* num = (JInt*)args[0];
-    std::cout << (char)num->val;
-    return nullptr;
+JValue ydk_lang_IO_print_C(RuntimeEnv* env, JValue* args, int numArgs) {
+    std::cout << (char)args[0].i;
+    return JValue{};
 }
 
-JType* java_lang_Math_random(RuntimeEnv* env, JType** args, int numArgs) {
+JValue java_lang_Math_random(RuntimeEnv* env, JValue* args, int numArgs) {
     std::default_random_engine dre;
     std::uniform_int_distribution<int> realD;
-    return new JDouble(realD(dre));
+    return JValue::of<JDouble>(realD(dre));
 }
 
-JType* java_lang_stringbuilder_append_I(RuntimeEnv* env, JType** args,
+JValue java_lang_stringbuilder_append_I(RuntimeEnv* env, JValue* args,
                                         int numArgs) {
-    JObject* caller = (JObject*)args[0];
-    JInt* numParameter = (JInt*)args[1];
+    JObject* caller = args[0].as<JObject>();
+    int32_t numParameter = args[1].i;
     std::string str{};
 
     // append lhs string to str
-    JArray* arr =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*caller, 0));
+    JArray* arr = env->heap->getFieldBySlot(*caller, 0).as<JArray>();
     if (arr != nullptr) {
         for (int i = 0; i < arr->length; i++) {
-            str +=
-                (char)dynamic_cast<JInt*>(env->heap->getElement(*arr, i))->val;
+            str += (char)arr->elements<uint16_t>()[i];
         }
     }
 
     // convert Int to string and append on str
-    str += std::to_string(numParameter->val);
+    str += std::to_string(numParameter);
     JArray* newArr = env->heap->createCharArray(str, str.length());
-    env->heap->putFieldByOffset(*caller, 0, newArr);
+    env->heap->putFieldBySlot(*caller, 0, JValue::of<JArray>(newArr));
 
     // remove old lhs string since new str overlapped it
     if (arr != nullptr) {
         env->heap->removeArray(arr->offset);
     }
 
-    return caller;
+    return JValue::of<JObject>(caller);
 }
 
-JType* java_lang_stringbuilder_append_C(RuntimeEnv* env, JType** args,
+JValue java_lang_stringbuilder_append_C(RuntimeEnv* env, JValue* args,
                                         int numArgs) {
-    JObject* caller = (JObject*)args[0];
-    JInt* numParameter = (JInt*)args[1];
+    JObject* caller = args[0].as<JObject>();
+    int32_t numParameter = args[1].i;
     std::string str{};
 
-    JArray* arr =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*caller, 0));
+    JArray* arr = env->heap->getFieldBySlot(*caller, 0).as<JArray>();
     if (arr != nullptr) {
         for (int i = 0; i < arr->length; i++) {
-            str +=
-                (char)dynamic_cast<JInt*>(env->heap->getElement(*arr, i))->val;
+            str += (char)arr->elements<uint16_t>()[i];
         }
     }
-    char c = numParameter->val;
+    char c = numParameter;
     str += c;
     JArray* newArr = env->heap->createCharArray(str, str.length());
-    env->heap->putFieldByOffset(*caller, 0, newArr);
+    env->heap->putFieldBySlot(*caller, 0, JValue::of<JArray>(newArr));
     if (arr != nullptr) {
         env->heap->removeArray(arr->offset);
     }
-    return caller;
+    return JValue::of<JObject>(caller);
 }
 
-JType* java_lang_stringbuilder_append_str(RuntimeEnv* env, JType** args,
+JValue java_lang_stringbuilder_append_str(RuntimeEnv* env, JValue* args,
                                           int numArgs) {
-    JObject* caller = (JObject*)args[0];
-    JObject* strParameter = (JObject*)args[1];
+    JObject* caller = args[0].as<JObject>();
+    JObject* strParameter = args[1].as<JObject>();
     std::string str{};
 
-    JArray* arr =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*caller, 0));
+    JArray* arr = env->heap->getFieldBySlot(*caller, 0).as<JArray>();
     if (nullptr != arr) {
         for (int i = 0; i < arr->length; i++) {
-            str +=
-                (char)dynamic_cast<JInt*>(env->heap->getElement(*arr, i))->val;
+            str += (char)arr->elements<uint16_t>()[i];
         }
     }
-    JArray* chararr =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*strParameter, 0));
+    JArray* chararr = env->heap->getFieldBySlot(*strParameter, 0).as<JArray>();
     for (int i = 0; i < chararr->length; i++) {
-        str +=
-            (char)dynamic_cast<JInt*>(env->heap->getElement(*chararr, i))->val;
+        str += (char)chararr->elements<uint16_t>()[i];
     }
 
     JArray* newArr = env->heap->createCharArray(str, str.length());
-    env->heap->putFieldByOffset(*caller, 0, newArr);
+    env->heap->putFieldBySlot(*caller, 0, JValue::of<JArray>(newArr));
 
     if (arr != nullptr) {
         env->heap->removeArray(arr->offset);
     }
-    return caller;
+    return JValue::of<JObject>(caller);
 }
 
-JType* java_lang_stringbuilder_append_D(RuntimeEnv* env, JType** args,
+JValue java_lang_stringbuilder_append_D(RuntimeEnv* env, JValue* args,
                                         int numArgs) {
-    JObject* caller = (JObject*)args[0];
-    JDouble* numParameter = (JDouble*)args[1];
+    JObject* caller = args[0].as<JObject>();
+    double numParameter = args[1].d;
     std::string str{};
 
-    JArray* arr =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*caller, 0));
+    JArray* arr = env->heap->getFieldBySlot(*caller, 0).as<JArray>();
     if (arr != nullptr) {
         for (int i = 0; i < arr->length; i++) {
-            str +=
-                (char)dynamic_cast<JInt*>(env->heap->getElement(*arr, i))->val;
+            str += (char)arr->elements<uint16_t>()[i];
         }
     }
-    str += std::to_string(numParameter->val);
+    str += std::to_string(numParameter);
     JArray* newArr = env->heap->createCharArray(str, str.length());
-    env->heap->putFieldByOffset(*caller, 0, newArr);
+    env->heap->putFieldBySlot(*caller, 0, JValue::of<JArray>(newArr));
     if (arr != nullptr) {
         env->heap->removeArray(arr->offset);
     }
-    return caller;
+    return JValue::of<JObject>(caller);
 }
 
-JType* java_lang_stringbuilder_tostring(RuntimeEnv* env, JType** args,
+JValue java_lang_stringbuilder_tostring(RuntimeEnv* env, JValue* args,
                                         int numArgs) {
-    JObject* caller = (JObject*)args[0];
-    JArray* value =
-        dynamic_cast<JArray*>(env->heap->getFieldByOffset(*caller, 0));
+    JObject* caller = args[0].as<JObject>();
+    JArray* value = env->heap->getFieldBySlot(*caller, 0).as<JArray>();
     char* carr = new char[value->length];
     for (int i = 0; i < value->length; i++) {
-        carr[i] =
-            (char)dynamic_cast<JInt*>(env->heap->getElement(*value, i))->val;
+        carr[i] = (char)value->elements<uint16_t>()[i];
     }
     JObject* str =
         env->heap->createObject(*env->cs->findJavaClass("java/lang/String"));
-    env->heap->putFieldByOffset(
-        *str, 0, env->heap->createCharArray(carr, value->length));
+    env->heap->putFieldBySlot(
+        *str, 0,
+        JValue::of<JArray>(env->heap->createCharArray(
+            std::string(carr, value->length), value->length)));
     delete[] carr;
 
-    return str;
+    return JValue::of<JObject>(str);
 }
 
-JType* java_lang_thread_start(RuntimeEnv* env, JType** args, int numArgs) {
-    auto* caller = (JObject*)args[0];
-    auto* runnableTask = (JObject*)cloneValue(dynamic_cast<JObject*>(
-        env->heap->getFieldByName(
-            runtime.cs->findJavaClass("java/lang/Thread"),
-                                   "task", "Ljava/lang/Runnable;", caller)));
+// Threads are named Thread-0, Thread-1... in the order they're started
+static std::atomic<int> threadNumber{0};
 
+JValue java_lang_thread_start(RuntimeEnv* env, JValue* args, int numArgs) {
+    auto* caller = args[0].as<JObject>();
+    JavaClass* threadClass = runtime.cs->findJavaClass("java/lang/Thread");
+    JValue task = env->heap->getFieldByName(threadClass, "task",
+                                            "Ljava/lang/Runnable;", caller);
+    auto* runnableTask = task.as<JObject>();
+
+    const int number = threadNumber++;
     YVM::executor.createThread();
     future<void> subThreadF = YVM::executor.submit([=]() {
 #ifdef YVM_DEBUG_SHOW_THREAD_NAME
@@ -215,16 +207,23 @@ JType* java_lang_thread_start(RuntimeEnv* env, JType** args, int numArgs) {
         // For each execution thread, we have a code execution engine
         auto* frame = new JavaFrame;
         frame->pushFrame(1, 1);
-        frame->top()->push(runnableTask);
+        frame->top()->push<JObject>(runnableTask);
         Interpreter exec{frame};
 
         runtime.cs->initClassIfAbsent(exec, name);
         // Push object reference and since Runnable.run() has no parameter, so
         // we dont need to push arguments since Runnable.run() has no parameter
 
-        exec.invokeInterface(jc, "run", "()V");
+        // Report an overflow against this thread and let it end, the main
+        // thread and other threads keep running
+        try {
+            exec.invokeInterface(jc, "run", "()V");
+        } catch (const StackOverflowError& e) {
+            std::cerr << "Exception in thread \"Thread-" << number << "\" "
+                      << e.what() << std::endl;
+        }
     });
     YVM::executor.storeTaskFuture(subThreadF.share());
 
-    return nullptr;
+    return JValue{};
 }
@@ -30,6 +30,70 @@
 //--------------------------------------------------------------------------------
 #define YVM_GC_THRESHOLD_VALUE (1024 * 1024 * 10)
 
+//--------------------------------------------------------------------------------
+// default maximum number of frames of a java thread, it can be changed by
+// --max-stack-depth=<n> up to YVM_FRAME_ARENA_SIZE. Exceeding it raises
+// StackOverflowError
+//--------------------------------------------------------------------------------
+#define YVM_MAX_FRAME_DEPTH 2048
+
+//--------------------------------------------------------------------------------
+// number of value slots reserved for the frame stack arena of each java thread
+//--------------------------------------------------------------------------------
+#define YVM_FRAME_ARENA_SIZE (256 * 1024)
+
+//--------------------------------------------------------------------------------
+// bytes of native stack a java thread may take, calls of native methods and
+// calls between stack caching and the other tiers nest C++ calls. Going beyond
+// it raises StackOverflowError, so it must stay below the stack size of
+// threads, which is 8MB by default on Linux
+//--------------------------------------------------------------------------------
+#define YVM_NATIVE_STACK_SIZE (4 * 1024 * 1024)
+
+//--------------------------------------------------------------------------------
+// default number of invocations and backward branches after which a method is
+// translated into register code, it can be changed by
+// --register-code-threshold=<n>
+//--------------------------------------------------------------------------------
+#define YVM_REGISTER_CODE_THRESHOLD 1000
+
+//--------------------------------------------------------------------------------
+// default number of further invocations and backward branches after which
+// register code is compiled into machine code, it can be changed by
+// --jit-threshold=<n>. Compiled code is placed in a code cache of
+// YVM_JIT_CODE_CACHE_SIZE bytes, methods are not compiled once it is full
+//--------------------------------------------------------------------------------
+#define YVM_JIT_THRESHOLD 10000
+#define YVM_JIT_CODE_CACHE_SIZE (16 * 1024 * 1024)
+
+//--------------------------------------------------------------------------------
+// default number of backward branches a method takes as bytecode before its
+// running loops are replaced on stack by register code, it can be changed by
+// --osr-threshold=<n>
+//--------------------------------------------------------------------------------
+#define YVM_OSR_THRESHOLD 1000
+
+//--------------------------------------------------------------------------------
+// callees whose bytecode is at most YVM_MAX_INLINE_SIZE bytes are inlined into
+// their callers when classes are linked, until a caller has grown by
+// YVM_MAX_INLINE_GROWTH bytes. It can be disabled by --no-inlining
+//--------------------------------------------------------------------------------
+#define YVM_MAX_INLINE_SIZE 35
+#define YVM_MAX_INLINE_GROWTH 512
+
+//--------------------------------------------------------------------------------
+// default number of methods dumped by --print-hot-methods
+//--------------------------------------------------------------------------------
+#define YVM_HOT_METHODS 20
+
+//--------------------------------------------------------------------------------
+// YVM_SWITCH_DISPATCH and YVM_DISPATCH_STATS are set by cmake options of the
+// same name. The former interprets bytecode through the portable switch
+// instead of threaded code, the latter reports bytecodes per second on exit.
+// YVM_LOOKUP_STATS reports how many method lookups were done and how many
+// methods they compared
+//--------------------------------------------------------------------------------
+
 //--------------------------------------------------------------------------------
 // show new spawning thread name
 //--------------------------------------------------------------------------------
@@ -30,70 +30,190 @@ std::string javastring2stdtring(JObject* objectref) {
         return std::string();
     }
 
-    JArray* chararr = dynamic_cast<JArray*>(
-        runtime.heap->getFieldByName(objectref->jc, "value", "[C", objectref));
+    JArray* chararr =
+        runtime.heap->getFieldByName(objectref->jc, "value", "[C", objectref)
+            .as<JArray>();
 
     std::string str;
     for (int i = 0; i < chararr->length; i++) {
-        JInt* ch = dynamic_cast<JInt*>(runtime.heap->getElement(*chararr, i));
-        str += (char)ch->val;
+        str += (char)chararr->elements<uint16_t>()[i];
     }
     return str;
 }
 
-JType* cloneValue(JType* value) {
-    if (value == nullptr) {
-        return nullptr;
-    }
-    JType* dupvalue{};
-    if (typeid(*value) == typeid(JDouble)) {
-        dupvalue = new JDouble();
-        dynamic_cast<JDouble*>(dupvalue)->val =
-            dynamic_cast<JDouble*>(value)->val;
-    } else if (typeid(*value) == typeid(JFloat)) {
-        dupvalue = new JFloat();
-        dynamic_cast<JFloat*>(dupvalue)->val =
-            dynamic_cast<JFloat*>(value)->val;
-    } else if (typeid(*value) == typeid(JInt)) {
-        dupvalue = new JInt();
-        dynamic_cast<JInt*>(dupvalue)->val = dynamic_cast<JInt*>(value)->val;
-    } else if (typeid(*value) == typeid(JLong)) {
-        dupvalue = new JDouble();
-        dynamic_cast<JDouble*>(dupvalue)->val =
-            dynamic_cast<JDouble*>(value)->val;
-    } else if (typeid(*value) == typeid(JObject)) {
-        dupvalue = new JObject();
-        dynamic_cast<JObject*>(dupvalue)->jc =
-            dynamic_cast<JObject*>(value)->jc;
-        dynamic_cast<JObject*>(dupvalue)->offset =
-            dynamic_cast<JObject*>(value)->offset;
-    } else if (typeid(*value) == typeid(JArray)) {
-        dupvalue = new JArray();
-        dynamic_cast<JArray*>(dupvalue)->length =
-            dynamic_cast<JArray*>(value)->length;
-        dynamic_cast<JArray*>(dupvalue)->offset =
-            dynamic_cast<JArray*>(value)->offset;
-    } else {
-        SHOULD_NOT_REACH_HERE
-    }
-    return dupvalue;
+bool isSameReference(const JType* ref1, const JType* ref2) {
+    if (ref1 == ref2) {
+        return true;
+    }
+    if (ref1 == nullptr || ref2 == nullptr || typeid(*ref1) != typeid(*ref2)) {
+        return false;
+    }
+    if (typeid(*ref1) == typeid(JObject)) {
+        return dynamic_cast<const JObject*>(ref1)->offset ==
+               dynamic_cast<const JObject*>(ref2)->offset;
+    }
+    return dynamic_cast<const JArray*>(ref1)->offset ==
+           dynamic_cast<const JArray*>(ref2)->offset;
 }
 
 bool hasInheritanceRelationship(const JavaClass* source,
                                 const JavaClass* super) {
-    if (source->getClassName() == super->getClassName()) {
-        return true;
+    for (; source != nullptr; source = source->getSuperClass()) {
+        if (source == super) {
+            return true;
+        }
     }
-    if (source->hasSuperClass()) {
-        return hasInheritanceRelationship(
-            runtime.cs->loadClassIfAbsent(source->getSuperClassName()), super);
+    return false;
+}
+
+bool hasImplementationRelationship(const JavaClass* source,
+                                   const JavaClass* interfaceClass) {
+    for (; source != nullptr; source = source->getSuperClass()) {
+        if (source == interfaceClass) {
+            return true;
+        }
+        // Superinterfaces of an interface are kept in its interfaces table
+        FOR_EACH(i, source->getInterfaceCount()) {
+            if (hasImplementationRelationship(source->getInterfaceClass(i),
+                                              interfaceClass)) {
+                return true;
+            }
+        }
     }
     return false;
 }
 
+JValue loadValue(const JType* box) {
+    if (box == nullptr) {
+        return JValue::of<JRef>(nullptr);
+    }
+    if (typeid(*box) == typeid(JInt)) {
+        return JValue::of<JInt>(static_cast<const JInt*>(box)->val);
+    }
+    if (typeid(*box) == typeid(JLong)) {
+        return JValue::of<JLong>(static_cast<const JLong*>(box)->val);
+    }
+    if (typeid(*box) == typeid(JFloat)) {
+        return JValue::of<JFloat>(static_cast<const JFloat*>(box)->val);
+    }
+    if (typeid(*box) == typeid(JDouble)) {
+        return JValue::of<JDouble>(static_cast<const JDouble*>(box)->val);
+    }
+    return JValue::of<JRef>(const_cast<JType*>(box));
+}
+
+void storeValue(JType*& box, const JValue& value) {
+    switch (value.tag) {
+        case ValueTag::Int:
+            if (box != nullptr && typeid(*box) == typeid(JInt)) {
+                static_cast<JInt*>(box)->val = value.i;
+            } else {
+                box = new JInt(value.i);
+            }
+            break;
+        case ValueTag::Long:
+            if (box != nullptr && typeid(*box) == typeid(JLong)) {
+                static_cast<JLong*>(box)->val = value.j;
+            } else {
+                box = new JLong(value.j);
+            }
+            break;
+        case ValueTag::Float:
+            if (box != nullptr && typeid(*box) == typeid(JFloat)) {
+                static_cast<JFloat*>(box)->val = value.f;
+            } else {
+                box = new JFloat(value.f);
+            }
+            break;
+        case ValueTag::Double:
+            if (box != nullptr && typeid(*box) == typeid(JDouble)) {
+                static_cast<JDouble*>(box)->val = value.d;
+            } else {
+                box = new JDouble(value.d);
+            }
+            break;
+        default:
+            box = value.ref;
+            break;
+    }
+}
+
+u4 instructionLength(const u1* code, u4 pc) {
+    const u1 opcode = code[pc];
+    switch (opcode) {
+        case op_bipush:
+        case op_ldc:
+        case op_iload:
+        case op_lload:
+        case op_fload:
+        case op_dload:
+        case op_aload:
+        case op_istore:
+        case op_lstore:
+        case op_fstore:
+        case op_dstore:
+        case op_astore:
+        case op_ret:
+        case op_newarray:
+            return 2;
+        case op_sipush:
+        case op_ldc_w:
+        case op_ldc2_w:
+        case op_iinc:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_new:
+        case op_anewarray:
+        case op_checkcast:
+        case op_instanceof:
+        case op_ifnull:
+        case op_ifnonnull:
+        case op_getstatic_quick:
+        case op_putstatic_quick:
+        case op_getfield_quick:
+        case op_putfield_quick:
+        case op_invokevirtual_quick:
+        case op_invokespecial_quick:
+        case op_invokestatic_quick:
+            return 3;
+        case op_multianewarray:
+            return 4;
+        case op_invokeinterface:
+        case op_invokedynamic:
+        case op_goto_w:
+        case op_jsr_w:
+        case op_invokeinterface_quick:
+            return 5;
+        case op_wide:
+            return code[pc + 1] == op_iinc ? 6 : 4;
+        case op_tableswitch: {
+            u4 op = pc + (4 - pc % 4) - 1;
+            consumeU4(code, op);  // default
+            const auto low = static_cast<int32_t>(consumeU4(code, op));
+            const auto high = static_cast<int32_t>(consumeU4(code, op));
+            return op + 1 - pc + (high - low + 1) * 4;
+        }
+        case op_lookupswitch: {
+            u4 op = pc + (4 - pc % 4) - 1;
+            consumeU4(code, op);  // default
+            const auto npairs = static_cast<int32_t>(consumeU4(code, op));
+            return op + 1 - pc + npairs * 8;
+        }
+        default:
+            // Branch instructions take a 2 bytes offset, others have no
+            // operand
+            return (opcode >= op_ifeq && opcode <= op_jsr) ? 3 : 1;
+    }
+}
+
 void registerNativeMethod(const char* className, const char* name,
                           const char* descriptor,
-                          JType* (*func)(RuntimeEnv*, JType**,int)) {
+                          JValue (*func)(RuntimeEnv*, JValue*, int)) {
     std::string methodName(className);
     methodName.append(".");
     methodName.append(name);
@@ -232,3 +352,11 @@ std::tuple<int, std::vector<int>> peelMethodParameterAndType(
     }
     SHOULD_NOT_REACH_HERE
 }
+
+int countArgumentSlots(const std::vector<int>& parameter, bool isObjectMethod) {
+    int slots = isObjectMethod ? 1 : 0;
+    for (int kind : parameter) {
+        slots += (kind == T_LONG || kind == T_DOUBLE) ? 2 : 1;
+    }
+    return slots;
+}
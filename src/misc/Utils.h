@@ -49,6 +49,13 @@
 #define likely(x) (x)
 #define unlikely(x) (x)
 #endif
+
+// Mark a case label that is reached from the one before it on purpose
+#if (defined __GNUC__ && __GNUC__ >= 7) || (defined __clang__)
+#define YVM_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define YVM_FALLTHROUGH
+#endif
 //--------------------------------------------------------------------------------
 // Utilities that widely used in all components
 //--------------------------------------------------------------------------------
@@ -66,12 +73,23 @@ std::string javastring2stdtring(JObject* objectref);
 //--------------------------------------------------------------------------------
 // These functions were merely used by code execution engine.
 //--------------------------------------------------------------------------------
-JType* cloneValue(JType* value);
+// Whether two references denote the same heap object
+bool isSameReference(const JType* ref1, const JType* ref2);
 bool hasInheritanceRelationship(const JavaClass* source,
                                 const JavaClass* super);
+bool hasImplementationRelationship(const JavaClass* source,
+                                   const JavaClass* interfaceClass);
 void registerNativeMethod(const char* className, const char* name,
                           const char* descriptor,
-                          JType* (*func)(RuntimeEnv*, JType**, int));
+                          JValue (*func)(RuntimeEnv*, JValue*, int));
+
+//--------------------------------------------------------------------------------
+// Convert between unboxed slot values and boxed values that stored in heap
+// fields, array elements and static variables. storeValue() overwrites the
+// primitive box in place so that no memory allocation was involved.
+//--------------------------------------------------------------------------------
+JValue loadValue(const JType* box);
+void storeValue(JType*& box, const JValue& value);
 
 inline u1 consumeU1(const u1* code, u4& opidx) {
     const u1 byte = code[++opidx];
@@ -94,6 +112,14 @@ inline u4 consumeU4(const u1* code, u4& opidx) {
     return res;
 }
 
+//--------------------------------------------------------------------------------
+// Length in bytes of the instruction at pc, including its operands. pc is
+// relative to the beginning of method code since switch instructions are
+// padded according to it. Superinstructions are not recognized, code that may
+// contain them should be walked through its original copy
+//--------------------------------------------------------------------------------
+u4 instructionLength(const u1* code, u4 pc);
+
 //--------------------------------------------------------------------------------
 // These functions could peel method/field descriptors which described as jvm
 // specification to a desirable representation or check whether it's a specific
@@ -141,4 +167,6 @@ std::string peelArrayComponentTypeFrom(const std::string& descriptor);
 std::tuple<int, std::vector<int> > peelMethodParameterAndType(
     const std::string& descriptor);
 
+int countArgumentSlots(const std::vector<int>& parameter, bool isObjectMethod);
+
 #endif  // YVM_PARSEUTIL_H
@@ -24,7 +24,9 @@
 #include "ClassSpace.h"
 
 #include "../classfile/AccessFlag.h"
+#include "../interpreter/BytecodeInliner.h"
 #include "JavaClass.h"
+#include "MethodData.h"
 
 using namespace std;
 
@@ -83,6 +85,19 @@ void ClassSpace::linkJavaClass(const string& jcName) {
 
     JavaClass* javaClass = findJavaClass(jcName);
     assert(javaClass != NULL && "sanity check");
+    javaClass->layoutInstanceFields();
+    // CallSites copy code of methods, the first ones are made by dispatch
+    // tables
+    if (runtime.inlining) {
+        BytecodeInliner::inlineMethods(javaClass);
+    }
+    if (runtime.trivialMethods) {
+        FOR_EACH(i, javaClass->raw.methodsCount) {
+            javaClass->raw.methods[i].data->classifyTrivialMethod();
+        }
+    }
+    javaClass->buildDispatchTables();
+    javaClass->linked.store(true, memory_order_release);
     FOR_EACH(fieldOffset, javaClass->raw.fieldsCount) {
         const string& descriptor = javaClass->getString(
             javaClass->raw.fields[fieldOffset].descriptorIndex);
@@ -110,10 +125,10 @@ void ClassSpace::linkJavaClass(const string& jcName) {
                                 *loadClassIfAbsent("java/lang/String"));
                             fieldObject = runtime.heap->createObject(
                                 *loadClassIfAbsent("java/lang/String"));
-                            runtime.heap->putFieldByOffset(
-                                *fieldObject, 0,
-                                runtime.heap->createCharArray(constantStr,
-                                                           strLen));
+                            JArray* value = runtime.heap->createCharArray(
+                                constantStr, strLen);
+                            runtime.heap->putFieldBySlot(
+                                *fieldObject, 0, JValue::of<JArray>(value));
                         }
                     }
                 }
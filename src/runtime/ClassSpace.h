@@ -38,6 +38,7 @@ using namespace std;
 class Interpreter;
 class JavaClass;
 class ConcurrentGC;
+struct Inspector;
 
 //--------------------------------------------------------------------------------
 // Class space has responsible to manage all JavaClass objects. A complete
@@ -48,6 +49,7 @@ class ConcurrentGC;
 //--------------------------------------------------------------------------------
 class ClassSpace {
     friend class ConcurrentGC;
+    friend struct Inspector;
 
 public:
     ClassSpace(const string& path);
@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "ConstPoolCache.h"
+
+#include <stdexcept>
+#include "../classfile/AccessFlag.h"
+#include "../interpreter/MethodResolve.h"
+#include "ClassSpace.h"
+#include "JavaClass.h"
+#include "JavaHeap.hpp"
+#include "RuntimeEnv.h"
+
+using namespace std;
+
+// Find interface declaring the method from jc towards its superinterfaces
+static const JavaClass* findDeclaringInterface(const JavaClass* jc,
+                                               const string& name,
+                                               const string& descriptor,
+                                               size_t& slot) {
+    slot = jc->getMethodSlot(name, descriptor);
+    if (slot != JavaClass::METHOD_NOT_FOUND) {
+        return jc;
+    }
+    FOR_EACH(i, jc->getInterfaceCount()) {
+        const JavaClass* declaringClass = findDeclaringInterface(
+            jc->getInterfaceClass(i), name, descriptor, slot);
+        if (declaringClass != nullptr) {
+            return declaringClass;
+        }
+    }
+    return nullptr;
+}
+
+ConstPoolCache::ConstPoolCache(const JavaClass* owner, u2 constPoolCount)
+    : owner(owner),
+      constPoolCount(constPoolCount),
+      entries(new atomic<ResolvedEntry*>[constPoolCount]) {
+    for (u2 i = 0; i < constPoolCount; i++) {
+        entries[i].store(nullptr);
+    }
+}
+
+ConstPoolCache::~ConstPoolCache() {
+    for (u2 i = 0; i < constPoolCount; i++) {
+        delete entries[i].load();
+    }
+}
+
+const ResolvedEntry* ConstPoolCache::resolveClassSlow(u2 index) {
+    auto* cl = dynamic_cast<CONSTANT_Class*>(owner->getConstPoolItem(index));
+    if (cl == nullptr) {
+        throw runtime_error(
+            "invalid symbolic reference index on constant "
+            "pool");
+    }
+    unique_ptr<ResolvedEntry> entry(new ResolvedEntry);
+    entry->name = owner->getString(cl->nameIndex);
+
+    string className = entry->name;
+    if (className[0] == '[') {
+        // Array class is resolved to its element class, primitive arrays have
+        // no such class
+        className = peelArrayComponentTypeFrom(className);
+        if (className[0] != 'L') {
+            return publish(index, entry.release());
+        }
+        className = className.substr(1, className.length() - 2);
+    }
+    entry->jc = runtime.cs->loadClassIfAbsent(className);
+    if (entry->jc == nullptr) {
+        throw runtime_error("can not find class " + className);
+    }
+    runtime.cs->linkClassIfAbsent(className);
+    return publish(index, entry.release());
+}
+
+const ResolvedEntry* ConstPoolCache::resolveFieldSlow(u2 index) {
+    auto* fr = dynamic_cast<CONSTANT_Fieldref*>(owner->getConstPoolItem(index));
+    if (fr == nullptr) {
+        throw runtime_error(
+            "invalid symbolic reference index on constant "
+            "pool");
+    }
+    unique_ptr<ResolvedEntry> entry(new ResolvedEntry);
+    resolveMemberRef(entry.get(), fr->classIndex, fr->nameAndTypeIndex);
+    if (entry->jc == nullptr) {
+        throw runtime_error("can not find field " + entry->name);
+    }
+
+    entry->staticSlot =
+        entry->jc->getStaticVarSlot(entry->name, entry->descriptor);
+    if (entry->staticSlot == nullptr) {
+        const size_t slot =
+            entry->jc->getFieldSlot(entry->name, entry->descriptor);
+        if (slot == JavaClass::FIELD_NOT_FOUND) {
+            throw runtime_error("can not find field " + entry->name);
+        }
+        entry->instanceField = entry->jc->getInstanceFields()[slot];
+    }
+    return publish(index, entry.release());
+}
+
+const ResolvedEntry* ConstPoolCache::resolveMethodSlow(u2 index) {
+    ConstantPoolInfo* item = owner->getConstPoolItem(index);
+    unique_ptr<ResolvedEntry> entry(new ResolvedEntry);
+    if (auto* mr = dynamic_cast<CONSTANT_Methodref*>(item)) {
+        resolveMemberRef(entry.get(), mr->classIndex, mr->nameAndTypeIndex);
+    } else if (auto* imr = dynamic_cast<CONSTANT_InterfaceMethodref*>(item)) {
+        resolveMemberRef(entry.get(), imr->classIndex, imr->nameAndTypeIndex);
+    } else {
+        throw runtime_error(
+            "invalid symbolic reference index on constant "
+            "pool");
+    }
+
+    auto parameterAndReturnType =
+        peelMethodParameterAndType(entry->descriptor);
+    entry->returnType = get<0>(parameterAndReturnType);
+    entry->parameter = get<1>(parameterAndReturnType);
+    if (entry->jc != nullptr) {
+        entry->csite =
+            ::resolveMethod(entry->jc, entry->name, entry->descriptor);
+        if (IS_CLASS_INTERFACE(entry->jc->getAccessFlag())) {
+            entry->slotOwner =
+                findDeclaringInterface(entry->jc, entry->name,
+                                       entry->descriptor, entry->methodSlot);
+        } else {
+            entry->methodSlot =
+                entry->jc->getMethodSlot(entry->name, entry->descriptor);
+        }
+    }
+    return publish(index, entry.release());
+}
+
+const ResolvedEntry* ConstPoolCache::resolveConstantSlow(u2 index) {
+    ConstantPoolInfo* item = owner->getConstPoolItem(index);
+    unique_ptr<ResolvedEntry> entry(new ResolvedEntry);
+    if (typeid(*item) == typeid(CONSTANT_Integer)) {
+        entry->value =
+            JValue::of<JInt>(dynamic_cast<CONSTANT_Integer*>(item)->val);
+    } else if (typeid(*item) == typeid(CONSTANT_Float)) {
+        entry->value =
+            JValue::of<JFloat>(dynamic_cast<CONSTANT_Float*>(item)->val);
+    } else if (typeid(*item) == typeid(CONSTANT_Long)) {
+        entry->value =
+            JValue::of<JLong>(dynamic_cast<CONSTANT_Long*>(item)->val);
+    } else if (typeid(*item) == typeid(CONSTANT_Double)) {
+        entry->value =
+            JValue::of<JDouble>(dynamic_cast<CONSTANT_Double*>(item)->val);
+    } else if (typeid(*item) == typeid(CONSTANT_String)) {
+        // String literals of a class are shared by all ldc referring to them,
+        // ConcurrentGC keeps them alive
+        const string& val = owner->getString(
+            dynamic_cast<CONSTANT_String*>(item)->stringIndex);
+        JObject* str = runtime.heap->createObject(
+            *runtime.cs->loadClassIfAbsent("java/lang/String"));
+        JArray* value = runtime.heap->createCharArray(val, val.length());
+        // Put string  into str's field; according the source file of
+        // java.lang.Object, we know that its first field was used to store
+        // chars
+        runtime.heap->putFieldBySlot(*str, 0, JValue::of<JArray>(value));
+        entry->value = JValue::of<JObject>(str);
+    } else if (typeid(*item) == typeid(CONSTANT_Class) ||
+               typeid(*item) == typeid(CONSTANT_MethodType) ||
+               typeid(*item) == typeid(CONSTANT_MethodHandle)) {
+        throw runtime_error("nonsupport region");
+    } else {
+        throw runtime_error(
+            "invalid symbolic reference index on constant "
+            "pool");
+    }
+    return publish(index, entry.release());
+}
+
+void ConstPoolCache::resolveMemberRef(ResolvedEntry* entry, u2 classIndex,
+                                      u2 nameAndTypeIndex) {
+    auto* nat = dynamic_cast<CONSTANT_NameAndType*>(
+        owner->getConstPoolItem(nameAndTypeIndex));
+    entry->name = owner->getString(nat->nameIndex);
+    entry->descriptor = owner->getString(nat->descriptorIndex);
+    entry->jc = resolveClass(classIndex)->jc;
+}
+
+const ResolvedEntry* ConstPoolCache::publish(u2 index, ResolvedEntry* entry) {
+    lock_guard<mutex> lock(publishMtx);
+    ResolvedEntry* published = entries[index].load(memory_order_relaxed);
+    if (published != nullptr) {
+        delete entry;
+        return published;
+    }
+    entries[index].store(entry, memory_order_release);
+    return entry;
+}
@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_CONSTPOOLCACHE_H
+#define YVM_CONSTPOOLCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../classfile/ClassFile.h"
+#include "../interpreter/CallSite.h"
+#include "../misc/Utils.h"
+#include "JavaClass.h"
+#include "JavaType.h"
+
+class ConcurrentGC;
+
+//--------------------------------------------------------------------------------
+// ResolvedEntry is the resolved form of a constant pool item. Which members are
+// meaningful depends on the type of the item
+//--------------------------------------------------------------------------------
+struct ResolvedEntry {
+    // [Class]: the class itself, or the element class of an array class
+    // [Fieldref]/[Methodref]/[InterfaceMethodref]: class referred by the item
+    JavaClass* jc = nullptr;
+    // [Class]: class name as it is written in constant pool
+    std::string name;
+    std::string descriptor;
+
+    // [Fieldref]: address of a static field, or location of an instance field
+    JType** staticSlot = nullptr;
+    InstanceField instanceField;
+
+    // [Methodref]/[InterfaceMethodref]: method found by method resolution, it
+    // is not callable if jc and its supers do not declare such a method
+    CallSite csite;
+    // [Methodref]: slot in vtable of receiver's class
+    // [InterfaceMethodref]: slotOwner is the interface declaring the method,
+    // and slot indexes its itable in receiver's class
+    // The method is looked up by name if there is no such slot
+    const JavaClass* slotOwner = nullptr;
+    size_t methodSlot = JavaClass::METHOD_NOT_FOUND;
+    int returnType = 0;
+    std::vector<int> parameter;
+
+    // [Integer]/[Float]/[Long]/[Double]/[String]: value loaded by ldc
+    JValue value;
+};
+
+//--------------------------------------------------------------------------------
+// ConstPoolCache holds resolved entries of a class's constant pool, they are
+// filled the first time they are used. Resolving an item may be raced by
+// threads, only the first published entry is kept and returned to everyone
+//--------------------------------------------------------------------------------
+class ConstPoolCache {
+    friend class ConcurrentGC;
+
+public:
+    explicit ConstPoolCache(const JavaClass* owner, u2 constPoolCount);
+    ~ConstPoolCache();
+
+    forceinline const ResolvedEntry* resolveClass(u2 index) {
+        const ResolvedEntry* entry = lookup(index);
+        return entry != nullptr ? entry : resolveClassSlow(index);
+    }
+
+    forceinline const ResolvedEntry* resolveField(u2 index) {
+        const ResolvedEntry* entry = lookup(index);
+        return entry != nullptr ? entry : resolveFieldSlow(index);
+    }
+
+    // Accept both CONSTANT_Methodref and CONSTANT_InterfaceMethodref
+    forceinline const ResolvedEntry* resolveMethod(u2 index) {
+        const ResolvedEntry* entry = lookup(index);
+        return entry != nullptr ? entry : resolveMethodSlow(index);
+    }
+
+    // Loadable constants of ldc, ldc_w and ldc2_w
+    forceinline const ResolvedEntry* resolveConstant(u2 index) {
+        const ResolvedEntry* entry = lookup(index);
+        return entry != nullptr ? entry : resolveConstantSlow(index);
+    }
+
+private:
+    forceinline const ResolvedEntry* lookup(u2 index) const {
+        return entries[index].load(std::memory_order_acquire);
+    }
+
+    const ResolvedEntry* resolveClassSlow(u2 index);
+    const ResolvedEntry* resolveFieldSlow(u2 index);
+    const ResolvedEntry* resolveMethodSlow(u2 index);
+    const ResolvedEntry* resolveConstantSlow(u2 index);
+    void resolveMemberRef(ResolvedEntry* entry, u2 classIndex,
+                          u2 nameAndTypeIndex);
+    const ResolvedEntry* publish(u2 index, ResolvedEntry* entry);
+
+private:
+    const JavaClass* owner;
+    const u2 constPoolCount;
+    std::unique_ptr<std::atomic<ResolvedEntry*>[]> entries;
+    std::mutex publishMtx;
+};
+
+#endif  // YVM_CONSTPOOLCACHE_H
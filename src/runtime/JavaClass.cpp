@@ -23,6 +23,7 @@
 
 #include "JavaClass.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -32,11 +33,23 @@
 #include "../runtime/RuntimeEnv.h"
 #include "../vm/YVM.h"
 #include "ClassSpace.h"
+#include "ConstPoolCache.h"
+#include "MethodData.h"
 
 #pragma warning(disable : 4715)
 
 using namespace std;
 
+#ifdef YVM_LOOKUP_STATS
+atomic<uint64_t> JavaClass::methodLookups{0};
+atomic<uint64_t> JavaClass::methodLookupCompares{0};
+#endif
+
+static size_t hashMethodKey(const string& name, const string& descriptor) {
+    const size_t h = hash<string>()(name);
+    return h ^ (hash<string>()(descriptor) + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
 JavaClass::JavaClass(const string& classFilePath) : reader(classFilePath) {
     raw.constPoolInfo = nullptr;
     raw.fields = nullptr;
@@ -45,12 +58,31 @@ JavaClass::JavaClass(const string& classFilePath) : reader(classFilePath) {
 }
 
 JavaClass::~JavaClass() {
+    // Objects and arrays referred by static fields belong to java heap
     for (auto& i : staticVars) {
-        delete i.second;
+        if (i.second != nullptr && !IS_JObject(i.second) &&
+            !IS_JArray(i.second)) {
+            delete i.second;
+        }
     }
+    FOR_EACH(i, raw.methodsCount) { delete raw.methods[i].data; }
+    delete cpCache;
 }
 
-JavaClass::JavaClass(const JavaClass& rhs) { this->raw = rhs.raw; }
+JavaClass::JavaClass(const JavaClass& rhs) {
+    this->raw = rhs.raw;
+    this->methodIndex = rhs.methodIndex;
+    this->cpCache = new ConstPoolCache(this, raw.constPoolCount);
+}
+
+JavaClass* JavaClass::getSuperClass() const {
+    return raw.superClass == 0 ? nullptr
+                               : cpCache->resolveClass(raw.superClass)->jc;
+}
+
+JavaClass* JavaClass::getInterfaceClass(u2 index) const {
+    return cpCache->resolveClass(raw.interfaces[index])->jc;
+}
 
 vector<u2> JavaClass::getInterfacesIndex() const {
     if (raw.interfacesCount == 0) return vector<u2>();
@@ -63,53 +95,206 @@ vector<u2> JavaClass::getInterfacesIndex() const {
     return v;
 }
 
-MethodInfo* JavaClass::findMethod(const string& methodName,
-                                  const string& methodDescriptor) const {
+//--------------------------------------------------------------------------------
+// Fields declared by this class are placed after fields of superclass. Wider
+// fields are placed first and every field is aligned to its own width, so there
+// is little padding between them. Slots are still numbered in declaration order
+//--------------------------------------------------------------------------------
+void JavaClass::layoutInstanceFields() {
+    // Resolving superclass links it, so its layout is ready
+    if (const JavaClass* superClass = getSuperClass()) {
+        instanceFields = superClass->instanceFields;
+        instanceSize = superClass->instanceSize;
+        referenceMap = superClass->referenceMap;
+    }
+    const size_t firstSlot = instanceFields.size();
+    FOR_EACH(i, raw.fieldsCount) {
+        if (!IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
+            const string& descriptor = getString(raw.fields[i].descriptorIndex);
+            declaredFieldSlots.insert(make_pair(
+                getString(raw.fields[i].nameIndex) + "." + descriptor,
+                instanceFields.size()));
+            InstanceField field;
+            field.type = descriptor[0];
+            instanceFields.push_back(field);
+        }
+    }
+
+    for (size_t width = sizeof(int64_t); width > 0; width /= 2) {
+        for (size_t slot = firstSlot; slot < instanceFields.size(); slot++) {
+            InstanceField& field = instanceFields[slot];
+            if (widthOf(field.type) != width) {
+                continue;
+            }
+            instanceSize = (instanceSize + width - 1) / width * width;
+            field.offset = static_cast<uint32_t>(instanceSize);
+            instanceSize += width;
+            if (field.type == 'L' || field.type == '[') {
+                referenceMap.push_back(field.offset);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Methods that are not static, private or initialization methods are
+// virtual. An interface's slots list its own virtual methods, and each class
+// gets an itable for every interface it implements, which maps those slots to
+// the selected implementations
+//--------------------------------------------------------------------------------
+static bool isVirtualMethod(const JavaClass* jc, const MethodInfo& m) {
+    return !IS_METHOD_STATIC(m.accessFlags) &&
+           !IS_METHOD_PRIVATE(m.accessFlags) &&
+           jc->getUtf8(m.nameIndex)[0] != '<';
+}
+
+static void collectInterfaces(const JavaClass* jc,
+                              vector<const JavaClass*>& interfaces) {
+    FOR_EACH(i, jc->getInterfaceCount()) {
+        const JavaClass* interfaceClass = jc->getInterfaceClass(i);
+        if (find(interfaces.begin(), interfaces.end(), interfaceClass) ==
+            interfaces.end()) {
+            interfaces.push_back(interfaceClass);
+            collectInterfaces(interfaceClass, interfaces);
+        }
+    }
+}
+
+void JavaClass::buildDispatchTables() {
+    const bool isInterface = IS_CLASS_INTERFACE(raw.accessFlags);
+    const JavaClass* superClass = getSuperClass();
+    if (superClass != nullptr && !isInterface) {
+        vtable = superClass->vtable;
+        vtableSlots = superClass->vtableSlots;
+    }
     FOR_EACH(i, raw.methodsCount) {
-        assert(typeid(*raw.constPoolInfo[raw.methods[i].nameIndex]) ==
-               typeid(CONSTANT_Utf8));
+        if (!isVirtualMethod(this, raw.methods[i])) {
+            continue;
+        }
+        const string key = getString(raw.methods[i].nameIndex) + "." +
+                           getString(raw.methods[i].descriptorIndex);
+        auto pos = vtableSlots.find(key);
+        if (pos != vtableSlots.end()) {
+            vtable[pos->second] = CallSite::makeCallSite(this, &raw.methods[i]);
+        } else {
+            vtableSlots.insert(make_pair(key, vtable.size()));
+            vtable.push_back(CallSite::makeCallSite(this, &raw.methods[i]));
+        }
+    }
+    if (isInterface) {
+        return;
+    }
 
-        const string& mn = getString(raw.methods[i].nameIndex);
-        const string& md = getString(raw.methods[i].descriptorIndex);
-        if (mn == methodName && md == methodDescriptor) {
-            return &raw.methods[i];
+    vector<const JavaClass*> interfaces;
+    for (const JavaClass* c = this; c != nullptr; c = c->getSuperClass()) {
+        collectInterfaces(c, interfaces);
+    }
+    for (const JavaClass* interfaceClass : interfaces) {
+        vector<CallSite> itable(interfaceClass->vtable);
+        for (const auto& slot : interfaceClass->vtableSlots) {
+            // Methods of class hierarchy take precedence over default methods
+            // of interfaces
+            auto pos = vtableSlots.find(slot.first);
+            if (pos != vtableSlots.end()) {
+                itable[slot.second] = vtable[pos->second];
+                continue;
+            }
+            if (!IS_METHOD_ABSTRACT(itable[slot.second].accessFlags)) {
+                continue;
+            }
+            for (const JavaClass* other : interfaces) {
+                size_t otherSlot = other->getMethodSlot(slot.first);
+                if (otherSlot != METHOD_NOT_FOUND &&
+                    !IS_METHOD_ABSTRACT(other->vtable[otherSlot].accessFlags)) {
+                    itable[slot.second] = other->vtable[otherSlot];
+                    break;
+                }
+            }
+        }
+        itables.push_back(make_pair(interfaceClass, move(itable)));
+    }
+}
+
+size_t JavaClass::getMethodSlot(const string& name,
+                                const string& descriptor) const {
+    return getMethodSlot(name + "." + descriptor);
+}
+
+size_t JavaClass::getMethodSlot(const string& key) const {
+    auto pos = vtableSlots.find(key);
+    return pos != vtableSlots.end() ? pos->second : METHOD_NOT_FOUND;
+}
+
+const vector<CallSite>* JavaClass::getItable(
+    const JavaClass* interfaceClass) const {
+    for (const auto& itable : itables) {
+        if (itable.first == interfaceClass) {
+            return &itable.second;
         }
     }
     return nullptr;
 }
 
-bool JavaClass::setStaticVar(const string& name, const string& descriptor,
-                             JType* value) {
-    FOR_EACH(i, raw.fieldsCount) {
-        if (IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
-            auto n = getString(raw.fields[i].nameIndex);
-            auto d = getString(raw.fields[i].descriptorIndex);
-            if (n == name && d == descriptor) {
-                staticVars.find(i)->second = value;
-                return true;
-            }
+size_t JavaClass::getFieldSlot(const string& name,
+                               const string& descriptor) const {
+    const string key = name + "." + descriptor;
+    for (const JavaClass* c = this; c != nullptr; c = c->getSuperClass()) {
+        auto pos = c->declaredFieldSlots.find(key);
+        if (pos != c->declaredFieldSlots.end()) {
+            return pos->second;
         }
     }
-    if (raw.superClass != 0) {
-        return runtime.cs->findJavaClass(getSuperClassName())
-            ->setStaticVar(name, descriptor, value);
+    return FIELD_NOT_FOUND;
+}
+
+MethodInfo* JavaClass::findMethod(const string& methodName,
+                                  const string& methodDescriptor) const {
+#ifdef YVM_LOOKUP_STATS
+    methodLookups.fetch_add(1, memory_order_relaxed);
+#endif
+    auto range =
+        methodIndex.equal_range(hashMethodKey(methodName, methodDescriptor));
+    for (auto pos = range.first; pos != range.second; ++pos) {
+#ifdef YVM_LOOKUP_STATS
+        methodLookupCompares.fetch_add(1, memory_order_relaxed);
+#endif
+        MethodInfo* m = pos->second;
+        if (methodName == getUtf8(m->nameIndex) &&
+            methodDescriptor == getUtf8(m->descriptorIndex)) {
+            return m;
+        }
+    }
+    return nullptr;
+}
+
+bool JavaClass::setStaticVar(const string& name, const string& descriptor,
+                             const JValue& value) {
+    JType** slot = getStaticVarSlot(name, descriptor);
+    if (slot == nullptr) {
+        return false;
     }
-    return false;
+    storeValue(*slot, value);
+    return true;
 }
 
 JType* JavaClass::getStaticVar(const string& name, const string& descriptor) {
+    JType** slot = getStaticVarSlot(name, descriptor);
+    return slot != nullptr ? *slot : nullptr;
+}
+
+JType** JavaClass::getStaticVarSlot(const string& name,
+                                    const string& descriptor) {
     FOR_EACH(i, raw.fieldsCount) {
         if (IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
             auto n = getString(raw.fields[i].nameIndex);
             auto d = getString(raw.fields[i].descriptorIndex);
             if (n == name && d == descriptor) {
-                return staticVars.find(i)->second;
+                return &staticVars.find(i)->second;
             }
         }
     }
     if (raw.superClass != 0) {
-        return runtime.cs->findJavaClass(getSuperClassName())
-            ->getStaticVar(name, descriptor);
+        return getSuperClass()->getStaticVarSlot(name, descriptor);
     }
     return nullptr;
 }
@@ -133,6 +318,7 @@ void JavaClass::parseClassFile() {
         cerr << __func__ << ":Failed to parse constant pool\n";
         exit(EXIT_FAILURE);
     }
+    cpCache = new ConstPoolCache(this, raw.constPoolCount);
 #ifdef YVM_DEBUG_SHOW_CONSTANT_POOL_TABLE
     Inspector::printConstantPool(*this);
 #endif
@@ -414,6 +600,35 @@ bool JavaClass::parseMethod(u2 methodCount) {
         raw.methods[i].attributeCount = reader.readget2();
         parseAttribute(raw.methods[i].attributes,
                        raw.methods[i].attributeCount);
+        const ATTR_Code* codeAttr = nullptr;
+        FOR_EACH(k, raw.methods[i].attributeCount) {
+            if (typeid(*raw.methods[i].attributes[k]) == typeid(ATTR_Code)) {
+                codeAttr =
+                    dynamic_cast<ATTR_Code*>(raw.methods[i].attributes[k]);
+                break;
+            }
+        }
+        const char* name = getUtf8(raw.methods[i].nameIndex);
+        const char* descriptor = getUtf8(raw.methods[i].descriptorIndex);
+        NativeFunction nativeFunction = nullptr;
+        if (IS_METHOD_NATIVE(raw.methods[i].accessFlags)) {
+            auto func = runtime.nativeMethods.find(getClassName() + "." +
+                                                   name + "." + descriptor);
+            if (func != runtime.nativeMethods.end()) {
+                nativeFunction = func->second;
+            }
+        }
+        raw.methods[i].data = new MethodData(&raw.methods[i], name, descriptor,
+                                             codeAttr, nativeFunction);
+        if (codeAttr != nullptr && !runtime.compiledMethods.empty()) {
+            auto compiled = runtime.compiledMethods.find(
+                getClassName() + "." + name + "." + descriptor);
+            if (compiled != runtime.compiledMethods.end()) {
+                raw.methods[i].data->bindCompiledMethod(*compiled->second);
+            }
+        }
+        methodIndex.insert(
+            make_pair(hashMethodKey(name, descriptor), &raw.methods[i]));
     }
     return true;
 }
@@ -24,8 +24,12 @@
 #ifndef YVM_JAVACLASS_H
 #define YVM_JAVACLASS_H
 
+#include <atomic>
+#include <map>
+#include <unordered_map>
 #include "../classfile/ClassFile.h"
 #include "../classfile/FileReader.h"
+#include "../interpreter/CallSite.h"
 #include "../interpreter/Internal.h"
 #include "../misc/Utils.h"
 #include "../vm/YVM.h"
@@ -41,12 +45,16 @@
 
 using namespace std;
 
+class ConstPoolCache;
+
 //--------------------------------------------------------------------------------
 // JavaClass is an in-memory representation of java class file. We should call
 // parseClassFile() to parse into proper structure before any operation on*
 // JavaClass.
 //--------------------------------------------------------------------------------
 class JavaClass {
+    friend class AotCompiler;
+    friend class BytecodeInliner;
     friend struct Inspector;
     friend struct YVM;
     friend class JavaHeap;
@@ -64,11 +72,16 @@ public:
         return raw.constPoolInfo[index];
     }
 
-    forceinline const string getString(u2 index) const {
+    // Return utf8 constant without copying it
+    forceinline const char* getUtf8(u2 index) const {
         return reinterpret_cast<const char*>(
             dynamic_cast<CONSTANT_Utf8*>(raw.constPoolInfo[index])->bytes);
     }
 
+    forceinline const string getString(u2 index) const {
+        return getUtf8(index);
+    }
+
     forceinline const string getClassName() const {
         return getString(
             dynamic_cast<CONSTANT_Class*>(raw.constPoolInfo[raw.thisClass])
@@ -97,14 +110,68 @@ public:
 
     forceinline u2 getAccessFlag() const { return raw.accessFlags; }
 
+    forceinline ConstPoolCache* getConstPoolCache() const { return cpCache; }
+
+    // Resolved direct superclass, null if it's java/lang/Object
+    JavaClass* getSuperClass() const;
+
+    JavaClass* getInterfaceClass(u2 index) const;
+
 public:
+    static constexpr size_t FIELD_NOT_FOUND = static_cast<size_t>(-1);
+
+    // Return slot of the instance field in objects of this class and its
+    // subclasses, or FIELD_NOT_FOUND. The field is looked up from this class
+    // towards its supers
+    size_t getFieldSlot(const string& name, const string& descriptor) const;
+
+    static constexpr size_t METHOD_NOT_FOUND = static_cast<size_t>(-1);
+
+    // Return vtable slot of the virtual method, or METHOD_NOT_FOUND. Slots of
+    // an interface index its itable in classes implementing it instead
+    size_t getMethodSlot(const string& name, const string& descriptor) const;
+
+    forceinline const CallSite& getVirtualMethod(size_t slot) const {
+        return vtable[slot];
+    }
+
+    // Return itable of the interface, or null if this class doesn't
+    // implement it
+    const vector<CallSite>* getItable(const JavaClass* interfaceClass) const;
+
+    // Instance field layout and dispatch tables are ready. It's set before
+    // static fields are initialized, so a class being linked can already
+    // create its objects
+    bool isLinked() const { return linked.load(memory_order_acquire); }
+
+    // Locations of instance fields indexed by slot
+    const vector<InstanceField>& getInstanceFields() const {
+        return instanceFields;
+    }
+    // Bytes of instance fields in an object of this class
+    size_t getInstanceSize() const { return instanceSize; }
+    // Offsets of reference fields, GC traces objects through them
+    const vector<uint32_t>& getReferenceMap() const { return referenceMap; }
+
     MethodInfo* findMethod(const string& methodName,
                            const string& methodDescriptor) const;
+#ifdef YVM_LOOKUP_STATS
+    // findMethod() calls of all classes and methods compared by them
+    static atomic<uint64_t> methodLookups;
+    static atomic<uint64_t> methodLookupCompares;
+#endif
     bool setStaticVar(const string& name, const string& descriptor,
-                      JType* value);
+                      const JValue& value);
     JType* getStaticVar(const string& name, const string& descriptor);
+    // Return address of the static variable, it keeps valid as long as the
+    // class is alive
+    JType** getStaticVarSlot(const string& name, const string& descriptor);
 
 private:
+    void layoutInstanceFields();
+    void buildDispatchTables();
+    size_t getMethodSlot(const string& key) const;
+
     void parseClassFile();
     bool parseConstantPool(u2 cpCount);
     bool parseInterface(u2 interfaceCount);
@@ -121,8 +188,29 @@ private:
 
 private:
     ClassFile raw{};
+    ConstPoolCache* cpCache = nullptr;
     FileReader reader;
     map<size_t, JType*> staticVars;
+    // Methods keyed by hash of their name and descriptor, built when methods
+    // are parsed
+    unordered_multimap<size_t, MethodInfo*> methodIndex;
+
+    // Instance fields of superclass come first, so a field has the same slot
+    // and location in objects of all subclasses
+    vector<InstanceField> instanceFields;
+    size_t instanceSize = 0;
+    vector<uint32_t> referenceMap;
+    // Slots of fields declared by this class, keyed by "name.descriptor"
+    unordered_map<string, size_t> declaredFieldSlots;
+
+    // Overriding methods take slots of the methods they override, so a
+    // virtual method has the same slot in vtables of all subclasses
+    vector<CallSite> vtable;
+    // Slots of virtual methods, keyed by "name.descriptor"
+    unordered_map<string, size_t> vtableSlots;
+    vector<pair<const JavaClass*, vector<CallSite>>> itables;
+
+    atomic<bool> linked{false};
 };
 
 #endif  // YVM_JAVACLASS_H
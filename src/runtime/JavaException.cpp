@@ -47,8 +47,10 @@ void StackTrace::printStackTrace() {
 
 void StackTrace::setThrowExceptionInfo(JObject* throwableObject) {
     throwExceptionClass = throwableObject->jc;
-    auto* messageField = dynamic_cast<JObject*>(runtime.heap->getFieldByName(
-        runtime.cs->findJavaClass("java/lang/Throwable"), "message",
-        "Ljava/lang/String;", throwableObject));
+    auto* messageField =
+        runtime.heap
+            ->getFieldByName(runtime.cs->findJavaClass("java/lang/Throwable"),
+                             "message", "Ljava/lang/String;", throwableObject)
+            .as<JObject>();
     detailedMsg = javastring2stdtring(messageField);
 }
@@ -21,55 +21,94 @@
 // SOFTWARE.
 //
 
-#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "../misc/Option.h"
 #include "JavaFrame.hpp"
+#include "RuntimeEnv.h"
 
-JavaFrame::~JavaFrame() {
-    while (top_) {
-        auto* temp = top_;
-        top_ = top_->next;
-        delete temp;
-    }
+// Every frame takes at least one slot of the arena, so a deeper stack could
+// never be pushed and headers are not reserved for it. Native stack usage is
+// measured from the address of an argument
+JavaFrame::JavaFrame(size_t maxDepth, size_t arenaSize)
+    : maxDepth(std::min(maxDepth, arenaSize)),
+      arenaSize(arenaSize),
+      arenaTop(0),
+      nativeStackBase(reinterpret_cast<std::uintptr_t>(&arenaSize)) {
+    frames.reserve(this->maxDepth);
+    // Raw storage only, pages of the arena are not touched until a frame
+    // actually lands on them
+    arena = static_cast<JValue*>(::operator new(arenaSize * sizeof(JValue)));
 }
 
-void JavaFrame::pushFrame(int maxLocal, int maxStack) {
-    auto* slots = new Slots{maxLocal, maxStack};
-    slots->next = top_;
-    top_ = slots;
-}
+JavaFrame::JavaFrame()
+    : JavaFrame(runtime.maxFrameDepth, YVM_FRAME_ARENA_SIZE) {}
 
-void JavaFrame::popFrame() {
-    auto* temp = top_;
-    top_ = top_->next;
-    delete temp;
+JavaFrame::~JavaFrame() { ::operator delete(arena); }
+
+void JavaFrame::pushFrame(int maxLocal, int maxStack) {
+    pushFrame(maxLocal, maxStack, 0);
 }
 
-Slots::Slots(int maxLocal, int maxStack)
-    : maxLocal(maxLocal),
-      maxStack(maxStack),
-      next(nullptr),
-      localSlots(nullptr),
-      stackSlots(nullptr) {
-    if (maxLocal > 0) {
-        localSlots = new JType*[maxLocal];
-        memset(localSlots, 0, sizeof(JType*) * maxLocal);
+void JavaFrame::pushFrame(int maxLocal, int maxStack, int argumentCount) {
+    JValue* base = arena + arenaTop;
+    if (argumentCount > 0) {
+        Slots& caller = frames.back();
+        caller.stackTop -= argumentCount;
+        base = caller.stackSlots + caller.stackTop;
     }
-    if (maxStack > 0) {
-        stackSlots = new JType*[maxStack];
-        memset(stackSlots, 0, sizeof(JType*) * maxStack);
+    // One spare operand slot is kept in every frame, an exception propagated
+    // from a void callee is pushed there even if the caller's stack is full
+    const size_t required = maxLocal + maxStack + 1;
+    const size_t baseIndex = base - arena;
+    if (frames.size() >= maxDepth || baseIndex + required > arenaSize) {
+        if (argumentCount > 0) {
+            frames.back().stackTop += argumentCount;
+        }
+        throw StackOverflowError("java.lang.StackOverflowError: depth " +
+                                 std::to_string(frames.size()));
     }
-
-    stackTop = 0;
+    std::uninitialized_fill_n(base + argumentCount, maxLocal - argumentCount,
+                              JValue{});
+    arenaTop = baseIndex + required;
+    Slots* next = frames.empty() ? nullptr : &frames.back();
+    frames.emplace_back(base, maxLocal, maxStack + 1, next);
 }
 
-Slots::~Slots() {
-    delete[] stackSlots;
+void JavaFrame::checkNativeStack() const {
+    // Stack grows down, the address of a local variable tells how much of it
+    // has been taken
+    char top;
+    const std::uintptr_t used =
+        nativeStackBase - reinterpret_cast<std::uintptr_t>(&top);
+    if (used > YVM_NATIVE_STACK_SIZE) {
+        throw StackOverflowError("java.lang.StackOverflowError: depth " +
+                                 std::to_string(frames.size()));
+    }
+}
 
-    delete[] localSlots;
+void JavaFrame::popFrame() {
+    frames.pop_back();
+    if (frames.empty()) {
+        arenaTop = 0;
+    } else {
+        Slots& slots = frames.back();
+        arenaTop = slots.stackSlots + slots.maxStack - arena;
+    }
 }
 
-void Slots::setLocalVariable(u1 index, JType* var) {
-    if (index > maxLocal) {
+Slots::Slots(JValue* base, int maxLocal, int maxStack, Slots* next)
+    : localSlots(base),
+      stackSlots(base + maxLocal),
+      maxLocal(maxLocal),
+      maxStack(maxStack),
+      stackTop(0),
+      next(next) {}
+
+void Slots::setLocalVariable(u1 index, const JValue& var) {
+    if (index >= maxLocal) {
         throw std::logic_error("invalid local variable slot index");
     }
     localSlots[index] = var;
@@ -83,14 +122,3 @@ void Slots::dump() {
         temp = temp->next;
     }
 }
-
-void Slots::grow(int size) {
-    JType** newStack = new JType*[size + maxStack];
-    memset(newStack, 0, sizeof(JType*) * (size + maxStack));
-    for (int i = 0; i < maxStack; i++) {
-        newStack[i] = stackSlots[i];
-    }
-    delete[] stackSlots;
-    this->stackSlots = newStack;
-    this->maxStack = maxStack + size;
-}
@@ -24,8 +24,10 @@
 #ifndef YVM_JAVAFRAME_H
 #define YVM_JAVAFRAME_H
 
+#include <cstdint>
 #include <exception>
-#include <list>
+#include <stdexcept>
+#include <vector>
 #include "../gc/Concurrent.hpp"
 #include "../interpreter/Internal.h"
 #include "../misc/Utils.h"
@@ -34,6 +36,19 @@
 using namespace std;
 
 struct JType;
+class JavaClass;
+class MethodData;
+class RegisterCode;
+
+//--------------------------------------------------------------------------------
+// Raised when a thread's frame stack exceeds its configured depth or its slot
+// arena, it plays the role of java.lang.StackOverflowError
+//--------------------------------------------------------------------------------
+class StackOverflowError : public std::runtime_error {
+public:
+    explicit StackOverflowError(const std::string &msg)
+        : std::runtime_error(msg) {}
+};
 
 class Slots {
     friend class JavaFrame;
@@ -41,9 +56,7 @@ class Slots {
     friend class Interpreter;
 
 public:
-    explicit Slots(int maxLocal, int maxStack);
-
-    ~Slots();
+    explicit Slots(JValue *base, int maxLocal, int maxStack, Slots *next);
 
     // Check if current frame's stack slots were empty
     bool emptyStack() const { return stackTop == 0; }
@@ -58,91 +71,117 @@ public:
     void store(u1 index);
 
     // Push new variable to current frame's stack slot
-    void push(JType *var) { stackSlots[stackTop++] = var; }
+    void push(const JValue &var) { stackSlots[stackTop++] = var; }
+
+    template <typename PushType>
+    void push(typename ValueTraits<PushType>::type var) {
+        ValueTraits<PushType>::set(stackSlots[stackTop++], var);
+    }
 
     // Pop variable from top of the current frame's stack
+    JValue pop();
+
     template <typename PopType>
-    PopType *pop();
+    typename ValueTraits<PopType>::type pop();
 
     // Set new variable to current frame's local variable slot
-    void setLocalVariable(u1 index, JType *var);
+    void setLocalVariable(u1 index, const JValue &var);
 
     // Get variable from local variables by given index
-    JType *getLocalVariable(u1 index) { return localSlots[index]; }
+    JValue &getLocalVariable(u1 index) { return localSlots[index]; }
 
     // Dump current frame to stdout
     void dump();
 
-    // Reallocate stack slots size accorrding to argument, this can be used when
-    // an exception occurred
-    void grow(int size);
-
 private:
-    std::list<JType *> exceptions;
-    JType **localSlots;
-    JType **stackSlots;
+    JValue *localSlots;
+    JValue *stackSlots;
     const int maxLocal;
-    int maxStack;
+    const int maxStack;
     int stackTop;
     Slots *next;
+
+    // Method running in this frame and pc of the instruction it's executing,
+    // pc is saved when it calls another method in the same dispatch loop
+    const JavaClass *jc = nullptr;
+    MethodData *method = nullptr;
+    u4 pc = 0;
+    // Register code of the method if it runs as register code or machine code,
+    // pc is then the register instruction it continues at
+    const RegisterCode *registerCode = nullptr;
 };
 
 //--------------------------------------------------------------------------------
 // Java frame represents runtime frames. Each interpreter has a JavaFrame, it
 // consists of many Slots, one Slots is logically divided into local variable
-// slots and stack slots
+// slots and stack slots.
+//
+// All slots of a thread are bump-allocated from one reserved arena, a frame's
+// local variables are immediately followed by its operand stack, and the next
+// frame starts right after that. Pushing and popping a frame therefore only
+// moves the arena top.
+//
+// A frame pushed for a method invocation starts inside its caller's operand
+// stack instead, so that arguments pushed by the caller already are the first
+// local variables of callee:
+//
+//   | caller locals | caller stack | arguments     |
+//                                  | callee locals      | callee stack |
+//
+// Caller's operand stack is cut back below arguments when the frame is pushed.
 //--------------------------------------------------------------------------------
 class JavaFrame {
     friend class ConcurrentGC;
 
 public:
+    explicit JavaFrame(size_t maxDepth, size_t arenaSize);
+
+    explicit JavaFrame();
+
     ~JavaFrame();
 
     // Push new frame
     void pushFrame(int maxLocal, int maxStack);
 
+    // Push new frame whose first argumentCount local variables are the top
+    // argumentCount values on current frame's operand stack
+    void pushFrame(int maxLocal, int maxStack, int argumentCount);
+
     // Pop top frame
     void popFrame();
 
     // Check if there is more frames
-    bool hasFrame() const { return top_ != nullptr; }
+    bool hasFrame() const { return !frames.empty(); }
 
     // Return top frame
-    Slots *top() { return top_; }
+    Slots *top() { return frames.empty() ? nullptr : &frames.back(); }
 
     // Return next to top's frame
-    Slots *nextFrame() { return top_->next; }
+    Slots *nextFrame() { return frames.back().next; }
+
+    // Return the number of active frames
+    size_t depth() const { return frames.size(); }
+
+    // Raise StackOverflowError if calls nested in C++ since the frame stack
+    // was created have taken more than YVM_NATIVE_STACK_SIZE bytes of native
+    // stack. The frame stack must be created by the thread using it
+    void checkNativeStack() const;
 
 private:
-    Slots *top_{};
+    // Headers of active frames, its capacity is reserved up front so that
+    // addresses of Slots never change while they are in use
+    std::vector<Slots> frames;
+    const size_t maxDepth;
+    JValue *arena;
+    const size_t arenaSize;
+    size_t arenaTop;
+    // Native stack address of the thread when the frame stack was created
+    const std::uintptr_t nativeStackBase;
 };
 
 template <typename LoadType>
 inline void Slots::load(u1 localIndex) {
-    auto *var = new LoadType;
-    var->val = dynamic_cast<LoadType *>(localSlots[localIndex])->val;
-    stackSlots[stackTop++] = var;
-}
-
-template <>
-inline void Slots::load<JRef>(u1 localIndex) {
-    JType *var{};
-    if (typeid(*localSlots[localIndex]) == typeid(JObject)) {
-        var = new JObject;
-        dynamic_cast<JObject *>(var)->jc =
-            dynamic_cast<JObject *>(localSlots[localIndex])->jc;
-        dynamic_cast<JObject *>(var)->offset =
-            dynamic_cast<JObject *>(localSlots[localIndex])->offset;
-    } else if (typeid(*localSlots[localIndex]) == typeid(JArray)) {
-        var = new JArray;
-        dynamic_cast<JArray *>(var)->length =
-            dynamic_cast<JArray *>(localSlots[localIndex])->length;
-        dynamic_cast<JArray *>(var)->offset =
-            dynamic_cast<JArray *>(localSlots[localIndex])->offset;
-    } else {
-        SHOULD_NOT_REACH_HERE
-    }
-    stackSlots[stackTop++] = var;
+    stackSlots[stackTop++] = localSlots[localIndex];
 }
 
 template <typename StoreType>
@@ -150,22 +189,26 @@ inline void Slots::store(u1 localIndex) {
     if (stackTop) {
         stackTop--;
     }
-    auto *var = dynamic_cast<StoreType *>(stackSlots[stackTop]);
-    stackSlots[stackTop] = nullptr;
-    localSlots[localIndex] = var;
-    if (IS_JLong(var) || IS_JDouble(var)) {
-        localSlots[localIndex++] = nullptr;
+    localSlots[localIndex] = stackSlots[stackTop];
+    if (localSlots[localIndex].isWide()) {
+        // The second slot of long and double is not addressable
+        localSlots[localIndex + 1].tag = ValueTag::Empty;
+    }
+}
+
+inline JValue Slots::pop() {
+    if (stackTop) {
+        stackTop--;
     }
+    return stackSlots[stackTop];
 }
 
 template <typename PopType>
-inline PopType *Slots::pop() {
+inline typename ValueTraits<PopType>::type Slots::pop() {
     if (stackTop) {
         stackTop--;
     }
-    auto *var = dynamic_cast<PopType *>(stackSlots[stackTop]);
-    stackSlots[stackTop] = nullptr;
-    return var;
+    return ValueTraits<PopType>::get(stackSlots[stackTop]);
 }
 
 #endif
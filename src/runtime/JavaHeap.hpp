@@ -24,8 +24,10 @@
 #ifndef YVM_JAVAHEAP_H
 #define YVM_JAVAHEAP_H
 
-#include <map>
+#include <atomic>
+#include <cstring>
 #include <mutex>
+#include <new>
 #include <vector>
 #include "../gc/GC.h"
 #include "JavaType.h"
@@ -34,119 +36,228 @@
 
 using namespace std;
 
+//--------------------------------------------------------------------------------
+// Container is a paged handle table, the offset of an object or an array is the
+// index of its slot. Slots are allocated in fixed size pages which never move,
+// so offset to payload is an indexed load and growing the table copies nothing.
+// Released slots are kept in a free list and recycled by the next place(), both
+// placing and removing are therefore O(1) and GC sweeps slots linearly.
+// Offset 0 is never handed out.
+//
+// pages[0]  ->  [ - ][ 1 ][ 2 ][ 3 ]...[1023]
+// pages[1]  ->  [1024][1025][1026]...[2047]
+// freeSlots ->  3, 1026, ...
+//--------------------------------------------------------------------------------
 template <typename Type>
 class Container {
-    friend class ConcurrentGC;
-
 public:
     explicit Container() = default;
-    virtual ~Container() {}
+    Container(const Container&) = delete;
+    Container& operator=(const Container&) = delete;
+    virtual ~Container() {
+        for (auto page : pages) {
+            delete[] page;
+        }
+    }
 
-    virtual size_t place();
+    size_t place();
     void remove(size_t offset);
-    Type& find(size_t offset) { return data.find(offset)->second; }
-    bool has(size_t offset) { return data.find(offset) != data.end(); }
+    Type& find(size_t offset) { return slotAt(offset).payload; }
+    bool has(size_t offset) const {
+        return offset < nextSlot && slotAt(offset).live;
+    }
+    // Every offset handed out so far is less than capacity()
+    size_t capacity() const { return nextSlot; }
 
-protected:
-    auto& getContainer() { return data; }
+    // Visit payload of every live slot in offset order
+    template <typename Visitor>
+    void forEach(Visitor visit);
+    // Release every live slot for which reclaim(offset, payload) returns true
+    template <typename Reclaim>
+    void sweep(Reclaim reclaim);
 
 private:
-    map<size_t, Type, less<>, HeapAllocator<pair<const size_t, Type>>> data;
+    static constexpr size_t PageBits = 10;
+    static constexpr size_t PageSize = size_t(1) << PageBits;
+
+    struct Slot {
+        Type payload{};
+        bool live = false;
+    };
+
+    Slot& slotAt(size_t offset) {
+        return pages[offset >> PageBits][offset & (PageSize - 1)];
+    }
+    const Slot& slotAt(size_t offset) const {
+        return pages[offset >> PageBits][offset & (PageSize - 1)];
+    }
+    void release(size_t offset) {
+        Slot& slot = slotAt(offset);
+        slot.payload = Type{};
+        slot.live = false;
+        freeSlots.push_back(offset);
+    }
+
+    vector<Slot*> pages;
+    vector<size_t> freeSlots;
+    size_t nextSlot = 1;
 };
 
+template <typename Type>
+size_t Container<Type>::place() {
+    size_t offset;
+    if (!freeSlots.empty()) {
+        offset = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        if ((nextSlot >> PageBits) == pages.size()) {
+            pages.push_back(new Slot[PageSize]);
+        }
+        offset = nextSlot++;
+    }
+    slotAt(offset).live = true;
+    return offset;
+}
+
 template <typename Type>
 void Container<Type>::remove(size_t offset) {
-    if (data.find(offset) != data.end()) {
-        data.erase(offset);
+    if (has(offset)) {
+        release(offset);
     }
 }
 
 template <typename Type>
-size_t Container<Type>::place() {
-    size_t lastOffset = 0;
-    if (!data.empty()) {
-        lastOffset = (--data.end())->first;
+template <typename Visitor>
+void Container<Type>::forEach(Visitor visit) {
+    for (size_t offset = 1; offset < nextSlot; offset++) {
+        Slot& slot = slotAt(offset);
+        if (slot.live) {
+            visit(offset, slot.payload);
+        }
+    }
+}
+
+template <typename Type>
+template <typename Reclaim>
+void Container<Type>::sweep(Reclaim reclaim) {
+    for (size_t offset = 1; offset < nextSlot; offset++) {
+        Slot& slot = slotAt(offset);
+        if (slot.live && reclaim(offset, slot.payload)) {
+            release(offset);
+        }
     }
-    data.insert(make_pair(lastOffset + 1, Type{}));
-    return lastOffset + 1;
 }
 
 //--------------------------------------------------------------------------------
-// The ArrayContainer manages array's elements as well as object pool
+// The ArrayContainer manages arrays. Every array is a single allocation of its
+// header and elements, see JArray
 //
-// [1]  ->   <3, [field_a, field_b, field_c]>
-// [2]  ->   <0, []>
-// [3]  ->   <2, [field_a,field_b]>
-// [4]  ->   <1, [field_a]>
-// [..] ->   <..,[...]>
+// [1]  ->   [header(3, I) | 1, 2, 3]
+// [2]  ->   [header(0, C)]
+// [3]  ->   [header(2, L) | object_a, null]
+// [4]  ->   [header(1, D) | 0.5]
+// [..] ->   [...]
 //--------------------------------------------------------------------------------
-using InternalArray = pair<size_t, JType**>;
+using InternalArray = JArray*;
 struct ArrayContainer : public Container<InternalArray> {
     ~ArrayContainer() override {
-        for (auto intPairPair : getContainer()) {
-            for (size_t i = 0; i < intPairPair.second.first; i++) {
-                delete intPairPair.second.second[i];
-            }
-            delete[] intPairPair.second.second;
-        }
+        forEach([](size_t, InternalArray& array) { destroy(array); });
+    }
+
+    static JArray* create(char type, int length) {
+        const size_t bytes = widthOf(type) * length;
+        auto* array = new (::operator new(sizeof(JArray) + bytes)) JArray;
+        // Primitive elements are zero values and reference elements are null
+        memset(array->elements<uint8_t>(), 0, bytes);
+        array->length = length;
+        array->type = type;
+        return array;
+    }
+    static void destroy(JArray* array) {
+        array->~JArray();
+        ::operator delete(array);
     }
 };
 //--------------------------------------------------------------------------------
-// The ObjectContainer manages object's fields data, the key also the
-// only way to identify an object is the offset, you can use offset to get
-// object's fields data, push a field data into objects which specified by
-// offset and place a new area to store object fields Here is the internal
-// construction:
+// The ObjectContainer manages objects, the key also the only way to identify an
+// object is the offset. Every object is a single allocation of its header and
+// fields, see JObject
 //
-// [1]  ->  [field_a, field_b, field_c]
-// [2]  ->  []
-// [3]  ->  [field_a,field_b]
-// [4]  ->  [field_a]
+// [1]  ->  [header | field_a, field_b, field_c]
+// [2]  ->  [header]
+// [3]  ->  [header | field_a,field_b]
+// [4]  ->  [header | field_a]
 // [..] ->  [...]
 //--------------------------------------------------------------------------------
-using InternalObject = vector<JType*>;
+using InternalObject = JObject*;
 struct ObjectContainer : public Container<InternalObject> {
     ~ObjectContainer() override {
-        for (auto intVecPair : getContainer()) {
-            for (auto ptr : intVecPair.second) {
-                delete ptr;
-            }
-        }
+        forEach([](size_t, InternalObject& object) { destroy(object); });
+    }
+
+    static JObject* create(const JavaClass& javaClass, size_t instanceSize) {
+        auto* object =
+            new (::operator new(sizeof(JObject) + instanceSize)) JObject;
+        // Primitive fields are zero values and reference fields are null
+        memset(object->fields(), 0, instanceSize);
+        object->jc = &javaClass;
+        return object;
+    }
+    static void destroy(JObject* object) {
+        object->~JObject();
+        ::operator delete(object);
     }
 };
 
 //--------------------------------------------------------------------------------
-// MonitorContainer manages synchronous block monitors as well as the
-// above
+// MonitorContainer manages synchronous block monitors. Monitor shares the same
+// offset with the object it belongs to, so it's a side table indexed by object
+// offset rather than a handle table of its own
 //
 // [1]  ->   ObjectMonitor*
-// [2]  ->   ObjectMonitor*
+// [2]  ->   nullptr
 // [3]  ->   ObjectMonitor*
-// [4]  ->   ObjectMonitor*
-// [..] ->   ObjectMonitor*// MonitorContainer manages synchronous block
-// monitors as well as the above
-//
-// [1]  ->   ObjectMonitor*
-// [2]  ->   ObjectMonitor*
-// [3]  ->   ObjectMonitor*
-// [4]  ->   ObjectMonitor*
-// [..] ->   ObjectMonitor*
+// [..] ->   ...
 //--------------------------------------------------------------------------------
 using InternalMonitor = ObjectMonitor*;
-struct MonitorContainer : public Container<InternalMonitor> {
-    ~MonitorContainer() override {
-        for (auto intMonitorPair : getContainer()) {
-            delete intMonitorPair.second;
+struct MonitorContainer {
+    ~MonitorContainer() {
+        for (auto monitor : monitors) {
+            delete monitor;
         }
     }
-    size_t place() override {
-        size_t lastOffset = 0;
-        if (!getContainer().empty()) {
-            lastOffset = (--getContainer().end())->first;
+
+    bool has(size_t offset) const {
+        return offset < monitors.size() && monitors[offset] != nullptr;
+    }
+    InternalMonitor find(size_t offset) { return monitors[offset]; }
+    void placeAt(size_t offset) {
+        if (offset >= monitors.size()) {
+            monitors.resize(offset + 1, nullptr);
+        }
+        if (monitors[offset] == nullptr) {
+            monitors[offset] = new ObjectMonitor();
         }
-        getContainer().insert(make_pair(lastOffset + 1, new ObjectMonitor()));
-        return lastOffset + 1;
     }
+    void remove(size_t offset) {
+        if (has(offset)) {
+            delete monitors[offset];
+            monitors[offset] = nullptr;
+        }
+    }
+    // Release monitor of every object for which reclaim(offset) returns true
+    template <typename Reclaim>
+    void sweep(Reclaim reclaim) {
+        for (size_t offset = 0; offset < monitors.size(); offset++) {
+            if (monitors[offset] != nullptr && reclaim(offset)) {
+                delete monitors[offset];
+                monitors[offset] = nullptr;
+            }
+        }
+    }
+
+private:
+    vector<InternalMonitor> monitors;
 };
 //--------------------------------------------------------------------------------
 // Java heap holds instance's fields data which object referred to and elements
@@ -165,58 +276,63 @@ public:
     JArray* createObjectArray(const JavaClass& jc, int length);
     JArray* createCharArray(const string& source, size_t length);
 
-    auto getFieldByName(const JavaClass* jc, const string& name,
-                        const string& descriptor, JObject* object) {
-        return getFieldByNameImpl(jc, object->jc, name, descriptor, object, 0);
-    }
+    JValue getFieldByName(const JavaClass* jc, const string& name,
+                          const string& descriptor, JObject* object);
     void putFieldByName(const JavaClass* jc, const string& name,
                         const string& descriptor, JObject* object,
-                        JType* value) {
-        putFieldByNameImpl(jc, object->jc, name, descriptor, object, value, 0);
-    }
-    void putFieldByOffset(const JObject& object, size_t fieldOffset,
-                          JType* value) {
-        lock_guard<recursive_mutex> lock(objMtx);
-        objectContainer.find(object.offset)[fieldOffset] = value;
-    }
-    auto getFieldByOffset(const JObject& object, size_t fieldOffset) {
-        lock_guard<recursive_mutex> lock(objMtx);
-        return objectContainer.find(object.offset)[fieldOffset];
+                        const JValue& value);
+
+    // Fields are read and written in place. Location of a field is resolved
+    // once and then cached in constant pool cache
+    JValue getField(const JObject& object, const InstanceField& field) {
+        return load(object.fields() + field.offset, field.type);
     }
-    auto getFields(JObject* object) {
-        lock_guard<recursive_mutex> lockMA(objMtx);
-        return objectContainer.find(object->offset);
+    void putField(const JObject& object, const InstanceField& field,
+                  const JValue& value) {
+        store(object.fields() + field.offset, field.type, value);
     }
+    // Slot of a field is given by JavaClass::getFieldSlot()
+    JValue getFieldBySlot(const JObject& object, size_t slot);
+    void putFieldBySlot(const JObject& object, size_t slot,
+                        const JValue& value);
 
-    void putElement(const JArray& array, size_t index, JType* value) {
-        lock_guard<recursive_mutex> lock(arrMtx);
-        arrayContainer.find(array.offset).second[index] = value;
-    }
-    auto getElement(const JArray& array, size_t index) {
-        lock_guard<recursive_mutex> lock(arrMtx);
-        return arrayContainer.find(array.offset).second[index];
+    // Elements are read and written in place according to element type of the
+    // array. Interpreter accesses elements of known type by JArray::elements()
+    // directly
+    JValue getElement(const JArray& array, size_t index) {
+        const size_t width = widthOf(array.type);
+        return load(array.elements<uint8_t>() + index * width, array.type);
     }
-    auto getElements(JArray* array) {
-        lock_guard<recursive_mutex> lockMA(arrMtx);
-        return arrayContainer.find(array->offset);
+    void putElement(const JArray& array, size_t index, const JValue& value) {
+        const size_t width = widthOf(array.type);
+        store(array.elements<uint8_t>() + index * width, array.type, value);
     }
 
     void removeArray(size_t offset) {
         lock_guard<recursive_mutex> lock(arrMtx);
-        arrayContainer.remove(offset);
+        if (arrayContainer.has(offset)) {
+            ArrayContainer::destroy(arrayContainer.find(offset));
+            arrayContainer.remove(offset);
+        }
     }
     void removeObject(size_t offset) {
         lock_guard<recursive_mutex> lock(objMtx);
-        objectContainer.remove(offset);
+        if (objectContainer.has(offset)) {
+            ObjectContainer::destroy(objectContainer.find(offset));
+            objectContainer.remove(offset);
+        }
+        // The offset will be recycled, don't let the next object inherit it
+        lock_guard<recursive_mutex> lockMonitor(monitorMtx);
+        monitorContainer.remove(offset);
     }
 
     bool hasMonitor(const JType* ref) {
         lock_guard<recursive_mutex> lock(monitorMtx);
         return monitorContainer.has(dynamic_cast<const JObject*>(ref)->offset);
     }
-    auto createMonitor() {
+    void createMonitor(const JType* ref) {
         lock_guard<recursive_mutex> lock(monitorMtx);
-        return monitorContainer.place();
+        monitorContainer.placeAt(dynamic_cast<const JObject*>(ref)->offset);
     }
     auto findMonitor(const JType* ref) {
         lock_guard<recursive_mutex> lock(monitorMtx);
@@ -224,18 +340,71 @@ public:
     }
 
 private:
-    void createSuperFields(const JavaClass& javaClass, const JObject* object);
+    static JValue load(const uint8_t* addr, char type) {
+        switch (type) {
+            case 'Z':
+                return JValue::of<JInt>(*addr);
+            case 'B':
+                return JValue::of<JInt>(*reinterpret_cast<const int8_t*>(addr));
+            case 'C':
+                return JValue::of<JInt>(
+                    *reinterpret_cast<const uint16_t*>(addr));
+            case 'S':
+                return JValue::of<JInt>(
+                    *reinterpret_cast<const int16_t*>(addr));
+            case 'I':
+                return JValue::of<JInt>(
+                    *reinterpret_cast<const int32_t*>(addr));
+            case 'F':
+                return JValue::of<JFloat>(
+                    *reinterpret_cast<const float*>(addr));
+            case 'J':
+                return JValue::of<JLong>(
+                    *reinterpret_cast<const int64_t*>(addr));
+            case 'D':
+                return JValue::of<JDouble>(
+                    *reinterpret_cast<const double*>(addr));
+            default:
+                return JValue::of<JRef>(*reinterpret_cast<JType* const*>(addr));
+        }
+    }
+    static void store(uint8_t* addr, char type, const JValue& value) {
+        switch (type) {
+            case 'Z':
+                *addr = static_cast<uint8_t>(value.i & 1);
+                break;
+            case 'B':
+                *reinterpret_cast<int8_t*>(addr) = static_cast<int8_t>(value.i);
+                break;
+            case 'C':
+                *reinterpret_cast<uint16_t*>(addr) =
+                    static_cast<uint16_t>(value.i);
+                break;
+            case 'S':
+                *reinterpret_cast<int16_t*>(addr) =
+                    static_cast<int16_t>(value.i);
+                break;
+            case 'I':
+                *reinterpret_cast<int32_t*>(addr) = value.i;
+                break;
+            case 'F':
+                *reinterpret_cast<float*>(addr) = value.f;
+                break;
+            case 'J':
+                *reinterpret_cast<int64_t*>(addr) = value.j;
+                break;
+            case 'D':
+                *reinterpret_cast<double*>(addr) = value.d;
+                break;
+            default:
+                *reinterpret_cast<JType**>(addr) = value.ref;
+                break;
+        }
+    }
 
-    JType* getFieldByNameImpl(const JavaClass* desireLookup,
-                              const JavaClass* currentLookup,
-                              const string& name, const string& descriptor,
-                              JObject* object, size_t offset = 0);
-    void putFieldByNameImpl(const JavaClass* desireLookup,
-                            const JavaClass* currentLookup, const string& name,
-                            const string& descriptor, JObject* object,
-                            JType* value, size_t offset = 0);
+    JArray* placeArray(char type, int length);
+    void notifyAllocation(size_t bytes);
 
-private:
     ObjectContainer objectContainer;
     ArrayContainer arrayContainer;
     MonitorContainer monitorContainer;
@@ -243,5 +412,8 @@ private:
     recursive_mutex objMtx;
     recursive_mutex arrMtx;
     recursive_mutex monitorMtx;
+
+    // Bytes allocated since last GC was requested
+    atomic<size_t> allocatedBytes{0};
 };
 #endif  // YVM_JAVAHEAP_H
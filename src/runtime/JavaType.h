@@ -63,20 +63,134 @@ struct JLong BASE_OF_JTYPE {
     int64_t val = 0L;
 };
 
+//--------------------------------------------------------------------------------
+// Fields and array elements are stored in place in their own width. Their type
+// is denoted by the first character of field descriptor, 'L' or '[' refers to
+// an object or an array
+//--------------------------------------------------------------------------------
+inline std::size_t widthOf(char type) {
+    switch (type) {
+        case 'B':
+        case 'Z':
+            return sizeof(int8_t);
+        case 'C':
+        case 'S':
+            return sizeof(int16_t);
+        case 'I':
+        case 'F':
+            return sizeof(int32_t);
+        case 'J':
+        case 'D':
+            return sizeof(int64_t);
+        default:
+            return sizeof(JType*);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Location of an instance field in objects. It's given by instance field layout
+// of the class, and fields of superclass keep their locations in subclasses
+//--------------------------------------------------------------------------------
+struct InstanceField {
+    uint32_t offset = 0;  // Byte offset from the beginning of object fields
+    char type = 0;        // First character of field descriptor
+};
+
+//--------------------------------------------------------------------------------
+// JObject is the header of a java object. Instance fields are packed right
+// after it in the same allocation, primitive fields are stored in their own
+// width and reference fields hold JObject/JArray directly. The offset
+// identifies object on java heap, it's also the key of the object's monitor
+//--------------------------------------------------------------------------------
 struct JObject BASE_OF_JTYPE {
     explicit JObject() = default;
+    JObject(const JObject&) = delete;
+    JObject& operator=(const JObject&) = delete;
+
+    uint8_t* fields() const {
+        return reinterpret_cast<uint8_t*>(const_cast<JObject*>(this) + 1);
+    }
 
     std::size_t offset = 0;  // Offset on java heap
     const JavaClass* jc{};   // Reference to meta java class
 };
 
+//--------------------------------------------------------------------------------
+// JArray is the header of a java array. Elements follow it contiguously in the
+// same allocation, elements of primitive arrays are stored in their own width
+// and elements of reference arrays hold JObject/JArray directly
+//--------------------------------------------------------------------------------
 struct JArray BASE_OF_JTYPE {
     explicit JArray() = default;
+    JArray(const JArray&) = delete;
+    JArray& operator=(const JArray&) = delete;
+
+    template <typename Type>
+    Type* elements() const {
+        return reinterpret_cast<Type*>(const_cast<JArray*>(this) + 1);
+    }
 
     int length = 0;          // Length of java array
+    char type = 0;           // Element type, see widthOf()
     std::size_t offset = 0;  // Offset on java heap
 };
 
+//--------------------------------------------------------------------------------
+// JValue is an unboxed value which lives in operand stack slots and local
+// variable slots. Primitive values are stored inline and distinguished by tag,
+// references still point to their heap handle(JObject/JArray). Loading,
+// storing and computing primitive values therefore never allocates memory.
+//--------------------------------------------------------------------------------
+enum class ValueTag : uint8_t { Empty, Int, Long, Float, Double, Ref };
+
+template <typename Type>
+struct ValueTraits;
+
+struct JValue {
+    template <typename Type>
+    static JValue of(typename ValueTraits<Type>::type val) {
+        JValue v;
+        ValueTraits<Type>::set(v, val);
+        return v;
+    }
+
+    template <typename Type>
+    typename ValueTraits<Type>::type as() const {
+        return ValueTraits<Type>::get(*this);
+    }
+
+    // Category 2 computational type occupies two local variable slots
+    bool isWide() const { return tag == ValueTag::Long || tag == ValueTag::Double; }
+
+    union {
+        int32_t i;
+        int64_t j = 0;
+        float f;
+        double d;
+        JType* ref;
+    };
+    ValueTag tag = ValueTag::Empty;
+};
+
+#define DEF_VALUE_TRAITS(jtype, ctype, member, valueTag)               \
+    template <>                                                        \
+    struct ValueTraits<jtype> {                                        \
+        using type = ctype;                                            \
+        static ctype get(const JValue& v) { return (ctype)v.member; }  \
+        static void set(JValue& v, ctype val) {                        \
+            v.member = val;                                            \
+            v.tag = valueTag;                                          \
+        }                                                              \
+    };
+
+DEF_VALUE_TRAITS(JInt, int32_t, i, ValueTag::Int)
+DEF_VALUE_TRAITS(JLong, int64_t, j, ValueTag::Long)
+DEF_VALUE_TRAITS(JFloat, float, f, ValueTag::Float)
+DEF_VALUE_TRAITS(JDouble, double, d, ValueTag::Double)
+DEF_VALUE_TRAITS(JRef, JType*, ref, ValueTag::Ref)
+DEF_VALUE_TRAITS(JObject, JObject*, ref, ValueTag::Ref)
+DEF_VALUE_TRAITS(JArray, JArray*, ref, ValueTag::Ref)
+
 #define IS_JINT(x) (typeid(*x) == typeid(JInt))
 #define IS_JLong(x) (typeid(*x) == typeid(JLong))
 #define IS_JDouble(x) (typeid(*x) == typeid(JDouble))
@@ -0,0 +1,357 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "MethodData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include "../classfile/AccessFlag.h"
+#include "../interpreter/AotRuntime.h"
+#include "../interpreter/DecodedCode.h"
+#include "../interpreter/Interpreter.hpp"
+#include "../interpreter/JitCompiler.h"
+#include "../interpreter/RegisterCode.h"
+#include "../misc/Utils.h"
+
+MethodData::MethodData(const MethodInfo* method, const char* name,
+                       const std::string& descriptor, const ATTR_Code* attr,
+                       NativeFunction nativeFunction)
+    : name(name), nativeFunction(nativeFunction) {
+    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
+    returnType = std::get<0>(parameterAndReturnType);
+    parameter = std::move(std::get<1>(parameterAndReturnType));
+    const bool hasThis = !IS_METHOD_STATIC(method->accessFlags);
+    argumentCount = static_cast<int>(parameter.size()) + (hasThis ? 1 : 0);
+    argumentSlots = countArgumentSlots(parameter, hasThis);
+
+    if (attr == nullptr) {
+        // Native methods get a frame that just holds their arguments
+        maxLocals = maxStack = static_cast<u2>(argumentSlots);
+        return;
+    }
+    code.reset(new u1[attr->codeLength]);
+    memcpy(code.get(), attr->code, attr->codeLength);
+    originalCode = attr->code;
+    codeLength = attr->codeLength;
+    maxLocals = attr->maxLocals;
+    maxStack = attr->maxStack;
+    exceptionTableLength = attr->exceptionTableLength;
+    exceptionTable = attr->exceptionTable;
+    analyzeCode();
+}
+
+MethodData::~MethodData() {
+    delete registerCode.load();
+    delete jitCode.load();
+}
+
+void MethodData::installInlinedCode(std::vector<u1> newCode, u2 newMaxLocals,
+                                    u2 newMaxStack,
+                                    std::vector<ExceptionTable> newTable) {
+    inlinedCode = std::move(newCode);
+    inlinedExceptionTable = std::move(newTable);
+    code.reset(new u1[inlinedCode.size()]);
+    memcpy(code.get(), inlinedCode.data(), inlinedCode.size());
+    originalCode = inlinedCode.data();
+    codeLength = static_cast<u4>(inlinedCode.size());
+    maxLocals = newMaxLocals;
+    maxStack = newMaxStack;
+    exceptionTableLength = static_cast<u2>(inlinedExceptionTable.size());
+    exceptionTable = inlinedExceptionTable.data();
+    analyzeCode();
+}
+
+// Read the value pushed by a constant instruction at pc, return false if it's
+// not one
+static bool readConstant(const u1* c, u4 pc, JValue& value) {
+    const u1 opcode = c[pc];
+    if (opcode == op_aconst_null) {
+        value = JValue::of<JRef>(nullptr);
+    } else if (opcode >= op_iconst_m1 && opcode <= op_iconst_5) {
+        value = JValue::of<JInt>(opcode - op_iconst_0);
+    } else if (opcode == op_lconst_0 || opcode == op_lconst_1) {
+        value = JValue::of<JLong>(opcode - op_lconst_0);
+    } else if (opcode >= op_fconst_0 && opcode <= op_fconst_2) {
+        value = JValue::of<JFloat>(static_cast<float>(opcode - op_fconst_0));
+    } else if (opcode == op_dconst_0 || opcode == op_dconst_1) {
+        value = JValue::of<JDouble>(opcode - op_dconst_0);
+    } else if (opcode == op_bipush) {
+        value = JValue::of<JInt>(static_cast<int8_t>(c[pc + 1]));
+    } else if (opcode == op_sipush) {
+        value = JValue::of<JInt>(
+            static_cast<int16_t>((c[pc + 1] << 8) | c[pc + 2]));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isValueReturn(u1 opcode) {
+    return opcode >= op_ireturn && opcode <= op_areturn;
+}
+
+static bool isLoadOfLocal1(u1 opcode) {
+    return opcode == op_iload_1 || opcode == op_lload_1 ||
+           opcode == op_fload_1 || opcode == op_dload_1 ||
+           opcode == op_aload_1;
+}
+
+//--------------------------------------------------------------------------------
+// Match the whole code against bodies of TrivialKind. Nothing but the shape
+// of code is checked here, a super constructor is only run trivially if the
+// constructors it reaches end at an empty one, which is known after they are
+// resolved. Bodies are matched on linked code since inlining may rewrite them
+//--------------------------------------------------------------------------------
+void MethodData::classifyTrivialMethod() {
+    trivialKind = TrivialKind::None;
+    const u1* c = originalCode;
+    u1 ops[4] = {};
+    u4 pcs[5] = {0};
+    int count = 0;
+    for (; count < 4 && pcs[count] < codeLength; count++) {
+        ops[count] = c[pcs[count]];
+        pcs[count + 1] = pcs[count] + instructionLength(c, pcs[count]);
+    }
+    if (count == 0 || pcs[count] != codeLength) {
+        return;
+    }
+
+    if (count == 1 && ops[0] == op_return) {
+        trivialKind = TrivialKind::Empty;
+    } else if (count == 2 && readConstant(c, 0, trivialConstant) &&
+               isValueReturn(ops[1])) {
+        trivialKind = TrivialKind::Constant;
+    } else if (count == 3 && ops[0] == op_aload_0 && ops[1] == op_getfield &&
+               isValueReturn(ops[2])) {
+        trivialKind = TrivialKind::Getter;
+    } else if (count == 4 && ops[0] == op_aload_0 &&
+               isLoadOfLocal1(ops[1]) && ops[2] == op_putfield &&
+               ops[3] == op_return && argumentCount >= 2) {
+        trivialKind = TrivialKind::Setter;
+    } else if (count == 3 && ops[0] == op_aload_0 &&
+               ops[1] == op_invokespecial && ops[2] == op_return &&
+               strcmp(name, "<init>") == 0) {
+        trivialKind = TrivialKind::SuperConstructor;
+    }
+    if (trivialKind == TrivialKind::Getter ||
+        trivialKind == TrivialKind::Setter ||
+        trivialKind == TrivialKind::SuperConstructor) {
+        const u4 pc = pcs[count - 2];
+        trivialIndex = static_cast<u2>((c[pc + 1] << 8) | c[pc + 2]);
+    }
+}
+
+// Find call sites and branches of code for their profiles, check if it can be
+// interpreted with stack caching, fuse superinstructions and then decode it
+void MethodData::analyzeCode() {
+    std::vector<u4> callSites;
+    std::vector<u4> branches;
+    for (u4 pc = 0; pc < codeLength;
+         pc += instructionLength(code.get(), pc)) {
+        const u1 opcode = code[pc];
+        if (opcode == op_invokevirtual || opcode == op_invokeinterface) {
+            callSites.push_back(pc);
+        } else if ((opcode >= op_ifeq && opcode <= op_if_acmpne) ||
+                   opcode == op_ifnull || opcode == op_ifnonnull) {
+            branches.push_back(pc);
+        }
+    }
+    inlineCacheCount = static_cast<u2>(callSites.size());
+    inlineCaches.reset(new InlineCache[inlineCacheCount]);
+    FOR_EACH(i, inlineCacheCount) { inlineCaches[i].pc = callSites[i]; }
+
+    branchProfileCount = static_cast<u2>(branches.size());
+    if (branchProfileCount != 0) {
+        branchProfiles.reset(new BranchProfile[branchProfileCount]);
+        branchProfileIndex.reset(new u2[codeLength]);
+        FOR_EACH(i, branchProfileCount) {
+            branchProfiles[i].pc = branches[i];
+            branchProfileIndex[branches[i]] = i;
+        }
+    }
+
+    stackCacheable = Interpreter::canCacheStack(originalCode, codeLength,
+                                                exceptionTableLength);
+    if (runtime.superinstructions) {
+        fuseSuperinstructions();
+    }
+    decodedCode.reset(new DecodedCode(originalCode, code.get(), codeLength));
+}
+
+static bool isIload(u1 opcode) {
+    return opcode == op_iload || (opcode >= op_iload_0 && opcode <= op_iload_3);
+}
+
+static bool isIstore(u1 opcode) {
+    return opcode == op_istore ||
+           (opcode >= op_istore_0 && opcode <= op_istore_3);
+}
+
+//--------------------------------------------------------------------------------
+// Find instruction sequences that have superinstructions and rewrite their
+// first opcodes. A sequence is skipped if an exception range begins or ends
+// inside it, or a handler begins inside it, since the instructions behind the
+// first one would never be seen by exception handling. Branches into the
+// middle of a sequence still execute the untouched instructions there
+//--------------------------------------------------------------------------------
+void MethodData::fuseSuperinstructions() {
+    const u1* c = originalCode;
+    u4 pc = 0;
+    while (pc < codeLength) {
+        // Opcodes and pcs of the instructions starting at pc
+        u1 ops[4] = {};
+        u4 pcs[5] = {pc};
+        int count = 0;
+        for (; count < 4 && pcs[count] < codeLength; count++) {
+            ops[count] = c[pcs[count]];
+            pcs[count + 1] = pcs[count] + instructionLength(c, pcs[count]);
+        }
+
+        u1 fused = 0;
+        int length = 0;
+        if (ops[0] == op_aload_0 && ops[1] == op_getfield) {
+            fused = op_aload_0_getfield;
+            length = 2;
+        } else if (isIload(ops[0]) && isIload(ops[1]) && ops[2] == op_iadd &&
+                   isIstore(ops[3])) {
+            fused = op_iload_iload_iadd_istore;
+            length = 4;
+        } else if (isIload(ops[0]) && ops[1] == op_bipush &&
+                   ops[2] == op_if_icmpge) {
+            fused = op_iload_bipush_if_icmpge;
+            length = 3;
+        } else if (ops[0] == op_iinc && ops[1] == op_goto) {
+            fused = op_iinc_goto;
+            length = 2;
+        }
+
+        if (fused != 0 && length <= count &&
+            !isInsideExceptionRange(pc, pcs[length])) {
+            code[pc] = fused;
+            pc = pcs[length];
+        } else {
+            pc = pcs[1];
+        }
+    }
+}
+
+bool MethodData::isInsideExceptionRange(u4 begin, u4 end) const {
+    FOR_EACH(i, exceptionTableLength) {
+        const ExceptionTable& e = exceptionTable[i];
+        for (u4 boundary : {e.startPC, e.endPC, e.handlerPC}) {
+            if (boundary > begin && boundary < end) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MethodData::quicken(u4 pc, u1 quickOpcode) {
+    reinterpret_cast<volatile u1*>(code.get())[pc] = quickOpcode;
+    decodedCode->quicken(pc, quickOpcode);
+}
+
+InlineCache* MethodData::getInlineCache(u4 pc) const {
+    InlineCache* begin = inlineCaches.get();
+    InlineCache* end = begin + inlineCacheCount;
+    InlineCache* cache = std::lower_bound(
+        begin, end, pc,
+        [](const InlineCache& ic, u4 pc) -> bool { return ic.pc < pc; });
+    return (cache != end && cache->pc == pc) ? cache : nullptr;
+}
+
+void MethodData::updateInlineCache(InlineCache* cache,
+                                   const JavaClass* receiverClass,
+                                   const CallSite& target) {
+    std::lock_guard<std::mutex> lock(inlineCacheLock);
+    if (cache->isMegamorphic()) {
+        return;
+    }
+    const int n = cache->count.load(std::memory_order_relaxed);
+    for (int i = 0; i < n; i++) {
+        if (cache->receivers[i] == receiverClass) {
+            // Another thread has already recorded it
+            return;
+        }
+    }
+    if (n == InlineCache::MAX_RECEIVERS) {
+        cache->megamorphic.store(true, std::memory_order_relaxed);
+        return;
+    }
+    cache->receivers[n] = receiverClass;
+    cache->targets[n] = target;
+    cache->count.store(n + 1, std::memory_order_release);
+}
+
+const RegisterCode* MethodData::translateRegisterCode(const JavaClass* jc) {
+    if (registerCodeRejected.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(registerCodeLock);
+    if (registerCode.load(std::memory_order_relaxed) == nullptr &&
+        !registerCodeRejected.load(std::memory_order_relaxed)) {
+        const RegisterCode* translated = RegisterCode::translate(jc, this);
+        if (translated != nullptr) {
+            registerCodeHotness.store(getHotness(), std::memory_order_relaxed);
+            registerCode.store(translated, std::memory_order_release);
+        } else {
+            registerCodeRejected.store(true, std::memory_order_relaxed);
+        }
+    }
+    return registerCode.load(std::memory_order_relaxed);
+}
+
+const JitCode* MethodData::compileRegisterCode() {
+    if (jitRejected.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    // Register code is translated under registerCodeLock and never replaced
+    std::lock_guard<std::mutex> lock(registerCodeLock);
+    if (jitCode.load(std::memory_order_relaxed) == nullptr &&
+        !jitRejected.load(std::memory_order_relaxed)) {
+        const JitCode* compiled =
+            JitCode::compile(*registerCode.load(std::memory_order_relaxed));
+        if (compiled != nullptr) {
+            jitCode.store(compiled, std::memory_order_release);
+        } else {
+            jitRejected.store(true, std::memory_order_relaxed);
+        }
+    }
+    return jitCode.load(std::memory_order_relaxed);
+}
+
+void MethodData::bindCompiledMethod(const AotMethod& method) {
+    if (method.codeLength != codeLength ||
+        method.codeHash != aotCodeHash(originalCode, codeLength)) {
+        return;
+    }
+    const RegisterCode* loaded = RegisterCode::load(method, this);
+    if (loaded == nullptr) {
+        return;
+    }
+    registerCode.store(loaded, std::memory_order_release);
+    jitCode.store(JitCode::precompiled(method.entry),
+                  std::memory_order_release);
+}
@@ -0,0 +1,314 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef YVM_METHODDATA_H
+#define YVM_METHODDATA_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../classfile/ClassFile.h"
+#include "../interpreter/CallSite.h"
+#include "JavaType.h"
+
+class JavaClass;
+struct AotMethod;
+class DecodedCode;
+class RegisterCode;
+class JitCode;
+struct RuntimeEnv;
+
+using NativeFunction = JValue (*)(RuntimeEnv*, JValue*, int);
+
+// Profile counters are not updated atomically, they are approximate under
+// contention but counting never synchronizes threads
+template <typename T>
+inline void bumpCounter(std::atomic<T>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------
+// InlineCache remembers methods selected by an invokevirtual/invokeinterface
+// instruction for the receiver classes it has seen. It starts monomorphic,
+// becomes polymorphic when more receiver classes show up and turns
+// megamorphic once there are more than MAX_RECEIVERS, after that selection
+// always goes through vtables. Entries are only appended under the lock of
+// MethodData and published by count, so lookups are lock free. Hits of each
+// receiver class make up the receiver type profile of the call site
+//--------------------------------------------------------------------------------
+struct InlineCache {
+    static constexpr int MAX_RECEIVERS = 4;
+
+    const CallSite* lookup(const JavaClass* receiverClass) {
+        const int n = count.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) {
+            if (receivers[i] == receiverClass) {
+                bumpCounter(receiverHits[i]);
+                return &targets[i];
+            }
+        }
+        bumpCounter(isMegamorphic() ? megamorphicCalls : misses);
+        return nullptr;
+    }
+
+    bool isMegamorphic() const {
+        return megamorphic.load(std::memory_order_relaxed);
+    }
+
+    int receiverCount() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    uint64_t hits() const {
+        uint64_t total = 0;
+        for (const auto& receiverHit : receiverHits) {
+            total += receiverHit.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    u4 pc = 0;
+    std::atomic<int> count{0};
+    std::atomic<bool> megamorphic{false};
+    const JavaClass* receivers[MAX_RECEIVERS]{};
+    CallSite targets[MAX_RECEIVERS];
+
+    std::atomic<uint64_t> receiverHits[MAX_RECEIVERS] = {};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> megamorphicCalls{0};
+};
+
+//--------------------------------------------------------------------------------
+// BranchProfile counts how often a conditional branch of bytecode jumped to
+// its target and how often it fell through
+//--------------------------------------------------------------------------------
+struct BranchProfile {
+    u4 pc = 0;
+    std::atomic<uint64_t> taken{0};
+    std::atomic<uint64_t> notTaken{0};
+};
+
+//--------------------------------------------------------------------------------
+// Method bodies simple enough to be run by their invokers in the invoking
+// frame, see MethodData::classifyTrivialMethod(). Operands are the arguments
+//--------------------------------------------------------------------------------
+enum class TrivialKind : u1 {
+    None,
+    // return
+    Empty,
+    // aload_0; getfield; <x>return
+    Getter,
+    // aload_0; <x>load_1; putfield; return
+    Setter,
+    // <push constant>; <x>return
+    Constant,
+    // aload_0; invokespecial <init>; return
+    SuperConstructor
+};
+
+//--------------------------------------------------------------------------------
+// MethodData holds runtime states of a method which should not be kept in raw
+// class file structures. The interpreter executes its private code copy, so
+// instructions can be rewritten into quick ones without touching ATTR_Code.
+// Everything an invocation needs is computed here once when the class is
+// parsed, so that calling a method neither looks up attributes nor parses
+// its descriptor. Every method has one, native and abstract methods simply
+// have no code
+//--------------------------------------------------------------------------------
+class MethodData {
+public:
+    explicit MethodData(const MethodInfo* method, const char* name,
+                        const std::string& descriptor, const ATTR_Code* attr,
+                        NativeFunction nativeFunction);
+    ~MethodData();
+
+    // Name of method, it lives in constant pool of its class
+    const char* getName() const { return name; }
+
+    u1* getCode() const { return code.get(); }
+    const u1* getOriginalCode() const { return originalCode; }
+    u4 getCodeLength() const { return codeLength; }
+    u2 getMaxLocals() const { return maxLocals; }
+    u2 getMaxStack() const { return maxStack; }
+    u2 getExceptionTableLength() const { return exceptionTableLength; }
+    ExceptionTable* getExceptionTable() const { return exceptionTable; }
+
+    // Argument kinds and return kind in T_* form, see
+    // peelMethodParameterAndType()
+    const std::vector<int>& getParameter() const { return parameter; }
+    int getReturnType() const { return returnType; }
+    // Operand stack values taken by arguments, including this
+    int getArgumentCount() const { return argumentCount; }
+    // Local variable slots taken by arguments, including this. It's larger
+    // than getArgumentCount() if there are long or double arguments
+    int getArgumentSlots() const { return argumentSlots; }
+
+    // Registered implementation of native method, or nullptr
+    NativeFunction getNativeFunction() const { return nativeFunction; }
+
+    // Rewrite the instruction at pc into quickOpcode, in both code and its
+    // decoded form. Operand of the quick instruction must have been resolved
+    // into constant pool cache, and its operands are the same as the original
+    // instruction, so a thread still running the slow version is not affected
+    void quicken(u4 pc, u1 quickOpcode);
+
+    // Code decoded into fixed width instructions, see DecodedCode
+    const DecodedCode* getDecodedCode() const { return decodedCode.get(); }
+
+    // Inline cache of invokevirtual/invokeinterface instruction at pc
+    InlineCache* getInlineCache(u4 pc) const;
+    // Record target selected for receiverClass into inline cache
+    void updateInlineCache(InlineCache* cache, const JavaClass* receiverClass,
+                           const CallSite& target);
+
+    u2 getInlineCacheCount() const { return inlineCacheCount; }
+    const InlineCache& getInlineCacheAt(u2 i) const { return inlineCaches[i]; }
+
+    // Profile of the method, every tier counts invocations and backward
+    // branches it takes. Branches are profiled by bytecode
+    void countInvocation() { bumpCounter(invocationCount); }
+    void countBackedge() { bumpCounter(backedgeCount); }
+    uint64_t getInvocationCount() const {
+        return invocationCount.load(std::memory_order_relaxed);
+    }
+    uint64_t getBackedgeCount() const {
+        return backedgeCount.load(std::memory_order_relaxed);
+    }
+    // Invocations plus backward branches, TierPolicy promotes methods by it
+    uint64_t getHotness() const {
+        return getInvocationCount() + getBackedgeCount();
+    }
+
+    // Record whether the conditional branch at pc jumped
+    void profileBranch(u4 pc, bool taken) {
+        BranchProfile& profile = branchProfiles[branchProfileIndex[pc]];
+        bumpCounter(taken ? profile.taken : profile.notTaken);
+    }
+
+    u2 getBranchProfileCount() const { return branchProfileCount; }
+    const BranchProfile& getBranchProfileAt(u2 i) const {
+        return branchProfiles[i];
+    }
+
+    // Register code translated from code, or nullptr if method is not hot
+    // yet or can not be translated
+    const RegisterCode* getRegisterCode() const {
+        return registerCode.load(std::memory_order_acquire);
+    }
+    // Translate code into register code unless it was tried before, return
+    // nullptr if it can not be translated
+    const RegisterCode* translateRegisterCode(const JavaClass* jc);
+    // Hotness when register code was installed
+    uint64_t getRegisterCodeHotness() const {
+        return registerCodeHotness.load(std::memory_order_relaxed);
+    }
+
+    // Machine code compiled from register code, or nullptr
+    const JitCode* getJitCode() const {
+        return jitCode.load(std::memory_order_acquire);
+    }
+    // Compile register code into machine code unless it was tried before,
+    // return nullptr if it can not be compiled
+    const JitCode* compileRegisterCode();
+
+    // Run method as code compiled ahead of time by yvmc from now on. Nothing
+    // changes if it was compiled from a different version of the method
+    void bindCompiledMethod(const AotMethod& method);
+
+    // Whether code can be interpreted with stack caching
+    bool isStackCacheable() const { return stackCacheable; }
+
+    // Replace code with the version BytecodeInliner spliced callees into.
+    // It's done when the class is linked, before any CallSite of the method
+    // copied its code and frame size
+    void installInlinedCode(std::vector<u1> newCode, u2 newMaxLocals,
+                            u2 newMaxStack,
+                            std::vector<ExceptionTable> newTable);
+
+    // Recognize a trivial body of the linked code, see TrivialKind
+    void classifyTrivialMethod();
+    TrivialKind getTrivialKind() const { return trivialKind; }
+    // Constant pool index of the field a getter or setter accesses, or of
+    // the constructor a super constructor calls
+    u2 getTrivialIndex() const { return trivialIndex; }
+    // Value returned by a constant method
+    const JValue& getTrivialConstant() const { return trivialConstant; }
+
+private:
+    void analyzeCode();
+    void fuseSuperinstructions();
+    bool isInsideExceptionRange(u4 begin, u4 end) const;
+
+private:
+    const char* name;
+    std::unique_ptr<u1[]> code;
+    // Code in ATTR_Code or in inlinedCode, it's never rewritten
+    const u1* originalCode = nullptr;
+    u4 codeLength = 0;
+    u2 maxLocals = 0;
+    u2 maxStack = 0;
+    u2 exceptionTableLength = 0;
+    ExceptionTable* exceptionTable = nullptr;
+    // Code and exception table of method after inlining, see
+    // installInlinedCode()
+    std::vector<u1> inlinedCode;
+    std::vector<ExceptionTable> inlinedExceptionTable;
+
+    std::unique_ptr<DecodedCode> decodedCode;
+
+    std::vector<int> parameter;
+    int returnType = 0;
+    int argumentCount = 0;
+    int argumentSlots = 0;
+    NativeFunction nativeFunction = nullptr;
+
+    bool stackCacheable = false;
+    TrivialKind trivialKind = TrivialKind::None;
+    u2 trivialIndex = 0;
+    JValue trivialConstant;
+
+    // Sorted by pc
+    std::unique_ptr<InlineCache[]> inlineCaches;
+    u2 inlineCacheCount = 0;
+    std::mutex inlineCacheLock;
+
+    std::atomic<uint64_t> invocationCount{0};
+    std::atomic<uint64_t> backedgeCount{0};
+    // Sorted by pc, branchProfileIndex maps pc of a branch into it
+    std::unique_ptr<BranchProfile[]> branchProfiles;
+    std::unique_ptr<u2[]> branchProfileIndex;
+    u2 branchProfileCount = 0;
+
+    std::atomic<const RegisterCode*> registerCode{nullptr};
+    std::atomic<bool> registerCodeRejected{false};
+    std::atomic<uint64_t> registerCodeHotness{0};
+    std::mutex registerCodeLock;
+
+    std::atomic<const JitCode*> jitCode{nullptr};
+    std::atomic<bool> jitRejected{false};
+};
+
+#endif  // YVM_METHODDATA_H
@@ -24,6 +24,8 @@
 #include "RuntimeEnv.h"
 
 #include "../gc/GC.h"
+#include "../interpreter/TierPolicy.h"
+#include "../misc/Option.h"
 #include "ClassSpace.h"
 #include "JavaHeap.hpp"
 
@@ -32,9 +34,19 @@ RuntimeEnv runtime; // yvm runtime
 RuntimeEnv::RuntimeEnv() {
     heap = new JavaHeap;
     gc = new ConcurrentGC;
+    maxFrameDepth = YVM_MAX_FRAME_DEPTH;
+    printInlineCaches = false;
+    superinstructions = true;
+    inlining = true;
+    printInlining = false;
+    trivialMethods = true;
+    stackCaching = false;
+    tierPolicy = new TierPolicy;
+    printHotMethods = 0;
 }
 
 RuntimeEnv::~RuntimeEnv() {
     delete cs;
     delete heap;
+    delete tierPolicy;
 }
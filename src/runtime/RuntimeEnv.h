@@ -24,14 +24,18 @@
 #ifndef YVM_YRUNTIME_H
 #define YVM_YRUNTIME_H
 
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 
+struct AotMethod;
 struct JType;
+struct JValue;
 class JavaFrame;
 class JavaHeap;
 class ClassSpace;
 class ConcurrentGC;
+class TierPolicy;
 
 struct RuntimeEnv {
     RuntimeEnv();
@@ -39,9 +43,26 @@ struct RuntimeEnv {
 
     ClassSpace* cs;
     JavaHeap* heap;
-    std::unordered_map<std::string, JType* (*)(RuntimeEnv* env, JType**,int)>
+    std::unordered_map<std::string, JValue (*)(RuntimeEnv* env, JValue*, int)>
         nativeMethods;
+    // Methods of the library compiled by yvmc, keyed like nativeMethods
+    std::unordered_map<std::string, const AotMethod*> compiledMethods;
     ConcurrentGC* gc;
+    size_t maxFrameDepth;
+    bool printInlineCaches;
+    bool superinstructions;
+    // Inline small callees when classes are linked, and report them
+    bool inlining;
+    bool printInlining;
+    // Run accessors, empty and constant methods in frames of their invokers
+    bool trivialMethods;
+    // Interpret bytecode with the top of operand stack in machine registers
+    bool stackCaching;
+    // Decides when methods are translated into register code and compiled
+    // into machine code
+    TierPolicy* tierPolicy;
+    // Number of the hottest methods to dump on exit, 0 dumps nothing
+    size_t printHotMethods;
 };
 
 extern RuntimeEnv runtime;
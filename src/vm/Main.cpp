@@ -21,28 +21,164 @@
 // SOFTWARE.
 //
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include "../interpreter/TierPolicy.h"
+#include "../misc/Option.h"
+#include "../runtime/JavaFrame.hpp"
 #include "YVM.h"
 
+static void printUsage() {
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  yvm --lib=<path> [options] <main_class>" << std::endl;
+    std::cout << std::endl;
+    std::cout << "      --lib=<path>     Tells YVM where to find JDK classes(java.lang.String, etc)" << std::endl;
+    std::cout << "      <main_class>     The full qualified Java class name, e.g. org.example.Foo" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "      --max-stack-depth=<n>  Maximum frames of a java thread before StackOverflowError" << std::endl;
+    std::cout << "      --print-inline-caches  Dump inline cache counters of call sites on exit" << std::endl;
+    std::cout << "      --no-superinstructions Interpret bytecode without fusing frequent sequences" << std::endl;
+    std::cout << "      --no-inlining          Keep calls to small methods instead of inlining them when classes are linked" << std::endl;
+    std::cout << "      --print-inlining       Report call sites inlined when classes are linked" << std::endl;
+    std::cout << "      --no-trivial-methods   Push frames for accessors, empty and constant methods as well" << std::endl;
+    std::cout << "      --stack-caching        Interpret bytecode with the top of operand stack cached in registers" << std::endl;
+    std::cout << "      --register-code-threshold=<n>" << std::endl;
+    std::cout << "                             Invocations and loop iterations before a method runs as register code, 0 disables it" << std::endl;
+    std::cout << "      --jit-threshold=<n>    Invocations and loop iterations of register code before it's compiled" << std::endl;
+    std::cout << "      --osr-threshold=<n>    Loop iterations of bytecode before a running loop continues as register code, 0 disables it" << std::endl;
+    std::cout << "      --int                  Interpret every method, never compile them into machine code" << std::endl;
+    std::cout << "      --print-hot-methods[=<n>]" << std::endl;
+    std::cout << "                             Dump profile of the n hottest methods on exit, 20 by default" << std::endl;
+    std::cout << "      --aot=<library>        Run methods compiled by yvmc in the shared object, it's ignored by --int" << std::endl;
+}
+
+// Shared object built from source generated by yvmc
+static std::string compiledLibrary;
+
+// Apply an option to runtime, return false if it's not recognized
+static bool parseOption(const char* arg) {
+    if (strstr(arg, "--max-stack-depth=") == arg) {
+        char* end = nullptr;
+        const char* value = arg + strlen("--max-stack-depth=");
+        long depth = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || depth <= 0) {
+            return false;
+        }
+        runtime.maxFrameDepth = static_cast<size_t>(depth);
+        return true;
+    }
+    if (strcmp(arg, "--print-inline-caches") == 0) {
+        runtime.printInlineCaches = true;
+        return true;
+    }
+    if (strcmp(arg, "--no-superinstructions") == 0) {
+        runtime.superinstructions = false;
+        return true;
+    }
+    if (strcmp(arg, "--no-inlining") == 0) {
+        runtime.inlining = false;
+        return true;
+    }
+    if (strcmp(arg, "--print-inlining") == 0) {
+        runtime.printInlining = true;
+        return true;
+    }
+    if (strcmp(arg, "--no-trivial-methods") == 0) {
+        runtime.trivialMethods = false;
+        return true;
+    }
+    if (strcmp(arg, "--stack-caching") == 0) {
+        runtime.stackCaching = true;
+        return true;
+    }
+    if (strstr(arg, "--register-code-threshold=") == arg) {
+        char* end = nullptr;
+        const char* value = arg + strlen("--register-code-threshold=");
+        long threshold = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || threshold < 0) {
+            return false;
+        }
+        runtime.tierPolicy->registerCodeThreshold = threshold;
+        return true;
+    }
+    if (strstr(arg, "--jit-threshold=") == arg) {
+        char* end = nullptr;
+        const char* value = arg + strlen("--jit-threshold=");
+        long threshold = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || threshold < 0) {
+            return false;
+        }
+        runtime.tierPolicy->jitThreshold = threshold;
+        return true;
+    }
+    if (strstr(arg, "--osr-threshold=") == arg) {
+        char* end = nullptr;
+        const char* value = arg + strlen("--osr-threshold=");
+        long threshold = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || threshold < 0) {
+            return false;
+        }
+        runtime.tierPolicy->osrThreshold = threshold;
+        return true;
+    }
+    if (strcmp(arg, "--int") == 0) {
+        runtime.tierPolicy->interpretOnly = true;
+        return true;
+    }
+    if (strcmp(arg, "--print-hot-methods") == 0) {
+        runtime.printHotMethods = YVM_HOT_METHODS;
+        return true;
+    }
+    if (strstr(arg, "--print-hot-methods=") == arg) {
+        char* end = nullptr;
+        const char* value = arg + strlen("--print-hot-methods=");
+        long count = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || count <= 0) {
+            return false;
+        }
+        runtime.printHotMethods = static_cast<size_t>(count);
+        return true;
+    }
+    if (strstr(arg, "--aot=") == arg && arg[strlen("--aot=")] != '\0') {
+        compiledLibrary = arg + strlen("--aot=");
+        return true;
+    }
+    return false;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3 || strstr(argv[1], "--lib") == NULL) {
-        std::cout << "Usage:" << std::endl;
-        std::cout << "  yvm --lib=<path> <main_class>" << std::endl;
-        std::cout << std::endl;
-        std::cout << "      --lib=<path>     Tells YVM where to find JDK classes(java.lang.String, etc)" << std::endl;
-        std::cout << "      <main_class>     The full qualified Java class name, e.g. org.example.Foo" << std::endl;
+    if (argc < 3 || strstr(argv[1], "--lib") == NULL) {
+        printUsage();
         return 0;
     }
+    for (int i = 2; i < argc - 1; i++) {
+        if (!parseOption(argv[i])) {
+            std::cout << "Unrecognized option " << argv[i] << std::endl;
+            printUsage();
+            return 0;
+        }
+    }
 
     std::string libs = argv[1] + strlen("--lib=");
     YVM::initialize(libs);
-    std::string mainClass = argv[2];
+    if (!compiledLibrary.empty() && !runtime.tierPolicy->interpretOnly &&
+        !YVM::loadCompiledMethods(compiledLibrary)) {
+        return 1;
+    }
+    std::string mainClass = argv[argc - 1];
     for (auto& c : mainClass) {
         if (c == '.') {
             c = '/';
         }
     }
-    YVM::callMain(mainClass);
+    try {
+        YVM::callMain(mainClass);
+    } catch (const StackOverflowError& e) {
+        std::cerr << "Exception in thread \"main\" " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
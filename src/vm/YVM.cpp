@@ -24,6 +24,7 @@
 #include "YVM.h"
 
 #include "../gc/GC.h"
+#include "../interpreter/AotRuntime.h"
 #include "../misc/Debug.h"
 #include "../misc/NativeMethod.h"
 #include "../misc/Option.h"
@@ -33,6 +34,9 @@
 #include "../runtime/JavaHeap.hpp"
 #include "../runtime/RuntimeEnv.h"
 
+#include <dlfcn.h>
+#include <chrono>
+
 YVM::ExecutorThreadPool YVM::executor;
 
 #define FORCE(x) (reinterpret_cast<char*>(x))
@@ -72,6 +76,9 @@ YVM::YVM() {
 // virtual machine after main method executing accomplished
 void YVM::callMain(const std::string& name) {
     executor.initialize(1);
+#ifdef YVM_DISPATCH_STATS
+    auto startTime = std::chrono::steady_clock::now();
+#endif
 
     std::future<void> mainFuture = executor.submit([=]() -> void {
 #ifdef YVM_DEBUG_SHOW_THREAD_NAME
@@ -93,6 +100,24 @@ void YVM::callMain(const std::string& name) {
     // Block until main thread accomplished;
     mainFuture.get();
 
+#ifdef YVM_DISPATCH_STATS
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - startTime;
+    Inspector::printDispatchStats(Interpreter::dispatchMode(),
+                                  Interpreter::totalDispatched,
+                                  elapsed.count());
+#endif
+#ifdef YVM_LOOKUP_STATS
+    Inspector::printMethodLookupStats(JavaClass::methodLookups,
+                                      JavaClass::methodLookupCompares);
+#endif
+    if (runtime.printInlineCaches) {
+        Inspector::printInlineCaches(*runtime.cs);
+    }
+    if (runtime.printHotMethods != 0) {
+        Inspector::printHotMethods(*runtime.cs, runtime.printHotMethods);
+    }
+
     // Close garbage collection. This is optional since operation system would
     // release all resources when process exited
     runtime.gc->terminateGC();
@@ -107,9 +132,34 @@ void YVM::initialize(const std::string& libPath) {
         registerNativeMethod(
             nativeFunctionTable[i][0], nativeFunctionTable[i][1],
             nativeFunctionTable[i][2],
-            reinterpret_cast<JType* (*)(RuntimeEnv*, JType**, int)>(
+            reinterpret_cast<JValue (*)(RuntimeEnv*, JValue*, int)>(
                 const_cast<char*>(nativeFunctionTable[i][3])));
     }
 
     runtime.cs = new ClassSpace(libPath);
 }
+
+// Load a shared object built from source generated by yvmc. Its methods are
+// bound when their classes are parsed, so it must be loaded before any class
+bool YVM::loadCompiledMethods(const std::string& library) {
+    void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        std::cerr << "Can not load " << library << ": " << dlerror()
+                  << std::endl;
+        return false;
+    }
+    const auto* methods =
+        static_cast<const AotMethod*>(dlsym(handle, YVM_AOT_METHODS));
+    if (methods == nullptr) {
+        std::cerr << library << " is not generated by yvmc" << std::endl;
+        dlclose(handle);
+        return false;
+    }
+    for (; methods->className != nullptr; methods++) {
+        runtime.compiledMethods.insert(std::make_pair(
+            std::string(methods->className) + "." + methods->name + "." +
+                methods->descriptor,
+            methods));
+    }
+    return true;
+}
@@ -35,6 +35,7 @@ struct YVM {
 
     static void callMain(const std::string& name);
     static void initialize(const std::string& libPath);
+    static bool loadCompiledMethods(const std::string& library);
 
     class ExecutorThreadPool : public ThreadPool {
     public:
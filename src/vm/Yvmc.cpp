@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "../interpreter/AotCompiler.h"
+
+static void printUsage() {
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  yvmc -o <output.cpp> <class_file>..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "      -o <output.cpp>  C++ source to generate, build it into a shared object against src/ and pass it to yvm --aot" << std::endl;
+    std::cout << "      <class_file>     Class files whose methods are compiled, methods yvmc can not compile stay interpreted" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || strcmp(argv[1], "-o") != 0) {
+        printUsage();
+        return 0;
+    }
+    std::ofstream out(argv[2]);
+    if (!out.is_open()) {
+        std::cerr << "Can not write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    AotCompiler compiler(out);
+    for (int i = 3; i < argc; i++) {
+        if (compiler.compileClassFile(argv[i]) < 0) {
+            std::cerr << "Can not read class file " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    compiler.finish();
+    std::cout << "Compiled " << compiler.getMethodCount() << " methods into "
+              << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,26 @@
+# Run a test program with OPTIONS and again with REFERENCE_OPTIONS. Both runs
+# must succeed, and print the same output unless COMPARE_OUTPUT is OFF
+#
+#   cmake -DYVM=<yvm> -DLIB=<path> -DMAIN_CLASS=<class> -DOPTIONS=<options>
+#         -DREFERENCE_OPTIONS=<options> [-DCOMPARE_OUTPUT=OFF]
+#         -P CompareOutput.cmake
+if(NOT DEFINED COMPARE_OUTPUT)
+    set(COMPARE_OUTPUT ON)
+endif()
+
+function(run_yvm options output)
+    separate_arguments(options)
+    execute_process(COMMAND ${YVM} --lib=${LIB} ${options} ${MAIN_CLASS}
+        OUTPUT_VARIABLE stdout ERROR_VARIABLE stdout RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "yvm ${options} ${MAIN_CLASS} failed with ${result}\n${stdout}")
+    endif()
+    set(${output} "${stdout}" PARENT_SCOPE)
+endfunction()
+
+run_yvm("${OPTIONS}" actual)
+run_yvm("${REFERENCE_OPTIONS}" expected)
+if(COMPARE_OUTPUT AND NOT actual STREQUAL expected)
+    message(FATAL_ERROR "Output with ${OPTIONS} differs from output with ${REFERENCE_OPTIONS}\n"
+        "--- ${OPTIONS}\n${actual}\n--- ${REFERENCE_OPTIONS}\n${expected}")
+endif()
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Compare bytecodes per second of threaded and switch dispatching on ydk.test
+# programs. Run it from tool directory after bytecode was compiled.
+ROOT=$(cd .. && pwd)
+for mode in OFF ON; do
+    BUILD="$ROOT/build-dispatch-$mode"
+    cmake -S "$ROOT" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release \
+        -DYVM_DISPATCH_STATS=ON -DYVM_SWITCH_DISPATCH=$mode > /dev/null &&
+        cmake --build "$BUILD" > /dev/null 2>&1 || exit 1
+    for test in "$ROOT"/javaclass/ydk/test/*.java; do
+        name=$(basename "$test" .java)
+        printf "%-32s" "$name"
+        "$BUILD/yvm" --lib="$ROOT/bytecode" "ydk.test.$name" 2>&1 >/dev/null |
+            grep "dispatch\]"
+    done
+done
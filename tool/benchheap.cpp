@@ -0,0 +1,131 @@
+// MIT License
+//
+// Copyright (c) 2017 Yi Yang <kelthuzadx@qq.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------
+// Heap microbenchmarks. They compare the handle table behind JavaHeap against
+// the std::map based container it replaced on the operations the interpreter
+// and GC perform: placing new objects, looking up fields by offset, recycling
+// removed offsets and sweeping the whole heap. Build it by
+//
+//      cmake --build <build-dir> --target benchheap
+//--------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include "runtime/JavaHeap.hpp"
+
+using namespace std;
+
+namespace {
+
+// Container of java heap before handle table was introduced
+template <typename Type>
+struct MapContainer {
+    size_t place() {
+        size_t lastOffset = data.empty() ? 0 : (--data.end())->first;
+        data.insert(make_pair(lastOffset + 1, Type{}));
+        return lastOffset + 1;
+    }
+    void remove(size_t offset) { data.erase(offset); }
+    Type& find(size_t offset) { return data.find(offset)->second; }
+    template <typename Reclaim>
+    void sweep(Reclaim reclaim) {
+        for (auto pos = data.begin(); pos != data.end();) {
+            if (reclaim(pos->first, pos->second)) {
+                data.erase(pos++);
+            } else {
+                ++pos;
+            }
+        }
+    }
+
+    map<size_t, Type> data;
+};
+
+// Array payload of the map-backed heap, a length and an element vector
+using Payload = pair<size_t, JType**>;
+
+constexpr size_t HeapSize = 1000000;
+constexpr size_t LookupTimes = 20000000;
+
+template <typename Func>
+double measure(size_t ops, Func func) {
+    auto startTime = chrono::steady_clock::now();
+    func();
+    chrono::duration<double, nano> elapsed =
+        chrono::steady_clock::now() - startTime;
+    return elapsed.count() / ops;
+}
+
+template <typename Heap>
+void bench(const char* name) {
+    Heap heap;
+    vector<size_t> offsets(HeapSize);
+    mt19937 gen(HeapSize);
+    size_t checksum = 0;
+
+    double place = measure(HeapSize, [&]() {
+        for (size_t i = 0; i < HeapSize; i++) {
+            offsets[i] = heap.place();
+            heap.find(offsets[i]).first = i;
+        }
+    });
+
+    vector<size_t> lookups(LookupTimes);
+    for (auto& offset : lookups) {
+        offset = offsets[gen() % HeapSize];
+    }
+    double find = measure(LookupTimes, [&]() {
+        for (auto offset : lookups) {
+            checksum += heap.find(offset).first;
+        }
+    });
+
+    // Objects die young, drop every other one and allocate the same amount
+    double recycle = measure(HeapSize, [&]() {
+        for (size_t i = 0; i < HeapSize; i += 2) {
+            heap.remove(offsets[i]);
+        }
+        for (size_t i = 0; i < HeapSize; i += 2) {
+            offsets[i] = heap.place();
+        }
+    });
+
+    double sweep = measure(HeapSize, [&]() {
+        heap.sweep([](size_t offset, Payload&) { return offset % 3; });
+    });
+
+    printf("%-14s%10.1f%10.1f%10.1f%10.1f  (%zu)\n", name, place, find,
+           recycle, sweep, checksum);
+}
+
+}  // namespace
+
+int main() {
+    printf("ns/op         %10s%10s%10s%10s\n", "place", "find", "recycle",
+           "sweep");
+    bench<MapContainer<Payload>>("std::map");
+    bench<Container<Payload>>("handle table");
+    return 0;
+}